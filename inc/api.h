@@ -76,7 +76,9 @@ struct PassTwoFlags
 	// an interactive session or eval() may have undefined symbols,
 	// need to throw a RuntimeException on these and not an ICE
 	bool interactive;
-	PassTwoFlags() : interactive( false ) {}
+	// run the optimizer (constant folding, dead-code removal) on the code
+	bool optimize;
+	PassTwoFlags() : interactive( false ), optimize( false ) {}
 };
 
 struct PassOneReturnValue
@@ -101,6 +101,12 @@ void do_is_native_module( Frame* f );
 void do_vector_of( Frame* f );
 void do_raise( Frame* f );
 void do_dir( Frame* f );
+void do_buffer( Frame* f );
+void do_is_buffer( Frame* f );
+void do_readbuffer( Frame* f );
+void do_stringbuilder( Frame* f );
+void do_is_stringbuilder( Frame* f );
+void do_evalstats( Frame* f );
 
 extern const string builtin_names[];
 // ...and function pointers to the executor functions for them
@@ -108,6 +114,10 @@ extern NativeFunction builtin_fcns[];
 extern Object builtin_fcn_objs[];
 extern const int num_of_builtins;
 
+// get the start, end and step of a range from the (1-3) arguments to 'range',
+// checked as 'range' checks them (for the counting 'for' loop op too)
+void GetRangeArgs( Object* args[], int num_args, int & start, int & end, int & step );
+
 // is a given name a builtin function?
 bool IsBuiltin( const string & name );
 NativeFunction GetBuiltin( const string & name );
@@ -66,14 +66,22 @@ public:
 	void ExpectTypes( Object* obj, ObjectType t1, ObjectType t2, ObjectType t3 );
 	void ExpectTypes( Object* obj, ObjectType t1, ObjectType t2, ObjectType t3, ObjectType t4 );
 	void ExpectTypes( Object* obj, ObjectType t1, ObjectType t2, ObjectType t3, ObjectType t4, ObjectType t5 );
+	void ExpectTypes( Object* obj, ObjectType t1, ObjectType t2, ObjectType t3, ObjectType t4, ObjectType t5, ObjectType t6 );
 	void ExpectIntegralNumber( Object* obj );
 	void ExpectPositiveIntegralNumber( Object* obj );
 
 	// argument/data handling
 	Object* GetLocalN( int local_num );
+	// the numbers of a vector, as an array: a packed vector's own, or (for an
+	// unpacked vector) copies of them in 'tmp'. throws if the vector holds
+	// anything but numbers
+	const double* GetNumbers( Object* vec, vector<double> & tmp );
 	inline void ReturnVal( Object o ) { IncRef( o ); ex->PushStack( o ); }
 };
 
+// create a (packed, if it is large enough) vector from 'nums' (whose contents
+// are taken)
+Vector* CreateNumberVector( vector<double> & nums );
 
 } // end namespace deva
 
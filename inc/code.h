@@ -32,6 +32,9 @@
 #define __CODE_H__
 
 #include "linemap.h"
+#include "util.h"
+#include "mappedfile.h"
+#include "shape.h"
 
 #include <vector>
 #include <set>
@@ -56,18 +59,37 @@ private:
 public:
 	LineMap* lines;
 
-	Code() : code( NULL ), len( 0 ), lines( NULL ) {}
-	Code( byte* c, size_t l, size_t n, LineMap* ln ) : code( c ), len( l ), lines( ln ) {}
+	// shape/slot caches for the instance field loads & stores in this code,
+	// indexed by the tbl_load/tbl_store operand
+	vector<FieldCache> field_caches;
+
+	// the .dvc file this code was loaded from, if any. the byte-code and
+	// (most) string constants point into the mapping and aren't freed
+	MappedFile* mapping;
+
+	// the string constants belong to a pool outside the code (see
+	// ShareStrings()) and aren't freed with it
+	bool shared_strings;
+
+	Code() : code( NULL ), len( 0 ), lines( NULL ), mapping( NULL ), shared_strings( false ) {}
+	Code( byte* c, size_t l, size_t n, LineMap* ln ) : code( c ), len( l ), lines( ln ), mapping( NULL ), shared_strings( false ) {}
 	~Code()
 	{
-		delete[] code;
+		if( !mapping )
+			delete[] code;
 		delete lines;
 		// free the constants' string data
-		for( size_t i = 0; i < constants.size(); i++ )
+		for( size_t i = 0; i < constants.size() && !shared_strings; i++ )
 		{
 			ObjectType type = constants.at( i ).type;
-			if( type == obj_string || type == obj_symbol_name ) delete [] constants.at( i ).s;
+			if( type == obj_string || type == obj_symbol_name )
+			{
+				char* s = constants.at( i ).s;
+				if( !mapping || !mapping->Contains( s ) )
+					freestr( s );
+			}
 		}
+		delete mapping;
 	}
 
 	inline bool AddConstant( Object o ) { if( constants_set.count( o ) != 0 ) return false; else { constants_set.insert( o ); constants.push_back( o ); return true; } }
@@ -81,6 +103,31 @@ public:
 		return INT_MIN;
 	}
 	inline int NumConstants() const { return (int)constants.size(); }
+
+	// hand the string constants to 'pool', which keeps one copy of each text,
+	// so that the code can be freed while objects still point at them
+	void ShareStrings( set<Object, MapKeyLess> & pool )
+	{
+		for( size_t i = 0; i < constants.size(); i++ )
+		{
+			Object & o = constants[i];
+			if( o.type != obj_string && o.type != obj_symbol_name )
+				continue;
+			set<Object, MapKeyLess>::iterator it = pool.find( o );
+			if( it == pool.end() )
+				pool.insert( o );
+			else
+			{
+				freestr( o.s );
+				o.s = it->s;
+			}
+		}
+		constants_set.clear();
+		constants_set.insert( constants.begin(), constants.end() );
+		shared_strings = true;
+	}
+
+	inline dword AddFieldCache() { field_caches.push_back( FieldCache() ); return (dword)(field_caches.size() - 1); }
 };
 
 
@@ -49,6 +49,9 @@ using namespace std;
 namespace deva_compile
 {
 
+// a decoded instruction, for the optimizer (see optimize.cpp)
+struct Instr;
+
 class InstructionStream
 {
 	size_t size;
@@ -92,6 +95,8 @@ public:
 	{
 		*((dword*)(bytes + loc)) = val;
 	}
+	// drop the code from 'loc' on (to re-write the last instruction)
+	inline void Truncate( size_t loc ) { cur = bytes + loc; }
 private:
 	void Realloc()
 	{
@@ -136,6 +141,11 @@ private:
 	// name of the module we're compiling
 	const char* module_name;
 
+	// the function objects defined in this module, for the optimizer
+	vector<Function*> functions;
+	// the functions being compiled, the innermost last
+	vector<Function*> fcn_stack;
+
 public:
 	int num_locals;	// number of locals in the current scope
 
@@ -178,6 +188,18 @@ private:
 	// clean-up loop/break tracking helper
 	void CleanupEndLoop();
 
+	// start a counting 'for' loop over 'range( ... )'
+	int RangeLoopInit( size_t & loop_patch );
+
+	// optimizer helpers
+	bool ConstantValue( const Instr & in, Object & o );
+	bool MakeConstantPush( Instr & in, const Object & o );
+	bool FoldConstants( vector<Instr> & instrs, const vector<bool> & is_target );
+	bool FunctionExtents( const vector<Instr> & instrs, map<Function*, pair<int, int> > & extents, vector<Function*> & owner );
+	void InlineCalls( vector<Instr> & instrs );
+	bool PushesSymbol( const Instr & in, const char* name );
+	void SpecializeNumericOps( vector<Instr> & instrs );
+
 public:
 	/////////////////////////////////////////////////////////////////////////
 	// functions for public consumption
@@ -206,6 +228,15 @@ public:
 	// mostly for debugging purposes
 	void Decode();
 
+	// inline small functions, fold constant expressions, remove unreachable
+	// code and use the numeric ops where operands are known to be numbers.
+	// must be called once the whole module has been compiled, before Compact()
+	void Optimize();
+
+	// re-encode the code in the compact form that is run (one-byte operands,
+	// wide prefixes, relative jumps). must be called once, before GetCode()
+	void Compact();
+
 	// scope tracking:
 	inline void AddScope() { scopestack.push_back( max_scope_idx ); max_scope_idx++; }
 	inline void LeaveScope() { scopestack.pop_back(); }
@@ -0,0 +1,66 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// compilecache.h
+// shared, content-addressed cache of compiled (.dvc) files
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#ifndef __COMPILECACHE_H__
+#define __COMPILECACHE_H__
+
+#include <string>
+
+using namespace std;
+
+namespace deva
+{
+
+// when $DEVA_CACHE names a directory, compiled files are stored there rather
+// than next to their source. entries are named for a hash of the compiler
+// (its version and the size and time of the deva executable), the source's
+// full path, its contents and whether it was optimized
+// (see -O), so an existing entry is never stale and can be shared by any
+// number of deva processes. entries are written atomically (see
+// Executor::WriteCode) and the directory is kept under $DEVA_CACHE_SIZE
+// megabytes (default 64) by removing the least recently used entries
+
+// returns the cache entry for the given source file, or an empty string if
+// there is no cache directory or the source can't be read. the entry's name
+// is only a 64-bit hash, 'stamp' is set to the text that identifies the
+// source completely (the compiler, the path, and the length and a second hash
+// of the contents). it's stored in the entry when it is written and checked
+// when it is read (see Executor::WriteCode/ReadCode)
+string CompileCacheEntry( const string & dvfile, bool optimize = false, string* stamp = NULL );
+// mark a cache entry as just used
+void CompileCacheTouch( const string & entry );
+// remove the least recently used entries until the cache is under its cap
+void CompileCacheTrim();
+
+
+} // end namespace deva
+
+#endif // __COMPILECACHE_H__
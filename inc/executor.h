@@ -44,11 +44,14 @@
 #include "string_builtins.h"
 #include "vector_builtins.h"
 #include "map_builtins.h"
+#include "buffer_builtins.h"
+#include "stringbuilder_builtins.h"
 #include "code.h"
 #include "breakpoint.h"
 
 #include <vector>
 #include <set>
+#include <list>
 #include <climits>
 
 using namespace std;
@@ -88,6 +91,8 @@ class Executor
 	// TODO: a vector's [] op uses one deref and two adds to get to a value,
 	// with a plain pointer/array we can get rid of one add.. worth it?
 	vector<Object> stack;
+	// are the top two objects on the stack numbers? (for the '_num' ops)
+	inline bool TopTwoAreNumbers() const { size_t n = stack.size(); return n > 1 && stack[n-1].type == obj_number && stack[n-2].type == obj_number; }
 
 	// 'global' scope table (namespace)
 	ScopeTable* scopes;
@@ -129,12 +134,46 @@ class Executor
 	// error object
 	Object error;
 
+	// compiled eval() text, keyed by the text and its flags, in least
+	// recently used order. only the code is cached: each eval() call runs it
+	// in a new module (with its own frame and scope), as the module objects
+	// eval() returns can be kept. the cache owns the code, and an evicted
+	// entry's code and '@main' are freed. cached code's string constants are
+	// moved to eval_strings first, as objects anywhere can point at them.
+	// (the modules stay until the executor is destroyed, as they do for text
+	// that isn't cached)
+	struct EvalCacheEntry
+	{
+		Code* code;
+		// the '[TEXTn]' module name the text was compiled as, and its '@main'
+		string name;
+		Object* main;
+		size_t size;
+		// is the code running? (text which evals itself compiles it again,
+		// and if it is evicted while it runs it is kept with code_blocks)
+		bool running;
+		list<string>::iterator lru;
+	};
+	map<string, EvalCacheEntry> eval_cache;
+	list<string> eval_cache_lru;
+	size_t eval_cache_size;
+	size_t eval_cache_hits;
+	size_t eval_cache_misses;
+	// one copy of the text of each string constant in cached code
+	set<Object, MapKeyLess> eval_strings;
+
+	EvalCacheEntry* FindEvalCache( const string & key );
+	bool AddEvalCache( const string & key, Code* code, const string & name, Object* main );
+	void EvictEvalCache();
+
 public:
 	// flags:
 	bool debug;
 	bool trace;
 	bool stop_at_breakpoints;
 	bool stepping;
+	// optimize the code for modules and text compiled at run-time
+	bool optimize;
 
 public:
 	Executor();
@@ -241,12 +280,17 @@ public:
 	void CallDestructors( Object o );
 	// add a code block
 	void AddCode( const Code* const code ) { code_blocks.push_back( code ); }
-	// execute the current (top of stack) code block
-	int ExecuteCode();
+	// execute a code block (by default the current, top of stack, one)
+	int ExecuteCode( const Code* const code = NULL );
 	Object ExecuteText( const char* const text, bool global = false, bool ignore_undefined_vars = false );
+	// eval() compile cache statistics
+	inline size_t EvalCacheHits() const { return eval_cache_hits; }
+	inline size_t EvalCacheMisses() const { return eval_cache_misses; }
+	inline size_t EvalCacheEntries() const { return eval_cache.size(); }
+	inline size_t EvalCacheSize() const { return eval_cache_size; }
 	Opcode SkipInstruction();
 	Opcode ExecuteInstruction();
-	void BeginExecution();
+	void BeginExecution( const Code* const code = NULL );
 	int StepOver( int line, int max_line );
 	int StepInto();
 	int ContinueExecution();
@@ -254,6 +298,15 @@ public:
 	void ExecuteFunction( Function* f, int num_args, bool method_call_op, bool is_destructor = false );
 	void ExecuteFunctionToReturn( Function* f, int num_args, bool method_call_op, bool is_destructor = false );
 	void ExecuteFunction( NativeFunction f, int num_args, bool method_call_op );
+	// calling a native function repeatedly (e.g. for each item of a vector)
+	// with a single frame and scope, rather than creating them for every call:
+	// BeginNativeCalls() creates them, the args for each call are set in the
+	// frame it returns (with SetLocal(), 'self' first for methods),
+	// CallNative() makes the call and returns the return value, and
+	// EndNativeCalls() destroys the frame and scope
+	Frame* BeginNativeCalls( NativeFunction f, int num_args );
+	Object CallNative( Frame* frame );
+	void EndNativeCalls();
 
 	// breakpoint handling
 	vector<Breakpoint> GetBreakpoints() { return breakpoints; }
@@ -262,9 +315,10 @@ public:
 	bool SetBreakpoint( string filename, int line );
 	bool SetBreakpoint( const char* function );
 
-	// .dv file reading/writing
-	void WriteCode( string filename, const Code* const code );
-	Code* ReadCode( string filename );
+	// .dv file reading/writing. compile cache entries carry the stamp of their
+	// source (see CompileCacheEntry()), which reading checks
+	void WriteCode( string filename, const Code* const code, const string & stamp = string() );
+	Code* ReadCode( string filename, const string & stamp = string() );
 
 	void SetError( Object* err );
 	bool Error();
@@ -300,6 +354,8 @@ public:
 	void Decode( const Code* code );
 
 	void DumpFunctions();
+	// functions the optimizer inlined, and at how many call sites
+	void DumpInlinedCalls();
 	void DumpConstantPool( const Code* code );
 	void DumpStackTop( size_t n = 5, bool single_line = true );
 	void DumpTrace( ostream & os );
@@ -22,7 +22,7 @@
 // OTHER DEALINGS IN THE SOFTWARE.
 
 // fileformat.h
-// .dv file format definitions for the deva language, v2
+// .dv file format definitions for the deva language, v3
 // created by jcs, april 17, 2011
 
 // TODO:
@@ -37,11 +37,17 @@ namespace deva
 
 // a compiled deva file (.dvc file) consists of:
 // - a header
+// - a section table
+// - a string blob (all names and string constants)
 // - a constant data area
-// - a 'global' data area
 // - a list of function objects (including a "@main" global 'function')
-// - a line mapping structure (line to instruction offset)
+// - a line mapping structure (instruction offset to line)
 // - and a stream of instructions and their operands
+//
+// all sections are little-endian records starting on an 8-byte boundary, so
+// a loader can map the file and use the byte-code (and, on 64-bit
+// little-endian hosts, the string data) in place. the instruction stream
+// itself is written in host byte order, as it always has been
 
 
 // header
@@ -50,57 +56,106 @@ namespace deva
 //struct FileHeader
 //{
 //	static const byte deva[5];	// "deva"
-//	static const byte ver[6];	// "2.0.0"
+//	static const byte ver[6];	// "6.1.0"
 //	static const byte pad[5];	// "\0\0\0\0\0"
 //	static unsigned long size(){ return sizeof( deva ) + sizeof( ver ) + sizeof( pad ); }
 //};
 // define the static members of the FileHeader struct
 const char file_hdr_deva[5] = "deva";
-const char file_hdr_ver[6] = "2.0.0";
+// (the minor version changes when opcodes are added or their operands
+// change, the major version when the layout changes)
+const char file_hdr_ver[6] = "6.1.0";
 const char file_hdr_pad[5] = "\0\0\0\0";
 const dword sizeofFileHdr = sizeof( file_hdr_deva ) + sizeof( file_hdr_ver ) + sizeof( file_hdr_pad ); // 16
 
 
+// section table
+/////////////////////////////////////////////////////////////////////////////
+// the header is followed by a dword containing the number of sections and a
+// dword of padding, then an array of section entries:
+// 8 bytes :	section tag, null-padded (e.g. ".const\0\0")
+// dword :		offset of the section from the start of the file
+// dword :		size of the section in bytes
+const dword sizeofSectionTag = 8;
+const dword sizeofSectionEntry = sizeofSectionTag + 2 * sizeof( dword ); // 16
+
+// section tags
+const char strings_hdr[8] = ".string";
+const char constants_hdr[8] = ".const";
+const char functions_hdr[8] = ".func";
+const char linemap_hdr[8] = ".lines";
+const char code_hdr[8] = ".code";
+// (optional)
+const char source_hdr[8] = ".source";
+
+
+// string blob
+/////////////////////////////////////////////////////////////////////////////
+// an array of strings, each starting on an 8-byte boundary:
+// qword :		length of the string (the size_t length header of a runtime
+//				string, see allocstr() in util.h)
+// len+1 bytes :	string data, null-terminated
+// strings are referred to by the offset (from the start of the blob) of
+// their first character, not of their length
+
+
 // constant data area
 /////////////////////////////////////////////////////////////////////////////
-const char constants_hdr[7] = ".const";
-const char constants_hdr_pad[1] = "";
-const dword sizeofConstantsHdr = sizeof( constants_hdr ) + sizeof( constants_hdr_pad ); // 8
-// header is followed by dword containing the number of const objects
-// constant data itself is an array of DevaObject structs:
-// byte : object type. only number and string are allowed
-// qword (number) OR 'len+1' bytes (string) : number or null-terminated string
+// a dword containing the number of const objects, a dword of padding, then
+// an array of 16-byte constant records:
+// dword :		object type. only number, string, symbol name and size are allowed
+// dword :		flags (numbers: const_flag_int if the number is an integer)
+// qword :		payload:
+//				number - the integer, or the bits of the double (lossless)
+//				string/symbol name - string blob offset
+//				size - the value
+const dword sizeofConstantRecord = 16;
+const dword const_flag_int = 0x1;
 
 
 // function object area
 /////////////////////////////////////////////////////////////////////////////
-const char functions_hdr[6] = ".func";
-const char functions_hdr_pad[2] = "\0";
-const dword sizeofFunctionsHdr = sizeof( functions_hdr ) + sizeof( functions_hdr_pad ); // 8
-// header is followed by a dword containing the number of function objects
-// function object data itself is an array of DevaFunction objects:
-// len+1 bytes : 	name, null-terminated string
-// len+1 bytes : 	filename
-// dword :			starting line
-// len+1 bytes :	classname (zero-length string if non-method)
-// dword : 			number of arguments
-// dword : 			'n' number of default arguments
-// 'n' dwords :		default args (constant pool indices)
-// dword :			number of locals
-// dword :			number of names (externals, undeclared vars, functions)
-// byte[] :			names, len+1 bytes null-terminated string each
-// dword :			offset in code section of the code for this function
+// a dword containing the number of function objects, a dword of padding,
+// then an array of function records:
+// dword :		name (string blob offset)
+// dword :		filename (string blob offset)
+// dword :		starting line
+// dword :		classname (string blob offset, zero-length string if non-method)
+// dword :		number of arguments
+// dword :		'n' number of default arguments
+// dword :		index of the first default arg in the extra data
+// dword :		'm' number of locals
+// dword :		index of the first local name in the extra data
+// dword :		offset in code section of the code for this function
+// followed by an array of dwords of 'extra' data holding the variable-length
+// lists: default args (constant pool indices) and local names (string blob
+// offsets)
+const dword sizeofFunctionRecord = 10 * sizeof( dword ); // 40
 
 
 // line mapping data area
 /////////////////////////////////////////////////////////////////////////////
-const char linemap_hdr[9] = ".linemap";
-const char linemap_hdr_pad[7] = "\0\0\0\0\0\0";
-const dword sizeofLinemapHdr = sizeof( linemap_hdr ) + sizeof( linemap_hdr_pad ); // 8
-// header is followed by a dword containing the number of line map entries
-// line map data itself is an array of entries:
-// dword : 	line
-// dword :	address of instruction
+// a dword containing the number of line map entries, a dword of padding,
+// then the (address, line) entries, sorted by address (see LineMap in
+// linemap.h), each as the difference from the previous entry (or from zero):
+// varint :	address of instruction, unsigned
+// varint :	line, signed (zig-zag encoded: 0, -1, 1, -2, 2... as 0, 1, 2, 3, 4...)
+// varints are unsigned LEB128: seven bits per byte, low bits first, the high
+// bit set on all but the last byte
+
+
+// code area
+/////////////////////////////////////////////////////////////////////////////
+// the instruction stream, with nothing else in the section. it's in the
+// compact form the executor runs (one-byte operands, wide prefixes for dword
+// operands, relative jumps: see opcodes.h)
+
+
+// source stamp area
+/////////////////////////////////////////////////////////////////////////////
+// only in compile cache entries (see compilecache.h): the text of the stamp
+// identifying the source the entry was compiled from, which must match the
+// source being loaded
 
 
 } // namespace deva
@@ -0,0 +1,63 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// fpbits.h
+// bit-pattern tests on doubles for the deva language
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#ifndef __FPBITS_H__
+#define __FPBITS_H__
+
+#include "typedefs.h"
+
+#include <cstring>
+
+namespace deva
+{
+
+// release builds use -ffast-math, which lets the compiler assume there are no
+// NaNs and no negative zeros, and remove tests like 'd != d'. these look at
+// the bits instead, which it can't see through
+const qword fp_exponent_mask = 0x7FF0000000000000ULL;
+const qword fp_mantissa_mask = 0x000FFFFFFFFFFFFFULL;
+const qword fp_sign_bit = 0x8000000000000000ULL;
+
+inline qword DoubleBits( double d )
+{
+	qword bits;
+	memcpy( &bits, &d, sizeof( double ) );
+	return bits;
+}
+inline bool IsNaN( double d )
+{
+	qword bits = DoubleBits( d );
+	return (bits & fp_exponent_mask) == fp_exponent_mask && (bits & fp_mantissa_mask) != 0;
+}
+inline bool IsNegativeZero( double d ) { return DoubleBits( d ) == fp_sign_bit; }
+
+} // namespace deva
+
+#endif // __FPBITS_H__
@@ -101,7 +101,7 @@ public:
 	inline size_t GetStackDepth() const { return stack_depth; }
 	inline void SetStackDepth( size_t d ) { stack_depth = d; }
 	inline void AddString( char* s ) { strings.push_back( s ); }
-	inline const char* AddString( string s ) { char* str = copystr( s.c_str() ); strings.push_back( str ); return str; }
+	inline const char* AddString( const string & s ) { char* str = copystr( s ); strings.push_back( str ); return str; }
 
 	// copy all the strings in 'o' from the parent to here
 	// ('o' can be a string, or a vector/map/class/instance which can then can
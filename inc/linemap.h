@@ -31,7 +31,8 @@
 #ifndef __LINEMAP_H__
 #define __LINEMAP_H__
 
-#include <map>
+#include <vector>
+#include <algorithm>
 
 using namespace std;
 
@@ -40,66 +41,109 @@ namespace deva
 
 // map lines to addresses and addresses to lines
 // (specifically to the address of the *first* instruction found on the line)
+// both directions are arrays sorted by their key, searched with a binary search
 class LineMap
 {
+public:
+	// (address, line) or (line, address)
+	typedef pair<dword, dword> Entry;
+	typedef vector<Entry>::const_iterator iterator;
+
 private:
-	map<dword, dword> l2a;
-	map<dword, dword> a2l;
+	// (address, line), sorted by address. lines with no code of their own
+	// share an address with the next line, the one added first is the line
+	// reported for it
+	vector<Entry> a2l;
+	// (line, address), sorted by line
+	vector<Entry> l2a;
+	// addresses are almost always added in order, a2l is sorted when it isn't
+	bool sorted;
 
-public:
-	static const dword end = (dword)-1;
+	static bool KeyLess( const Entry & a, const Entry & b ) { return a.first < b.first; }
 
-	LineMap() {}
+	void Sort()
+	{
+		if( sorted )
+			return;
+		// (stable, to keep the order of lines sharing an address)
+		stable_sort( a2l.begin(), a2l.end(), KeyLess );
+		sorted = true;
+	}
 
-	inline map<dword, dword>::iterator L2ABegin() { return l2a.begin(); }
-	inline map<dword, dword>::iterator L2AEnd() { return l2a.end(); }
-	inline size_t L2ASize() { return l2a.size(); }
+	void AddAddress( dword addr, dword line )
+	{
+		if( !a2l.empty() && addr < a2l.back().first )
+			sorted = false;
+		a2l.push_back( Entry( addr, line ) );
+	}
 
-	void Add( dword line, dword addr )
+	// set the address of a line if it doesn't have one yet or the new one is
+	// smaller. returns false if it wasn't set
+	bool SetAddress( dword line, dword addr )
 	{
-		map<dword, dword>::iterator i = l2a.find( line );
+		vector<Entry>::iterator i = lower_bound( l2a.begin(), l2a.end(), Entry( line, 0 ), KeyLess );
 		// if an entry already exists for this line...
-		if( i != l2a.end() )
+		if( i != l2a.end() && i->first == line )
 		{
-			// ...and it is for a larger address
-			if( i->second > addr )
-			{
-				// erase the old entry
-				l2a.erase( i );
-				// and add the new ones
-				l2a.insert( make_pair( line, addr ) );
-				a2l.insert( make_pair( addr, line ) );
-			}
+			// ...and it is for a smaller address, keep it
+			if( i->second <= addr )
+				return false;
+			i->second = addr;
 		}
-		// otherwise just add the entries
 		else
-		{
-			l2a.insert( make_pair( line, addr ) );
-			a2l.insert( make_pair( addr, line ) );
-		}
+			l2a.insert( i, Entry( line, addr ) );
+		return true;
 	}
-	
+
+public:
+	static const dword end = (dword)-1;
+
+	LineMap() : sorted( true ) {}
+
+	// (line, address) entries, by line
+	inline iterator L2ABegin() { return l2a.begin(); }
+	inline iterator L2AEnd() { return l2a.end(); }
+	inline size_t L2ASize() { return l2a.size(); }
+
+	// (address, line) entries, by address. these are what's stored in a .dvc
+	// file, the line to address map is rebuilt from them by AddEntry()
+	inline iterator A2LBegin() { Sort(); return a2l.begin(); }
+	inline iterator A2LEnd() { Sort(); return a2l.end(); }
+	inline size_t A2LSize() { return a2l.size(); }
+
+	void Add( dword line, dword addr )
+	{
+		if( SetAddress( line, addr ) )
+			AddAddress( addr, line );
+	}
+
+	// add an (address, line) entry read back from a .dvc file
+	void AddEntry( dword addr, dword line )
+	{
+		SetAddress( line, addr );
+		AddAddress( addr, line );
+	}
+
 	dword FindAddress( dword line )
 	{
-		map<dword,dword>::iterator i = l2a.find( line );
-		if( i == l2a.end() )
+		vector<Entry>::iterator i = lower_bound( l2a.begin(), l2a.end(), Entry( line, 0 ), KeyLess );
+		if( i == l2a.end() || i->first != line )
 			return LineMap::end;
 		else return i->second;
 	}
 
-	// look *between* the addresses we know about (in the map) to find the correct line
+	// look *between* the addresses we know about to find the correct line
 	dword FindLine( size_t addr )
 	{
-		dword line = 0;
-		for( map<dword, dword>::iterator i = a2l.begin(); i != a2l.end(); ++i )
-		{
-			dword a = i->first;
-			if( a > addr )
-				return line;
-			else
-				line = i->second;
-		}
-		return line;
+		Sort();
+		// the last address at or before 'addr'...
+		vector<Entry>::iterator i = upper_bound( a2l.begin(), a2l.end(), Entry( (dword)addr, 0 ), KeyLess );
+		if( i == a2l.begin() )
+			return 0;
+		// ...and the first line added for it
+		--i;
+		i = lower_bound( a2l.begin(), i, *i, KeyLess );
+		return i->second;
 	}
 };
 
@@ -0,0 +1,70 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// mappedfile.h
+// read-only (copy-on-write) file mappings for the deva language
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#include "typedefs.h"
+#include <string>
+
+using namespace std;
+
+namespace deva
+{
+
+// a whole file mapped into memory. pages are mapped private, so writes (e.g.
+// patching byte-code) never reach the file. where mmap isn't available the
+// file is read into a heap buffer instead
+class MappedFile
+{
+private:
+	byte* data;
+	size_t size;
+	bool mapped;
+
+	// non-copyable
+	MappedFile( const MappedFile & );
+	MappedFile & operator = ( const MappedFile & );
+
+public:
+	// throws a RuntimeException if the file can't be opened or mapped
+	MappedFile( const string & filename );
+	~MappedFile();
+
+	inline byte* Data() const { return data; }
+	inline size_t Size() const { return size; }
+	inline bool Contains( const void* p ) const { return (const byte*)p >= data && (const byte*)p < data + size; }
+};
+
+
+} // end namespace deva
+
+#endif // __MAPPEDFILE_H__
@@ -0,0 +1,268 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// nanbox.h
+// NaN-boxed object representation for the deva language
+// (included by object.h, part way through, when built with DEVA_NAN_BOXING)
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#ifndef __NANBOX_H__
+#define __NANBOX_H__
+
+#include "typedefs.h"
+#include "fpbits.h"
+
+#include <cstring>
+
+namespace deva
+{
+
+// an Object is a single 64-bit word. numbers are stored as plain doubles.
+// every other type is stored in the NaN space: the top 13 bits set (a
+// negative quiet NaN), a non-zero 4-bit tag in bits 47-50 and a 47-bit payload
+// (pointer, boolean or size) in bits 0-46. a tag of zero is left for real NaNs,
+// and NaNs being stored as numbers are made canonical so they never look boxed.
+//
+// the members of Object ('type', 'd', 's', 'v' etc) are 'field' objects
+// overlaid on the same word, which encode/decode on access. this gives the
+// executor and builtins one accessor API for both representations.
+//
+// integer numbers (see number.h) are stored in the positive NaN space, which
+// canonical NaNs never use: a 0x7FFC prefix and a 50-bit two's complement
+// payload. integers that don't fit are stored as doubles.
+//
+// the tags are all in use, so buffers share the module tag and string builders
+// share the native module tag, marked by the low bit of their (aligned)
+// pointer.
+//
+// NOTE: pointers must fit in 47 bits (true for user-space on x86-64), and
+// sized values (obj_size) are limited to 47 bits.
+
+namespace nanbox
+{
+
+const qword box_mask = 0xFFF8000000000000ULL;
+const int tag_shift = 47;
+const qword tag_mask = 0xFULL << tag_shift;
+const qword payload_mask = (1ULL << tag_shift) - 1;
+const qword canonical_nan = 0x7FF8000000000000ULL;
+
+// tags. the tag is the ObjectType, except for null (which would be tag zero)
+// and native methods, which need their own tag for the 'is_method' flag
+const qword tag_null = 2;			// obj_number is never boxed, so its value is free
+const qword tag_native_method = 15;
+// obj_end is boxed as null with a non-zero payload
+const qword end_payload = 1;
+// obj_buffer is boxed as a module, and obj_stringbuilder as a native module,
+// with this payload bit set
+const qword mark_bit = 1;
+
+inline bool IsBoxed( qword bits ) { return (bits & box_mask) == box_mask && (bits & tag_mask) != 0; }
+inline qword Tag( qword bits ) { return (bits & tag_mask) >> tag_shift; }
+inline qword Payload( qword bits ) { return bits & payload_mask; }
+inline qword TagFor( ObjectType t )
+{
+	if( t == obj_null || t == obj_end )
+		return tag_null;
+	if( t == obj_buffer )
+		return (qword)obj_module;
+	if( t == obj_stringbuilder )
+		return (qword)obj_native_module;
+	return (qword)t;
+}
+inline qword Box( ObjectType t, qword payload )
+{
+	if( t == obj_end )
+		payload = end_payload;
+	else if( t == obj_buffer || t == obj_stringbuilder )
+		payload |= mark_bit;
+	return box_mask | (TagFor( t ) << tag_shift) | (payload & payload_mask);
+}
+inline qword BoxNumber( double d )
+{
+	// (a NaN's payload would be taken for a boxed object)
+	if( deva::IsNaN( d ) )
+		return canonical_nan;
+	return deva::DoubleBits( d );
+}
+inline double UnboxNumber( qword bits )
+{
+	double d;
+	memcpy( &d, &bits, sizeof( double ) );
+	return d;
+}
+inline ObjectType TypeOf( qword bits )
+{
+	if( !IsBoxed( bits ) )
+		return obj_number;
+	qword tag = Tag( bits );
+	if( tag == tag_null )
+		return Payload( bits ) == end_payload ? obj_end : obj_null;
+	if( tag == tag_native_method )
+		return obj_native_function;
+	if( tag == (qword)obj_module && (Payload( bits ) & mark_bit) )
+		return obj_buffer;
+	if( tag == (qword)obj_native_module && (Payload( bits ) & mark_bit) )
+		return obj_stringbuilder;
+	return (ObjectType)tag;
+}
+// integer numbers
+const qword int_mask = 0xFFFC000000000000ULL;
+const qword int_prefix = 0x7FFC000000000000ULL;
+const int int_bits = 50;
+const qword int_payload_mask = (1ULL << int_bits) - 1;
+const int64_t max_boxed_int = (1LL << (int_bits - 1)) - 1;
+const int64_t min_boxed_int = -(1LL << (int_bits - 1));
+inline bool IsBoxedInt( qword bits ) { return (bits & int_mask) == int_prefix; }
+inline int64_t UnboxInt( qword bits ) { return ((int64_t)(bits << (64 - int_bits))) >> (64 - int_bits); }
+inline qword BoxInteger( int64_t n )
+{
+	if( n < min_boxed_int || n > max_boxed_int )
+		return BoxNumber( (double)n );
+	return int_prefix | ((qword)n & int_payload_mask);
+}
+inline double NumberValue( qword bits ) { return IsBoxedInt( bits ) ? (double)UnboxInt( bits ) : UnboxNumber( bits ); }
+// replace the payload, keeping the tag
+inline qword SetPayload( qword bits, qword payload ) { return (bits & ~payload_mask) | (payload & payload_mask); }
+
+// 'field' types. each holds only the object's word, so they can all share
+// the union in Object
+
+struct TypeField
+{
+	qword bits;
+	inline operator ObjectType() const { return TypeOf( bits ); }
+	inline TypeField & operator = ( ObjectType t )
+	{
+		// numbers become zero, other types keep their payload
+		if( t == obj_number )
+			bits = 0;
+		else
+			bits = Box( t, IsBoxed( bits ) ? Payload( bits ) : 0 );
+		return *this;
+	}
+};
+
+struct NumberField
+{
+	qword bits;
+	// integers read as their double value
+	inline operator double() const { return NumberValue( bits ); }
+	inline NumberField & operator = ( double d ) { bits = BoxNumber( d ); return *this; }
+	inline NumberField & operator += ( double d ) { bits = BoxNumber( NumberValue( bits ) + d ); return *this; }
+	inline NumberField & operator -= ( double d ) { bits = BoxNumber( NumberValue( bits ) - d ); return *this; }
+	inline NumberField & operator *= ( double d ) { bits = BoxNumber( NumberValue( bits ) * d ); return *this; }
+	inline NumberField & operator /= ( double d ) { bits = BoxNumber( NumberValue( bits ) / d ); return *this; }
+};
+
+struct IntField
+{
+	qword bits;
+	inline operator int64_t() const { return UnboxInt( bits ); }
+};
+
+template<typename T> struct PointerField
+{
+	qword bits;
+	inline operator T* () const { return (T*)(size_t)Payload( bits ); }
+	inline T* operator -> () const { return (T*)(size_t)Payload( bits ); }
+	inline PointerField & operator = ( T* p ) { bits = SetPayload( bits, (qword)(size_t)p ); return *this; }
+};
+
+// native objects are cast to whatever type their owner stored
+template<> struct PointerField<void>
+{
+	qword bits;
+	template<typename U> inline operator U* () const { return (U*)(size_t)Payload( bits ); }
+	inline PointerField & operator = ( void* p ) { bits = SetPayload( bits, (qword)(size_t)p ); return *this; }
+	inline bool operator == ( const PointerField & rhs ) const { return Payload( bits ) == Payload( rhs.bits ); }
+	inline bool operator != ( const PointerField & rhs ) const { return Payload( bits ) != Payload( rhs.bits ); }
+	inline bool operator < ( const PointerField & rhs ) const { return Payload( bits ) < Payload( rhs.bits ); }
+};
+
+// pointers for the types marked with 'mark_bit' (buffers and string builders)
+template<typename T> struct MarkedPointerField
+{
+	qword bits;
+	inline operator T* () const { return (T*)(size_t)(Payload( bits ) & ~mark_bit); }
+	inline T* operator -> () const { return (T*)(size_t)(Payload( bits ) & ~mark_bit); }
+	inline MarkedPointerField & operator = ( T* p ) { bits = SetPayload( bits, (qword)(size_t)p | mark_bit ); return *this; }
+};
+
+struct BoolField
+{
+	qword bits;
+	inline operator int() const { return (int)Payload( bits ); }
+	inline BoolField & operator = ( int b ) { bits = SetPayload( bits, b != 0 ); return *this; }
+};
+
+struct SizeField
+{
+	qword bits;
+	inline operator size_t() const { return (size_t)Payload( bits ); }
+	inline SizeField & operator = ( size_t sz ) { bits = SetPayload( bits, (qword)sz ); return *this; }
+};
+
+struct NativeFunctionPtrField
+{
+	qword bits;
+	inline operator NativeFunctionPtr() const { return (NativeFunctionPtr)(size_t)Payload( bits ); }
+	inline NativeFunctionPtrField & operator = ( NativeFunctionPtr p ) { bits = SetPayload( bits, (qword)(size_t)p ); return *this; }
+};
+
+struct IsMethodField
+{
+	qword bits;
+	inline operator bool() const { return Tag( bits ) == tag_native_method; }
+	inline IsMethodField & operator = ( bool m )
+	{
+		bits = (bits & ~tag_mask) | ((m ? tag_native_method : (qword)obj_native_function) << tag_shift);
+		return *this;
+	}
+};
+
+struct NativeFunctionField
+{
+	union
+	{
+		qword bits;
+		NativeFunctionPtrField p;
+		IsMethodField is_method;
+	};
+	inline operator NativeFunction() const { NativeFunction nf; nf.p = p; nf.is_method = is_method; return nf; }
+	inline NativeFunctionField & operator = ( NativeFunction nf ) { p = nf.p; is_method = nf.is_method; return *this; }
+};
+
+inline qword BoxNativeFunction( NativeFunctionPtr p, bool is_method )
+{
+	return box_mask | ((is_method ? tag_native_method : (qword)obj_native_function) << tag_shift) | ((qword)(size_t)p & payload_mask);
+}
+
+} // namespace nanbox
+
+} // namespace deva
+
+#endif // __NANBOX_H__
@@ -0,0 +1,231 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// number.h
+// integer/double number helpers for the deva language
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#ifndef __NUMBER_H__
+#define __NUMBER_H__
+
+#include "object.h"
+#include "util.h"
+
+#include <limits>
+#include <cmath>
+
+namespace deva
+{
+
+// numbers are a single type in the language, but internally a number is
+// either a double or a 64-bit integer (Object::IsInt()). integral constants
+// and the results of integer arithmetic that doesn't overflow are integers,
+// so loop counters and indices stay off the FPU. anything else (overflow,
+// non-integral results, mixed operands) transparently becomes a double
+
+const int64_t int64_max = std::numeric_limits<int64_t>::max();
+const int64_t int64_min = std::numeric_limits<int64_t>::min();
+
+// overflow-checked integer arithmetic, returns false if the result overflowed
+inline bool CheckedAdd( int64_t a, int64_t b, int64_t & r )
+{
+#if defined( __GNUC__ ) && __GNUC__ >= 5
+	return !__builtin_add_overflow( a, b, &r );
+#else
+	if( (b > 0 && a > int64_max - b) || (b < 0 && a < int64_min - b) )
+		return false;
+	r = a + b;
+	return true;
+#endif
+}
+inline bool CheckedSub( int64_t a, int64_t b, int64_t & r )
+{
+#if defined( __GNUC__ ) && __GNUC__ >= 5
+	return !__builtin_sub_overflow( a, b, &r );
+#else
+	if( (b < 0 && a > int64_max + b) || (b > 0 && a < int64_min + b) )
+		return false;
+	r = a - b;
+	return true;
+#endif
+}
+inline bool CheckedMul( int64_t a, int64_t b, int64_t & r )
+{
+#if defined( __GNUC__ ) && __GNUC__ >= 5
+	return !__builtin_mul_overflow( a, b, &r );
+#else
+	if( a == 0 || b == 0 )
+	{
+		r = 0;
+		return true;
+	}
+	if( (a == -1 && b == int64_min) || (b == -1 && a == int64_min) )
+		return false;
+	if( a > 0 ? (b > 0 ? a > int64_max / b : b < int64_min / a)
+		: (b > 0 ? a < int64_min / b : b < int64_max / a) )
+		return false;
+	r = a * b;
+	return true;
+#endif
+}
+
+// (NumberObject(), creating a number object from a double, is in object.h)
+
+// is a number integral?
+inline bool IsIntegral( const Object & o ) { return o.IsInt() || is_integral( o.d ); }
+
+// integral value of a number (doubles are truncated)
+inline int64_t NumToInt( const Object & o ) { return o.IsInt() ? (int64_t)o.i : (int64_t)o.d; }
+
+// exact comparison of an integer and a double: -1, 0 or 1 (a <, == or > b),
+// or 2 if they are unordered (b is NaN)
+inline int CompareIntDouble( int64_t a, double b )
+{
+	if( b != b )
+		return 2;
+	if( b >= 9223372036854775808.0 )
+		return -1;
+	if( b < -9223372036854775808.0 )
+		return 1;
+	// b is in range, compare against its integral part first
+	int64_t t = (int64_t)b;
+	if( a != t )
+		return a < t ? -1 : 1;
+	double bt = (double)t;
+	return b > bt ? -1 : (b < bt ? 1 : 0);
+}
+
+// compare two numbers: -1, 0 or 1 (lhs <, == or > rhs), or 2 if unordered
+inline int CompareNumbers( const Object & lhs, const Object & rhs )
+{
+	bool li = lhs.IsInt(), ri = rhs.IsInt();
+	if( li && ri )
+	{
+		int64_t l = lhs.i, r = rhs.i;
+		return l < r ? -1 : (l > r ? 1 : 0);
+	}
+	if( li )
+		return CompareIntDouble( lhs.i, rhs.d );
+	if( ri )
+	{
+		int c = CompareIntDouble( rhs.i, lhs.d );
+		return c == 2 ? 2 : -c;
+	}
+	double l = lhs.d, r = rhs.d;
+	if( l < r ) return -1;
+	if( l > r ) return 1;
+	if( l == r ) return 0;
+	return 2;
+}
+inline bool NumEqual( const Object & lhs, const Object & rhs )
+{
+	if( lhs.IsInt() && rhs.IsInt() )
+		return (int64_t)lhs.i == (int64_t)rhs.i;
+	return CompareNumbers( lhs, rhs ) == 0;
+}
+inline bool NumLess( const Object & lhs, const Object & rhs )
+{
+	if( lhs.IsInt() && rhs.IsInt() )
+		return (int64_t)lhs.i < (int64_t)rhs.i;
+	return CompareNumbers( lhs, rhs ) == -1;
+}
+inline bool NumLessEqual( const Object & lhs, const Object & rhs )
+{
+	if( lhs.IsInt() && rhs.IsInt() )
+		return (int64_t)lhs.i <= (int64_t)rhs.i;
+	int c = CompareNumbers( lhs, rhs );
+	return c == -1 || c == 0;
+}
+
+// arithmetic. integer operands give an integer result unless it overflows
+inline Object NumAdd( const Object & lhs, const Object & rhs )
+{
+	int64_t r;
+	if( lhs.IsInt() && rhs.IsInt() && CheckedAdd( lhs.i, rhs.i, r ) )
+		return Object( r );
+	return Object( lhs.Num() + rhs.Num() );
+}
+inline Object NumSub( const Object & lhs, const Object & rhs )
+{
+	int64_t r;
+	if( lhs.IsInt() && rhs.IsInt() && CheckedSub( lhs.i, rhs.i, r ) )
+		return Object( r );
+	return Object( lhs.Num() - rhs.Num() );
+}
+inline Object NumMul( const Object & lhs, const Object & rhs )
+{
+	int64_t r;
+	if( lhs.IsInt() && rhs.IsInt() && CheckedMul( lhs.i, rhs.i, r ) )
+		return Object( r );
+	return Object( lhs.Num() * rhs.Num() );
+}
+// (division by zero must be checked by the caller)
+inline Object NumDiv( const Object & lhs, const Object & rhs )
+{
+	if( lhs.IsInt() && rhs.IsInt() )
+	{
+		int64_t l = lhs.i, r = rhs.i;
+		// only exact quotients stay integers
+		if( r != 0 && !(l == int64_min && r == -1) && l % r == 0 )
+			return Object( l / r );
+	}
+	return Object( lhs.Num() / rhs.Num() );
+}
+// (operands must be integral and non-zero, checked by the caller)
+inline Object NumMod( const Object & lhs, const Object & rhs )
+{
+	if( lhs.IsInt() && rhs.IsInt() )
+	{
+		int64_t r = rhs.i;
+		if( r == -1 )
+			return Object( (int64_t)0 );
+		return Object( (int64_t)lhs.i % r );
+	}
+	return Object( (double)((int)lhs.Num() % (int)rhs.Num()) );
+}
+inline Object NumNeg( const Object & o )
+{
+	// (zero negates to negative zero, which is only a double)
+	if( o.IsInt() && (int64_t)o.i != int64_min && (int64_t)o.i != 0 )
+		return Object( -(int64_t)o.i );
+	return Object( -o.Num() );
+}
+inline Object NumInc( const Object & o )
+{
+	if( o.IsInt() && (int64_t)o.i != int64_max )
+		return Object( (int64_t)o.i + 1 );
+	return Object( o.Num() + 1 );
+}
+inline Object NumDec( const Object & o )
+{
+	if( o.IsInt() && (int64_t)o.i != int64_min )
+		return Object( (int64_t)o.i - 1 );
+	return Object( o.Num() - 1 );
+}
+
+} // namespace deva
+
+#endif // __NUMBER_H__
@@ -0,0 +1,117 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// numeric.h
+// numeric kernels over arrays of doubles (packed vectors' numbers)
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#ifndef __NUMERIC_H__
+#define __NUMERIC_H__
+
+#include <cstddef>
+
+
+namespace deva
+{
+
+
+// the reductions (sum and dot product) use SSE2 or AVX where the cpu has them
+// (chosen at run-time), otherwise a scalar loop. as with any re-ordered sum,
+// the result can differ from a left-to-right sum in the last bits (and so
+// from one cpu to another), unless 'precise' reductions are turned on
+double SumNumbers( const double* a, size_t n );
+double DotNumbers( const double* a, const double* b, size_t n );
+// make the reductions strictly left-to-right sums, and the math functions
+// over vectors call the scalar functions ('deva --precise')
+void SetPreciseReductions( bool precise );
+bool PreciseReductions();
+
+// index of the (first) smallest/largest number. 'n' must be non-zero
+size_t MinIndex( const double* a, size_t n );
+size_t MaxIndex( const double* a, size_t n );
+
+// element-wise operations, into 'out' (which can be the same as an input).
+// these are simple loops, which the compiler vectorizes
+void AddNumbers( double* out, const double* a, const double* b, size_t n );
+void SubNumbers( double* out, const double* a, const double* b, size_t n );
+void MulNumbers( double* out, const double* a, const double* b, size_t n );
+void AddScalar( double* out, const double* a, double k, size_t n );
+void MulScalar( double* out, const double* a, double k, size_t n );
+void ClipNumbers( double* out, const double* a, double lo, double hi, size_t n );
+// running sum
+void CumSum( double* out, const double* a, size_t n );
+
+// the loops below, calling the function through a pointer (from another
+// file, so it can't be vectorized), for precise results
+void MapNumbersPrecise( double* out, const double* a, size_t n, double (*f)( double ) );
+void ZipNumbersPrecise( double* out, const double* a, double ka, const double* b, double kb, size_t n, double (*f)( double, double ) );
+
+// apply a function to each number. the function is a template argument, so
+// the loop calls it directly: in release builds (-O3 -ffast-math) with glibc,
+// loops over the standard math functions are vectorized with its SIMD
+// versions (libmvec), which can be a few units in the last place out. other
+// builds, and precise mode, call the scalar functions
+template<double (*F)( double )>
+inline void MapNumbers( double* out, const double* a, size_t n )
+{
+	if( PreciseReductions() )
+	{
+		MapNumbersPrecise( out, a, n, F );
+		return;
+	}
+	for( size_t i = 0; i < n; i++ )
+		out[i] = F( a[i] );
+}
+
+// the same for two argument functions, with (one or the other of) the args
+// being a single number for every item if 'a' or 'b' is NULL
+template<double (*F)( double, double )>
+inline void ZipNumbers( double* out, const double* a, double ka, const double* b, double kb, size_t n )
+{
+	if( PreciseReductions() )
+		ZipNumbersPrecise( out, a, ka, b, kb, n, F );
+	else if( a && b )
+	{
+		for( size_t i = 0; i < n; i++ )
+			out[i] = F( a[i], b[i] );
+	}
+	else if( a )
+	{
+		for( size_t i = 0; i < n; i++ )
+			out[i] = F( a[i], kb );
+	}
+	else
+	{
+		for( size_t i = 0; i < n; i++ )
+			out[i] = F( ka, b[i] );
+	}
+}
+
+
+} // end namespace deva
+
+#endif // __NUMERIC_H__
@@ -32,8 +32,10 @@
 #define __OBJECT_H__
 
 #include "opcodes.h"
+#include "fpbits.h"
 #include "ordered_set.h"
 #include "refcounted.h"
+#include "small_vector.h"
 
 #include <string>
 #include <vector>
@@ -69,6 +71,8 @@ enum ObjectType
 	obj_symbol_name,		// an identifier, same data as a string
 	obj_module,				// an imported module
 	obj_native_module,		// a native (C/C++) module
+	obj_buffer,				// a buffer of (binary) bytes
+	obj_stringbuilder,		// a string under construction
 	obj_end = 255			// end of enum marker
 };
 
@@ -86,10 +90,15 @@ struct Module;
 struct NativeModule;
 class VectorBase;
 class MapBase;
+class BufferBase;
+class StringBuilderBase;
+class Shape;
 
 // types needed by Object class
 typedef RefCounted<VectorBase> Vector;
 typedef RefCounted<MapBase> Map;
+typedef RefCounted<BufferBase> Buffer;
+typedef RefCounted<StringBuilderBase> StringBuilder;
 typedef void (*NativeFunctionPtr)(Frame*);
 struct NativeFunction
 {
@@ -97,12 +106,68 @@ struct NativeFunction
 	bool is_method; 
 };
 
+#ifdef DEVA_NAN_BOXING
+} // namespace deva
+#include "nanbox.h"
+namespace deva
+{
+#endif
+
 struct Object
 {
+#ifdef DEVA_NAN_BOXING
+	// NaN-boxed (8 byte) representation, see nanbox.h
+	union
+	{
+		qword bits;
+		nanbox::TypeField type;
+		nanbox::NumberField d;						// obj_number
+		nanbox::IntField i;							// obj_number (integer)
+		nanbox::PointerField<char> s;				// obj_string / obj_symbol_name
+		nanbox::BoolField b;						// obj_boolean
+		nanbox::PointerField<Vector> v;				// obj_vector
+		nanbox::PointerField<Map> m;				// obj_map / obj_class / obj_instance
+		nanbox::PointerField<Function> f;			// obj_function
+		nanbox::NativeFunctionField nf;				// obj_native_function
+		nanbox::PointerField<void> no;				// obj_native_obj
+		nanbox::SizeField sz;						// obj_size
+		nanbox::PointerField<Module> mod;			// obj_module
+		nanbox::PointerField<NativeModule> nm;		// obj_native_module
+		nanbox::MarkedPointerField<Buffer> buf;		// obj_buffer
+		nanbox::MarkedPointerField<StringBuilder> sb;	// obj_stringbuilder
+	};
+
+	Object() : bits( nanbox::Box( obj_end, 0 ) ) {} // invalid object
+	explicit Object( ObjectType t ) : bits( t == obj_number ? 0 : nanbox::Box( t, 0 ) ) // uninitialized object
+	{ /*assert( t == obj_null );*/ }
+	explicit Object( double n ) : bits( nanbox::BoxNumber( n ) ) {}
+	explicit Object( int64_t n ) : bits( nanbox::BoxInteger( n ) ) {}
+	explicit Object( char* n ) : bits( nanbox::Box( obj_string, (qword)(size_t)n ) ) {}
+	explicit Object( const char* n ) : bits( nanbox::Box( obj_string, (qword)(size_t)n ) ) {}
+	explicit Object( bool n ) : bits( nanbox::Box( obj_boolean, n ) ) {}
+	explicit Object( Vector* n ) : bits( nanbox::Box( obj_vector, (qword)(size_t)n ) ) {}
+	explicit Object( Map* n ) : bits( nanbox::Box( obj_map, (qword)(size_t)n ) ) {}
+	explicit Object( Function* n ) : bits( nanbox::Box( obj_function, (qword)(size_t)n ) ) {}
+	explicit Object( NativeFunction n ) : bits( nanbox::BoxNativeFunction( n.p, n.is_method ) ) {}
+	explicit Object( NativeFunctionPtr n, bool method = false ) : bits( nanbox::BoxNativeFunction( n, method ) ) {}
+	explicit Object( void* n ) : bits( nanbox::Box( obj_native_obj, (qword)(size_t)n ) ) {}
+	explicit Object( size_t n ) : bits( nanbox::Box( obj_size, (qword)n ) ) {}
+	explicit Object( Module* m ) : bits( nanbox::Box( obj_module, (qword)(size_t)m ) ) {}
+	explicit Object( NativeModule* m ) : bits( nanbox::Box( obj_native_module, (qword)(size_t)m ) ) {}
+	explicit Object( Buffer* n ) : bits( nanbox::Box( obj_buffer, (qword)(size_t)n ) ) {}
+	explicit Object( StringBuilder* n ) : bits( nanbox::Box( obj_stringbuilder, (qword)(size_t)n ) ) {}
+	explicit Object( ObjectType t, char* n ) : bits( nanbox::Box( obj_symbol_name, (qword)(size_t)n ) )
+	{ /*assert( t == obj_symbol_name );*/ }
+	explicit Object( ObjectType t, const char* n ) : bits( nanbox::Box( obj_symbol_name, (qword)(size_t)n ) )
+	{ /*assert( t == obj_symbol_name );*/ }
+#else
 	ObjectType type;
+	// (obj_number) the number is an integer, stored in 'i' rather than 'd'
+	bool is_int;
 	union
 	{
 		double d;			// obj_number
+		int64_t i;			// obj_number (integer)
 		char* s;			// obj_string / obj_symbol_name
 		int b;				// obj_boolean - valgrind gets cranky if you use 'bool' here
 		Vector* v;			// obj_vector
@@ -113,28 +178,34 @@ struct Object
 		size_t sz;			// obj_size
 		Module* mod;		// obj_module
 		NativeModule* nm;	// obj_native_module
+		Buffer* buf;		// obj_buffer
+		StringBuilder* sb;	// obj_stringbuilder
 	};
 
-	Object() : type( obj_end ), d( 0.0 ) {} // invalid object
-	explicit Object( ObjectType t ) : type( t ), d( 0.0 ) // uninitialized object
+	Object() : type( obj_end ), is_int( false ), d( 0.0 ) {} // invalid object
+	explicit Object( ObjectType t ) : type( t ), is_int( false ), d( 0.0 ) // uninitialized object
 	{ /*assert( t == obj_null );*/ }
-	explicit Object( double n ) : type( obj_number ), d( n ) {}
-	explicit Object( char* n ) : type( obj_string ), s( n ) {}
-	explicit Object( const char* n ) : type( obj_string ), s( const_cast<char*>(n) ) {}
-	explicit Object( bool n ) : type( obj_boolean ), b( n ) {}
-	explicit Object( Vector* n ) : type( obj_vector ), v( n ) {}
-	explicit Object( Map* n ) : type( obj_map ), m( n ) {}
-	explicit Object( Function* n ) : type( obj_function ), f( n ) {}
-	explicit Object( NativeFunction n ) : type( obj_native_function ), nf( n ) {}
-	explicit Object( NativeFunctionPtr n, bool method = false ) : type( obj_native_function ) { nf.p = n; nf.is_method = method; }
-	explicit Object( void* n ) : type( obj_native_obj ), no( n ) {}
-	explicit Object( size_t n ) : type( obj_size ), sz( n ) {}
-	explicit Object( Module* m ) : type( obj_module ), mod( m ) {}
-	explicit Object( NativeModule* m ) : type( obj_native_module ), nm( m ) {}
-	explicit Object( ObjectType t, char* n ) : type( obj_symbol_name ), s( n )
+	explicit Object( double n ) : type( obj_number ), is_int( false ), d( n ) {}
+	explicit Object( int64_t n ) : type( obj_number ), is_int( true ), i( n ) {}
+	explicit Object( char* n ) : type( obj_string ), is_int( false ), s( n ) {}
+	explicit Object( const char* n ) : type( obj_string ), is_int( false ), s( const_cast<char*>(n) ) {}
+	explicit Object( bool n ) : type( obj_boolean ), is_int( false ), b( n ) {}
+	explicit Object( Vector* n ) : type( obj_vector ), is_int( false ), v( n ) {}
+	explicit Object( Map* n ) : type( obj_map ), is_int( false ), m( n ) {}
+	explicit Object( Function* n ) : type( obj_function ), is_int( false ), f( n ) {}
+	explicit Object( NativeFunction n ) : type( obj_native_function ), is_int( false ), nf( n ) {}
+	explicit Object( NativeFunctionPtr n, bool method = false ) : type( obj_native_function ), is_int( false ) { nf.p = n; nf.is_method = method; }
+	explicit Object( void* n ) : type( obj_native_obj ), is_int( false ), no( n ) {}
+	explicit Object( size_t n ) : type( obj_size ), is_int( false ), sz( n ) {}
+	explicit Object( Module* m ) : type( obj_module ), is_int( false ), mod( m ) {}
+	explicit Object( NativeModule* m ) : type( obj_native_module ), is_int( false ), nm( m ) {}
+	explicit Object( Buffer* n ) : type( obj_buffer ), is_int( false ), buf( n ) {}
+	explicit Object( StringBuilder* n ) : type( obj_stringbuilder ), is_int( false ), sb( n ) {}
+	explicit Object( ObjectType t, char* n ) : type( obj_symbol_name ), is_int( false ), s( n )
 	{ /*assert( t == obj_symbol_name );*/ }
-	explicit Object( ObjectType t, const char* n ) : type( obj_symbol_name ), s( const_cast<char*>(n) )
+	explicit Object( ObjectType t, const char* n ) : type( obj_symbol_name ), is_int( false ), s( const_cast<char*>(n) )
 	{ /*assert( t == obj_symbol_name );*/ }
+#endif
 
 	// creation functions for classes & instances
 	// (which are maps internally)
@@ -156,10 +227,23 @@ struct Object
 	inline bool IsSize(){ return type == obj_size; }
 	inline bool IsModule(){ return type == obj_module; }
 	inline bool IsNativeModule(){ return type == obj_native_module; }
+	inline bool IsBuffer(){ return type == obj_buffer; }
+	inline bool IsStringBuilder(){ return type == obj_stringbuilder; }
+
+	// numbers are stored either as a double or as a 64-bit integer. the
+	// integer form is internal only (see number.h), use Num() to read any
+	// number as a double
+#ifdef DEVA_NAN_BOXING
+	inline bool IsInt() const { return nanbox::IsBoxedInt( bits ); }
+	inline double Num() const { return d; }
+#else
+	inline bool IsInt() const { return type == obj_number && is_int; }
+	inline double Num() const { return is_int ? (double)i : d; }
+#endif
 
 	inline operator const bool (){ return (b != 0); }
-	inline operator const double (){ return d; }
-	inline operator const string (){ return s; }
+	inline operator const double (){ return Num(); }
+	inline operator const string (){ return string( s ); }
 	inline operator const Vector* (){ return v; }
 	inline operator const Map* (){ return m; }
 	inline operator const Function* (){ return f; }
@@ -176,6 +260,21 @@ struct Object
 	bool CoerceToBool();
 };
 
+#ifdef DEVA_NAN_BOXING
+// ensure the NaN-boxed representation really is a single word
+typedef char nanbox_object_size_check[sizeof( Object ) == sizeof( qword ) ? 1 : -1];
+#endif
+
+// create a number object, using the integer form if the value is integral
+// and in range (negative zero stays a double)
+inline Object NumberObject( double d )
+{
+	if( !IsNaN( d ) && d >= -9223372036854775808.0 && d < 9223372036854775808.0 
+		&& d == (double)(int64_t)d && !IsNegativeZero( d ) )
+		return Object( (int64_t)d );
+	return Object( d );
+}
+
 // functor for comparing Object ptrs
 struct DO_ptr_lt
 {
@@ -189,31 +288,245 @@ ostream & operator << ( ostream & os, const Object & obj );
 ostream & operator << ( ostream & os, ObjectType t );
 
 
+// key ordering for maps/classes/instances: string and symbol name keys with
+// the same text are the same key ('a.b' is syntactic sugar for 'a["b"]'), so
+// member look-ups need only a single probe. the key objects keep their type,
+// so keys() and printing still show what was stored
+struct MapKeyLess
+{
+	static inline ObjectType KeyType( ObjectType t ) { return t == obj_symbol_name ? obj_string : t; }
+	static inline bool Equal( const Object & lhs, const Object & rhs )
+	{
+		if( KeyType( lhs.type ) == obj_string && KeyType( rhs.type ) == obj_string )
+			return strcmp( lhs.s, rhs.s ) == 0;
+		return lhs.operator == ( rhs );
+	}
+	inline bool operator()( const Object & lhs, const Object & rhs ) const
+	{
+		ObjectType lt = KeyType( lhs.type );
+		ObjectType rt = KeyType( rhs.type );
+		if( lt != rt )
+			return lt < rt;
+		if( lt == obj_string )
+			return strcmp( lhs.s, rhs.s ) < 0;
+		return lhs.operator < ( rhs );
+	}
+};
+
 struct Object;
 
+// number of items a vector holds without a separate heap allocation. four
+// covers nearly 90% of the vector literals in the tests and library code
+// (pairs, 'next' results, multiple return values etc)
+const size_t vector_inline_size = 4;
+
 // TODO: should this be a list<>? dequeue<>?
-class VectorBase : public vector<Object>
+// largest integer a packed vector holds exactly (2^53)
+const int64_t max_packed_int = 9007199254740992LL;
+
+// vectors hold their items as Objects (in a SmallVector, so the items of small
+// vectors need no allocation of their own) or, while every item is a number,
+// 'packed' into a contiguous array of doubles, so that numeric code runs over
+// plain data and the items need no ref-counting. the std::vector style
+// interface works on the Objects, so using it on a packed vector unpacks it
+// (for good). Get(), Set(), push_back() and the size functions work on either
+// form.
+//
+// the items are kept in a store inside the vector itself. copying a vector
+// whose items are on the heap moves them to a separate, ref-counted store,
+// which the copies share until one of them is modified (copy-on-write), so
+// only vectors that really are shared pay for another allocation. (the items
+// of small vectors are in the inline storage, they are just copied.) the
+// store holds the refs on the items, so sharing it costs nothing. every
+// non-const member that can modify the items first gives the vector a store
+// of its own.
+//
+// a slice of a vector can be a 'view': it shares the vector's store and sees
+// every 'stride'th item, starting at 'start'. Get() and the size functions
+// read through the view, anything else first copies the viewed items into a
+// store of the view's own
+class VectorBase
 {
+public:
+	typedef SmallVector<Object, vector_inline_size> Items;
+	typedef Items::value_type value_type;
+	typedef Items::size_type size_type;
+	typedef Items::difference_type difference_type;
+	typedef Items::reference reference;
+	typedef Items::const_reference const_reference;
+	typedef Items::iterator iterator;
+	typedef Items::const_iterator const_iterator;
+	typedef Items::reverse_iterator reverse_iterator;
+	typedef Items::const_reverse_iterator const_reverse_iterator;
+
+private:
+	// (possibly shared) item storage
+	struct Store
+	{
+		// number of vectors sharing this store
+		int refs;
+		// the items when unpacked
+		Items items;
+		// the items when packed
+		vector<double> numbers;
+		bool packed;
+
+		Store() : refs( 1 ), packed( false ) {}
+	};
+
 	// current index for enumerating the vector
 	size_t index;
 	friend void do_vector_rewind( Frame* );
 	friend void do_vector_next( Frame* );
 
+	// the vector's own store, and the store in use: 'own' or a shared one
+	// (in which case 'own' is empty)
+	mutable Store own;
+	mutable Store* store;
+	// view of the store: the first item, the number of items and the distance
+	// between them. 'stride' is zero if the vector isn't a view (it sees the
+	// whole store)
+	mutable size_t start, count, stride;
+
+	// index in the store of item 'n'
+	inline size_t Index( size_t n ) const { return stride ? start + n * stride : n; }
+	// give this vector a store of its own, before modifying the items
+	inline void Own() { if( stride || store->refs > 1 ) Separate(); }
+	// give a view a store of its own, before accessing the items directly
+	inline void Flatten() const { if( stride ) Separate(); }
+	void Separate() const;
+	// move the items to a store that can be shared, if they're in 'own'
+	void MakeShareable() const;
+	// share (or, if they're inline, copy) the items 'v' sees
+	void Share( const VectorBase & v );
+
+	// no assignment
+	VectorBase & operator = ( const VectorBase & );
+
 public:
 	// default constructor
-	VectorBase() : vector<Object>(), index( 0 ) {}
+	VectorBase() : index( 0 ), store( &own ), start( 0 ), count( 0 ), stride( 0 ) {}
 
-	// copy constructor
-	VectorBase( const VectorBase & v ) : vector<Object>( v ), index( 0 ) {}
+	// copy constructor (shares the items)
+	VectorBase( const VectorBase & v ) : index( 0 ), store( &own ), start( 0 ), count( 0 ), stride( 0 ) { Share( v ); }
 
 	// create with 'n' empty items
-	VectorBase( size_t n ) : vector<Object>( n ), index( 0 ) {}
+	VectorBase( size_t n ) : index( 0 ), store( &own ), start( 0 ), count( 0 ), stride( 0 ) { store->items.resize( n ); }
 
 	// create with 'n' items of 'o'
-	VectorBase( size_t n, Object & o ) : vector<Object>( n, o ), index( 0 ) {}
+	VectorBase( size_t n, Object & o ) : index( 0 ), store( &own ), start( 0 ), count( 0 ), stride( 0 )
+	{
+		store->packed = n > vector_inline_size && IsPackable( o );
+		if( store->packed )
+			store->numbers.assign( n, o.Num() );
+		else
+			store->items.resize( n, o );
+	}
+
+	// 'slice constructor': every 'step'th item from 'start' to 'end' of 'v'
+	// (see object.cpp)
+	VectorBase( const VectorBase & v, size_t start, size_t end, size_t step = 1 );
+
+	~VectorBase() { if( store != &own && --store->refs == 0 ) delete store; }
+
+	// copy-on-write sharing
+	// is the store shared with other vectors?
+	inline bool IsShared() const { return store->refs > 1; }
+	// is this vector a view of (part of) a store?
+	inline bool IsView() const { return stride != 0; }
+	// release the store's refs on its items, for a vector about to be
+	// destroyed (a shared store keeps them, for the other sharers)
+	void ReleaseItems();
+
+	// packing (see object.cpp)
+	// can an object be stored in a packed vector without losing anything?
+	static inline bool IsPackable( const Object & o )
+	{
+		return o.type == obj_number && (!o.IsInt() || ((int64_t)o.i <= max_packed_int && (int64_t)o.i >= -max_packed_int));
+	}
+	inline bool IsPacked() const { return store->packed; }
+	// pack the vector, if all its items are numbers. returns whether it is packed
+	bool Pack();
+	// convert a packed vector to Objects (the contents are unchanged, so a
+	// shared store is converted in place)
+	inline void Unpack() const { if( store->packed ) DoUnpack(); }
+	void DoUnpack() const;
+	// the numbers of a packed vector
+	inline const vector<double> & Numbers() const { Flatten(); return store->numbers; }
+	inline vector<double> & MutableNumbers() { Own(); return store->numbers; }
+
+	// item access that doesn't unpack (or copy a view)
+	inline Object Get( size_t n ) const
+	{
+		if( store->packed )
+			return NumberObject( store->numbers[Index( n )] );
+		return store->items[Index( n )];
+	}
+	inline void Set( size_t n, const Object & o )
+	{
+		Own();
+		if( store->packed )
+		{
+			if( IsPackable( o ) )
+			{
+				store->numbers[n] = o.Num();
+				return;
+			}
+			DoUnpack();
+		}
+		store->items[n] = o;
+	}
 
-	// 'slice constructor'
-	VectorBase( const VectorBase & v, size_t start, size_t end ) : vector<Object>( v.begin() + start, v.begin() + end ), index( 0 ) {}
+	// std::vector interface
+	inline size_type size() const { return stride ? count : store->packed ? store->numbers.size() : store->items.size(); }
+	inline bool empty() const { return size() == 0; }
+	inline size_type capacity() const { return stride ? count : store->packed ? store->numbers.capacity() : store->items.capacity(); }
+	inline void reserve( size_type n ) { Own(); if( store->packed ) store->numbers.reserve( n ); else store->items.reserve( n ); }
+	inline void clear() { Own(); if( store->packed ) store->numbers.clear(); else store->items.clear(); }
+	inline void pop_back() { Own(); if( store->packed ) store->numbers.pop_back(); else store->items.pop_back(); }
+	inline void push_back( const Object & o )
+	{
+		Own();
+		if( store->packed )
+		{
+			if( IsPackable( o ) )
+			{
+				store->numbers.push_back( o.Num() );
+				return;
+			}
+			DoUnpack();
+		}
+		store->items.push_back( o );
+	}
+	inline void resize( size_type n, const Object & o = Object() ) { Own(); Unpack(); store->items.resize( n, o ); }
+
+	inline iterator begin() { Own(); Unpack(); return store->items.begin(); }
+	inline const_iterator begin() const { Flatten(); Unpack(); return store->items.begin(); }
+	inline iterator end() { Own(); Unpack(); return store->items.end(); }
+	inline const_iterator end() const { Flatten(); Unpack(); return store->items.end(); }
+	inline reverse_iterator rbegin() { Own(); Unpack(); return store->items.rbegin(); }
+	inline const_reverse_iterator rbegin() const { Flatten(); Unpack(); return store->items.rbegin(); }
+	inline reverse_iterator rend() { Own(); Unpack(); return store->items.rend(); }
+	inline const_reverse_iterator rend() const { Flatten(); Unpack(); return store->items.rend(); }
+
+	inline reference operator [] ( size_type n ) { Own(); Unpack(); return store->items[n]; }
+	inline const_reference operator [] ( size_type n ) const { Flatten(); Unpack(); return store->items[n]; }
+	inline reference at( size_type n ) { Own(); Unpack(); return store->items.at( n ); }
+	inline const_reference at( size_type n ) const { Flatten(); Unpack(); return store->items.at( n ); }
+	inline reference front() { Own(); Unpack(); return store->items.front(); }
+	inline const_reference front() const { Flatten(); Unpack(); return store->items.front(); }
+	inline reference back() { Own(); Unpack(); return store->items.back(); }
+	inline const_reference back() const { Flatten(); Unpack(); return store->items.back(); }
+
+	// (the iterators passed in come from begin()/end(), so the store is
+	// already unshared and unpacked)
+	inline iterator insert( iterator pos, const Object & o ) { return store->items.insert( pos, o ); }
+	inline void insert( iterator pos, size_type n, const Object & o ) { store->items.insert( pos, n, o ); }
+	template<typename It> void insert( iterator pos, It b, It e ) { store->items.insert( pos, b, e ); }
+	inline iterator erase( iterator pos ) { return store->items.erase( pos ); }
+	inline iterator erase( iterator b, iterator e ) { return store->items.erase( b, e ); }
+	// is the (unpacked) data held in the inline storage?
+	inline bool is_inline() const { return !stride && !store->packed && store->items.is_inline(); }
 };
 
 // functions to create Vector objects
@@ -222,24 +535,188 @@ inline Vector* CreateVector( Vector & v ) { return Vector::Create( v ); }
 inline Vector* CreateVector( size_t n ) { return Vector::Create( n ); }
 inline Vector* CreateVector( size_t n, Object & o ) { return Vector::Create( n, o ); }
 inline Vector* CreateVector( Vector & v, size_t start, size_t end ) { return Vector::Create( v, start, end ); }
+inline Vector* CreateVector( Vector & v, size_t start, size_t end, size_t step ) { return Vector::Create( v, start, end, step ); }
+
+// buffers are immutable runs of bytes, for binary data (file i/o etc), held
+// in a single allocation. slicing a buffer creates a view, which shares the
+// bytes and holds a reference on the buffer that owns them
+class BufferBase
+{
+	// the bytes
+	unsigned char* bytes;
+	size_t length;
+	// the buffer owning the bytes of a view, NULL if this buffer owns them
+	RefCounted<BufferBase>* owner;
+
+	// no assignment
+	BufferBase & operator = ( const BufferBase & );
+
+public:
+	// default constructor
+	BufferBase() : bytes( NULL ), length( 0 ), owner( NULL ) {}
+
+	// copy constructor (copies the bytes)
+	BufferBase( const BufferBase & b );
+
+	// create with 'n' zero bytes
+	BufferBase( size_t n );
+
+	// 'slice constructor' (a view of bytes 'start' to 'end' of 'b')
+	BufferBase( BufferBase & b, size_t start, size_t end );
+
+	~BufferBase();
+
+	inline size_t size() const { return length; }
+	inline bool empty() const { return length == 0; }
+	inline const unsigned char* data() const { return bytes; }
+	inline unsigned char operator [] ( size_t n ) const { return bytes[n]; }
+	inline bool IsView() const { return owner != NULL; }
+	// the bytes of a newly created buffer, for filling it in. buffers are
+	// immutable once they have been handed out
+	inline unsigned char* MutableData() { return bytes; }
+
+	// compare contents: < 0, 0 or > 0 for less than, equal or greater than 'b'
+	int Compare( const BufferBase & b ) const;
+};
+
+// functions to create Buffer objects
+inline Buffer* CreateBuffer( size_t n ) { return Buffer::Create( n ); }
+inline Buffer* CreateBuffer( Buffer & b ) { return Buffer::Create( b ); }
+inline Buffer* CreateBuffer( Buffer & b, size_t start, size_t end ) { return Buffer::Create( b, start, end ); }
+// create a buffer holding a copy of 'n' bytes at 'p'
+inline Buffer* CreateBuffer( const void* p, size_t n )
+{
+	Buffer* b = Buffer::Create( n );
+	if( n )
+		memcpy( b->MutableData(), p, n );
+	return b;
+}
+
+// string builders accumulate a string in a buffer that grows geometrically, so
+// that building a long string a piece at a time takes linear time (rather than
+// copying the whole string for every piece, as adding strings does)
+class StringBuilderBase
+{
+	string text;
+
+public:
+	StringBuilderBase() {}
+	// copy constructor
+	StringBuilderBase( const StringBuilderBase & sb ) : text( sb.text ) {}
+
+	inline size_t size() const { return text.size(); }
+	inline bool empty() const { return text.empty(); }
+	inline const string & str() const { return text; }
+	inline void Append( const char* s, size_t n )
+	{
+		// (grow by doubling, whatever the string implementation does)
+		if( text.size() + n > text.capacity() )
+			text.reserve( 2 * (text.size() + n) );
+		text.append( s, n );
+	}
+	inline void Append( const string & s ) { Append( s.data(), s.size() ); }
+	inline void Clear() { text.clear(); }
+};
+
+// functions to create StringBuilder objects
+inline StringBuilder* CreateStringBuilder() { return StringBuilder::Create(); }
 
 // TODO: make this a boost::unordered_map (hash map)
 // (need to implement a boost hash_function for Objects)
-class MapBase : public map<Object, Object>
+//
+// like vectors, copies of a map share its pairs until one of them is modified
+// (copy-on-write), see VectorBase
+class MapBase
 {
+public:
+	typedef map<Object, Object, MapKeyLess> Pairs;
+	typedef Pairs::key_type key_type;
+	typedef Pairs::mapped_type mapped_type;
+	typedef Pairs::value_type value_type;
+	typedef Pairs::size_type size_type;
+	typedef Pairs::iterator iterator;
+	typedef Pairs::const_iterator const_iterator;
+
+private:
+	// (possibly shared) pair storage
+	struct Store
+	{
+		// number of maps sharing this store
+		int refs;
+		Pairs pairs;
+
+		Store() : refs( 1 ) {}
+	};
+
 	// current index for enumerating the map pairs
 	size_t index;
 	friend void do_map_rewind( Frame* );
 	friend void do_map_next( Frame* );
 
+	// the map's own store, and the store in use (see VectorBase)
+	mutable Store own;
+	mutable Store* store;
+
+	// shape ('hidden class') of an instance's fields, NULL if the map is in
+	// 'dictionary mode' (plain maps, classes and instances whose fields have
+	// been removed or have grown too numerous)
+	Shape* shape;
+	// ptrs to the field values described by the shape, in slot order
+	// (map nodes don't move, so these stay valid until a key is erased or the
+	// map gets a store of its own)
+	vector<Object*> slots;
+
+	// give this map a store of its own, before modifying the pairs
+	inline void Own() { if( store->refs > 1 ) Separate(); }
+	void Separate();
+	// move the pairs to a store that can be shared, if they're in 'own'
+	void MakeShareable() const;
+
+	// no assignment
+	MapBase & operator = ( const MapBase & );
+
 public:
 	// default constructor
-	MapBase() : map<Object, Object>(), index( 0 )
+	MapBase() : index( 0 ), store( &own ), shape( NULL )
 	{}
 
-	// copy constructor
-	MapBase( const MapBase & m ) : map<Object, Object>( m ), index( 0 )
-	{}
+	// copy constructor (shares the pairs)
+	MapBase( const MapBase & m ) : index( 0 ), store( NULL ), shape( NULL )
+	{ m.MakeShareable(); store = m.store; store->refs++; }
+
+	~MapBase() { if( store != &own && --store->refs == 0 ) delete store; }
+
+	// copy-on-write sharing (see VectorBase)
+	inline bool IsShared() const { return store->refs > 1; }
+	inline void Unshare() { store->refs--; store = &own; MakeDictionary(); }
+
+	// std::map interface
+	inline size_type size() const { return store->pairs.size(); }
+	inline bool empty() const { return store->pairs.empty(); }
+	inline size_type count( const key_type & k ) const { return store->pairs.count( k ); }
+	inline iterator begin() { Own(); return store->pairs.begin(); }
+	inline const_iterator begin() const { return store->pairs.begin(); }
+	inline iterator end() { Own(); return store->pairs.end(); }
+	inline const_iterator end() const { return store->pairs.end(); }
+	inline iterator find( const key_type & k ) { Own(); return store->pairs.find( k ); }
+	inline const_iterator find( const key_type & k ) const { return store->pairs.find( k ); }
+	inline mapped_type & operator [] ( const key_type & k ) { Own(); return store->pairs[k]; }
+	inline pair<iterator, bool> insert( const value_type & v ) { Own(); return store->pairs.insert( v ); }
+	template<typename It> void insert( It b, It e ) { Own(); store->pairs.insert( b, e ); }
+	inline void erase( iterator i ) { store->pairs.erase( i ); }
+	inline size_type erase( const key_type & k ) { Own(); return store->pairs.erase( k ); }
+	inline void clear() { Own(); store->pairs.clear(); }
+
+	// shape handling (see shape.cpp)
+	inline Shape* GetShape() { return shape; }
+	inline const Object & GetSlot( size_t slot ) const { return *slots[slot]; }
+	inline Object & MutableSlot( size_t slot ) { Own(); return *slots[slot]; }
+	// build a shape from the current contents
+	void InitShape();
+	// move to the shape for a newly inserted field
+	void AddToShape( const Object & key, Object* val );
+	// drop into dictionary mode (must be done before erasing any keys)
+	inline void MakeDictionary() { shape = NULL; slots.clear(); }
 };
 
 // functions to create Map objects
@@ -250,7 +727,6 @@ inline Map* CreateMap( Map & m ) { return Map::Create( m ); }
 // helper functions for reference counting
 extern bool last_op_was_return;
 void IncRef( Object & o );
-void IncRefChildren( Object & o );
 int DecRef( Object & o );
 
 struct Module;
@@ -273,6 +749,9 @@ struct Function
 	vector<string> local_names;
 	// offset in code section of the code for this function
 	dword addr;
+	// number of call sites the optimizer inlined this function at
+	// (not saved in .dvc files)
+	dword inlined;
 
 	// module name, empty if 'main'
 	string modulename;
@@ -281,7 +760,7 @@ struct Function
 	// it won't be set until the first call to it)
 	Module* module;
 
-	Function() : first_line( 0 ), num_args( 0 ), addr( 0 ), module( NULL ) {}
+	Function() : first_line( 0 ), num_args( 0 ), addr( 0 ), inlined( 0 ), module( NULL ) {}
 
 	inline bool IsMethod() { return !classname.empty(); }
 	inline bool InModule() { return !modulename.empty() && module; }
@@ -32,6 +32,7 @@
 #define __OPCODES_H__
 
 #include "typedefs.h"
+#include <cstddef>
 
 
 namespace deva
@@ -40,9 +41,16 @@ namespace deva
 
 // instruction opcodes
 /////////////////////////////////////////////////////////////////////////////
-// opcodes in the bytecode are stored as a byte with optional dword operands
-// <OppN> = (dword) operand N
+// opcodes in the bytecode are stored as a byte with optional operands
+// <OppN> = operand N
 // tos = top of stack, tosN = N down from top-of-stack
+//
+// the compiler emits dword operands. the code the executor runs (and that is
+// stored in .dvc files) is re-encoded in a compact form, in which operands
+// are a single signed byte, unless the instruction is prefixed by op_wide,
+// when they are dwords. addresses in operands are relative to the start of
+// the instruction (its prefix, if it has one), only function addresses (in
+// Function objects) are offsets in the code block
 
 // NOTE: if opcodes are added/removed, they also need to be added/removed from the
 // array of opcode names immediately below
@@ -119,11 +127,11 @@ enum Opcode
 	op_for_iter,	// tos has iterable object, call next() on it & push value onto tos - for single loop var loops (e.g. 'for( i in k)')
 	op_for_iter_pair,// tos has iterable object, call next() on it & push value onto tos - for double loop var loops (e.g. 'for( i,j in k)')
 
-	op_tbl_load,	// tos = tos1[tos]
+	op_tbl_load,	// tos = tos1[tos], using field cache <Op0> of the code block
 	op_method_load,	// load method from a tbl. tos = tos1[tos], but leaves tos1 ('self') on the stack
 	op_loadslice2,	// tos = tos2[tos1:tos]
 	op_loadslice3,	// tos = tos3[tos2:tos1:tos]
-	op_tbl_store,	// tos2[tos1] = tos
+	op_tbl_store,	// tos2[tos1] = tos, using field cache <Op0> of the code block
 	op_storeslice2,	// 
 	op_storeslice3,
 	// augmented assignment for table stores
@@ -149,7 +157,20 @@ enum Opcode
 
 	op_def_class,
 
-	// 120 (update as opcodes are added above)
+	op_inline_guard,	// if the symbol named by const <Op0> isn't bound to the function of that name in this module, jump to <Op1> (the inlined call)
+
+	// arithmetic and comparison on operands the optimizer found to be numbers
+	// (if they aren't, these do the same as the general ops):
+	op_add_num, op_sub_num, op_mul_num, op_div_num, op_mod_num,
+	op_lt_num, op_lte_num, op_gt_num, op_gte_num,
+
+	// 'for' loops over 'range( <args> )':
+	op_for_range_init,	// tos is 'range', <Op0> args below it. if it's the builtin, pop them, put start, end & step in locals <Op1>, <Op1>+1 & <Op1>+2, push null and jump to <Op2>. otherwise continue (to code that calls it)
+	op_for_range,	// if tos is null: if local <Op0> < local <Op0>+1 push it and add local <Op0>+2 to it, else jump to <Op1>. otherwise as for_iter
+
+	op_wide,		// prefix: the next instruction's operands are dwords (compact code only)
+
+	// 133 (update as opcodes are added above)
 	op_halt,
 	op_breakpoint,		// breakpoint
 	op_illegal = 255	// illegal operation, if exists there was a compiler error/fault
@@ -157,5 +178,26 @@ enum Opcode
 
 extern const char* opcodeNames[];
 
+// number of operands of an instruction, or -1 if it isn't valid
+// (a breakpoint isn't: it hides the opcode it replaced, nor is the wide
+// prefix on its own)
+int OpcodeNumArgs( Opcode op );
+// index of the operand holding a code address, or -1 if there isn't one
+int OpcodeAddressArg( Opcode op );
+
+// size of the (compact) instruction at 'p', with its prefix, or 0 if it isn't
+// valid or doesn't fit in the 'len' bytes there
+size_t InstructionSize( const byte* p, size_t len );
+
+// read an operand of a compact instruction and move past it
+inline dword ReadOperand( byte* & p, bool wide )
+{
+	if( !wide )
+		return (dword)(int)(signed char)*p++;
+	dword d = *((dword*)p);
+	p += sizeof( dword );
+	return d;
+}
+
 } // namespace deva
 #endif // __OPCODES_H__
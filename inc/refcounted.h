@@ -55,6 +55,8 @@ template<typename T> class RefCounted : public T
 	RefCounted( size_t n, Object & o ) : T( n, o ), refcount( 0 ) {}
 	// 'slice' copy constructor
 	RefCounted( T & v, size_t start, size_t end ) : T( v, start, end ), refcount( 0 ) {}
+	// 'slice' copy constructor with a step
+	RefCounted( T & v, size_t start, size_t end, size_t step ) : T( v, start, end, step ), refcount( 0 ) {}
 
 	// collection 'pool' of all items to be deleted
 	static vector<T*> dead_pool;
@@ -68,9 +70,9 @@ public:
 	static RefCounted<T>* Create( size_t n ) { return new RefCounted<T>( n ); }
 	// create with 'n' items of 'o'
 	static RefCounted<T>* Create( size_t n, Object & o ) { return new RefCounted<T>( n, o ); }
-	// 'slice' creation fcn
-	// TODO: inc ref the copied items!
+	// 'slice' creation fcns
 	static RefCounted<T>* Create( T & v, size_t start, size_t end ) { return new RefCounted<T>( v, start, end ); }
+	static RefCounted<T>* Create( T & v, size_t start, size_t end, size_t step ) { return new RefCounted<T>( v, start, end, step ); }
 
 	inline void IncRef() { refcount++; }
 	inline int DecRef()
@@ -95,13 +95,14 @@ public:
 	inline bool IsFunction() { return is_function; }
 	inline bool IsModule() { return is_module; }
 	// add ref to a local (the index of a local in this scope's Frame)
-	inline void AddSymbol( string name, size_t idx )
+	inline void AddSymbol( const string & name, size_t idx )
 	{ 
-		// if the symbol exists already, erase it
+		// if the symbol exists already, replace it
 		map<string, LocalRef>::iterator i = data.find( name );
 		if( i != data.end() )
-			data.erase( i );
-		data.insert( make_pair( name, LocalRef( idx ) ) );
+			i->second = LocalRef( idx );
+		else
+			data.insert( make_pair( name, LocalRef( idx ) ) );
 	}
 	// add a ref to a function (pointer to the Object in the Executor's function
 	// collection)
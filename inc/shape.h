@@ -0,0 +1,107 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// shape.h
+// shape ('hidden class') objects, describing the field layout of instances
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#ifndef __SHAPE_H__
+#define __SHAPE_H__
+
+#include "object.h"
+
+#include <vector>
+#include <map>
+
+using namespace std;
+
+namespace deva
+{
+
+// maximum number of fields tracked by a shape. instances that grow past this
+// drop into 'dictionary mode'
+const size_t max_shape_fields = 64;
+
+// a shape maps an instance's field names to slots (indices into the instance
+// map's 'slots' vector). shapes form a transition tree rooted at the empty
+// shape: adding a field to an instance moves it to the child shape for that
+// field name, so instances built the same way (by the same constructor path)
+// end up sharing a shape
+class Shape
+{
+	// field names, in slot order (names are owned by the shape)
+	vector<Object> fields;
+	// field name -> slot
+	map<Object, size_t, MapKeyLess> slot_map;
+	// child shapes, keyed by the name of the field added
+	map<Object, Shape*, MapKeyLess> transitions;
+
+	// the root (empty) shape
+	static Shape* root;
+
+	Shape() {}
+	Shape( const Shape & parent, const Object & key );
+	~Shape();
+
+public:
+	// get the root (empty) shape
+	static Shape* Root();
+	// free all shapes (only once no more instances will be accessed)
+	static void FreeShapes();
+
+	// get the shape reached by adding 'key' to this shape, NULL if the key
+	// can't be tracked (not a name or there are too many fields)
+	Shape* AddField( const Object & key );
+
+	// get the slot for a field name, -1 if this shape doesn't have it
+	inline int FindSlot( const Object & key ) const
+	{
+		map<Object, size_t, MapKeyLess>::const_iterator i = slot_map.find( key );
+		if( i == slot_map.end() )
+			return -1;
+		return (int)i->second;
+	}
+	inline size_t NumFields() const { return fields.size(); }
+	inline const Object & FieldName( size_t slot ) const { return fields[slot]; }
+};
+
+// per-instruction cache for field loads/stores on instances. only a hint: a
+// hit is checked against the instance's shape and the field name in the slot,
+// so stale entries are harmless
+struct FieldCache
+{
+	Shape* shape;
+	size_t slot;
+
+	FieldCache() : shape( NULL ), slot( 0 ) {}
+
+	inline bool Hit( Shape* s, const Object & key ) const { return s && s == shape && MapKeyLess::Equal( shape->FieldName( slot ), key ); }
+	inline void Set( Shape* s, int sl ) { if( sl != -1 ){ shape = s; slot = (size_t)sl; } }
+};
+
+} // namespace deva
+
+#endif // __SHAPE_H__
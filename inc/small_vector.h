@@ -0,0 +1,299 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// small_vector.h
+// vector template with inline storage for a small number of items
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#ifndef __SMALL_VECTOR_H__
+#define __SMALL_VECTOR_H__
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <new>
+#include <cstddef>
+
+using namespace std;
+
+
+namespace deva
+{
+
+// a std::vector work-alike which keeps up to 'N' items inside the object
+// itself, only going to the heap when it grows past that. (only the parts of
+// the std::vector interface that the deva code uses are implemented)
+template<typename T, size_t N> class SmallVector
+{
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+	T* first;
+	T* last;
+	T* end_of_storage;
+	// the inline storage (the union ensures suitable alignment)
+	union
+	{
+		char bytes[N * sizeof( T )];
+		double align_d;
+		void* align_p;
+	} inline_storage;
+
+	inline T* InlineData() { return reinterpret_cast<T*>( inline_storage.bytes ); }
+	inline bool IsInline() const { return (const char*)first == inline_storage.bytes; }
+
+	// move to storage for (at least) 'n' items
+	void Reallocate( size_type n )
+	{
+		T* p = static_cast<T*>( ::operator new( n * sizeof( T ) ) );
+		size_type sz = size();
+		for( size_type i = 0; i < sz; i++ )
+		{
+			new( p + i ) T( first[i] );
+			first[i].~T();
+		}
+		if( !IsInline() )
+			::operator delete( first );
+		first = p;
+		last = p + sz;
+		end_of_storage = p + n;
+	}
+	// ensure there is room for 'n' more items
+	inline void Grow( size_type n )
+	{
+		if( last + n > end_of_storage )
+		{
+			size_type cap = capacity() * 2;
+			if( cap < size() + n )
+				cap = size() + n;
+			Reallocate( cap );
+		}
+	}
+	inline void InitInline()
+	{
+		first = last = InlineData();
+		end_of_storage = first + N;
+	}
+	// take the items of 'v' (leaving it empty), this vector being empty and
+	// inline. heap storage changes hands, so its items don't move
+	void MoveFrom( SmallVector & v )
+	{
+		if( v.IsInline() )
+		{
+			for( iterator i = v.first; i != v.last; ++i )
+			{
+				new( last++ ) T( *i );
+				i->~T();
+			}
+			v.last = v.first;
+		}
+		else
+		{
+			first = v.first;
+			last = v.last;
+			end_of_storage = v.end_of_storage;
+			v.InitInline();
+		}
+	}
+
+public:
+	SmallVector() { InitInline(); }
+	explicit SmallVector( size_type n, const T & val = T() )
+	{
+		InitInline();
+		resize( n, val );
+	}
+	SmallVector( const SmallVector & v )
+	{
+		InitInline();
+		reserve( v.size() );
+		for( const_iterator i = v.begin(); i != v.end(); ++i )
+			new( last++ ) T( *i );
+	}
+	template<typename It> SmallVector( It b, It e )
+	{
+		InitInline();
+		for( ; b != e; ++b )
+			push_back( *b );
+	}
+	~SmallVector()
+	{
+		clear();
+		if( !IsInline() )
+			::operator delete( first );
+	}
+
+	SmallVector & operator = ( const SmallVector & v )
+	{
+		if( &v != this )
+		{
+			clear();
+			reserve( v.size() );
+			for( const_iterator i = v.begin(); i != v.end(); ++i )
+				new( last++ ) T( *i );
+		}
+		return *this;
+	}
+
+	// iterators
+	inline iterator begin() { return first; }
+	inline const_iterator begin() const { return first; }
+	inline iterator end() { return last; }
+	inline const_iterator end() const { return last; }
+	inline reverse_iterator rbegin() { return reverse_iterator( last ); }
+	inline const_reverse_iterator rbegin() const { return const_reverse_iterator( last ); }
+	inline reverse_iterator rend() { return reverse_iterator( first ); }
+	inline const_reverse_iterator rend() const { return const_reverse_iterator( first ); }
+
+	// size & capacity
+	inline size_type size() const { return (size_type)(last - first); }
+	inline bool empty() const { return last == first; }
+	inline size_type capacity() const { return (size_type)(end_of_storage - first); }
+	inline size_type max_size() const { return (size_type)-1 / sizeof( T ); }
+	// is the data held in the inline storage?
+	inline bool is_inline() const { return IsInline(); }
+	void reserve( size_type n )
+	{
+		if( n > capacity() )
+			Reallocate( n );
+	}
+	void resize( size_type n, const T & val = T() )
+	{
+		if( n < size() )
+			erase( first + n, last );
+		else
+		{
+			T tmp( val );
+			reserve( n );
+			while( last < first + n )
+				new( last++ ) T( tmp );
+		}
+	}
+
+	// element access
+	inline reference operator [] ( size_type n ) { return first[n]; }
+	inline const_reference operator [] ( size_type n ) const { return first[n]; }
+	inline reference at( size_type n ) { if( n >= size() ) throw out_of_range( "SmallVector::at" ); return first[n]; }
+	inline const_reference at( size_type n ) const { if( n >= size() ) throw out_of_range( "SmallVector::at" ); return first[n]; }
+	inline reference front() { return *first; }
+	inline const_reference front() const { return *first; }
+	inline reference back() { return *(last - 1); }
+	inline const_reference back() const { return *(last - 1); }
+	inline T* data() { return first; }
+	inline const T* data() const { return first; }
+
+	// modifiers
+	inline void push_back( const T & val )
+	{
+		if( last == end_of_storage )
+		{
+			// (val may refer to one of our own items)
+			T tmp( val );
+			Grow( 1 );
+			new( last++ ) T( tmp );
+		}
+		else
+			new( last++ ) T( val );
+	}
+	inline void pop_back() { (--last)->~T(); }
+	iterator insert( iterator pos, const T & val )
+	{
+		size_type off = pos - first;
+		size_type sz = size();
+		push_back( val );
+		std::rotate( first + off, first + sz, last );
+		return first + off;
+	}
+	void insert( iterator pos, size_type n, const T & val )
+	{
+		size_type off = pos - first;
+		size_type sz = size();
+		T tmp( val );
+		Grow( n );
+		for( size_type i = 0; i < n; i++ )
+			new( last++ ) T( tmp );
+		std::rotate( first + off, first + sz, last );
+	}
+	template<typename It> void insert( iterator pos, It b, It e )
+	{
+		// copy the range first, it may be part of this vector
+		std::vector<T> items( b, e );
+		size_type off = pos - first;
+		size_type sz = size();
+		Grow( items.size() );
+		for( typename std::vector<T>::iterator i = items.begin(); i != items.end(); ++i )
+			new( last++ ) T( *i );
+		std::rotate( first + off, first + sz, last );
+	}
+	iterator erase( iterator pos )
+	{
+		std::copy( pos + 1, last, pos );
+		pop_back();
+		return pos;
+	}
+	iterator erase( iterator b, iterator e )
+	{
+		if( b != e )
+		{
+			iterator new_last = std::copy( e, last, b );
+			for( iterator i = new_last; i != last; ++i )
+				i->~T();
+			last = new_last;
+		}
+		return b;
+	}
+	void clear()
+	{
+		for( iterator i = first; i != last; ++i )
+			i->~T();
+		last = first;
+	}
+	// exchange contents with 'v' (items on the heap don't move)
+	void swap( SmallVector & v )
+	{
+		SmallVector tmp;
+		tmp.MoveFrom( *this );
+		MoveFrom( v );
+		v.MoveFrom( tmp );
+	}
+};
+
+
+} // namespace deva
+
+#endif // __SMALL_VECTOR_H__
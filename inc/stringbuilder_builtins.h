@@ -0,0 +1,78 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// stringbuilder_builtins.h
+// builtin string builder methods for the deva language
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#ifndef __STRINGBUILDER_BUILTINS_H__ 
+#define __STRINGBUILDER_BUILTINS_H__
+
+#include "object.h"
+#include <string>
+
+using namespace std;
+
+
+namespace deva
+{
+
+
+// to add new builtins you must:
+// 1) add a new fcn to the builtin_names and builtin_fcns arrays below
+// 2) implement the function in this file
+
+// pre-decls:
+class Frame;
+
+// pre-decls for builtin executors
+void do_stringbuilder_append( Frame *frame );
+void do_stringbuilder_appendline( Frame *frame );
+void do_stringbuilder_length( Frame *frame );
+void do_stringbuilder_str( Frame *frame );
+
+// arrays containing
+// the names of the string builder builtins...
+extern const string stringbuilder_builtin_names[];
+// ...the function pointers to the executor functions for them...
+extern NativeFunctionPtr stringbuilder_builtin_fcns[];
+// ...and function objects for them
+extern Object stringbuilder_builtin_fcn_objs[];
+extern const int num_of_stringbuilder_builtins;
+
+// is a given name a builtin function?
+bool IsStringBuilderBuiltin( const string & name );
+
+// get the native function ptr
+NativeFunction GetStringBuilderBuiltin( const string & name );
+
+// get an Object* for the fcn
+Object* GetStringBuilderBuiltinObjectRef( const string & name );
+
+
+} // end namespace deva
+
+#endif // __STRINGBUILDER_BUILTINS_H__
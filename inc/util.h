@@ -32,6 +32,7 @@
 #define __UTIL_H__
 
 #include <string>
+#include <cstring>
 #include <vector>
 #include <cmath>
 
@@ -59,16 +60,43 @@ vector<string> split_path( string & path );
 string join_paths( const string & base, const string & add );
 string join_paths( vector<string> & parts );
 void split_env_var_paths( const string & var, vector<string> &  paths );
+// a name for a temporary file next to 'path', unique to this process
+string temp_file_name( const string & path );
+// rename a file, replacing any existing 'to' file (atomically, where the
+// platform allows it). returns false on failure
+bool rename_file( const string & from, const string & to );
+void remove_file( const string & path );
 
 
 // symbol name and string utility functions
 /////////////////////////////////////////////////////////////////////////////
 void replace( string& src, const char* const in, const char* const out );
 void split( const string& in, const char* const splitchars, vector<string> & out );
+// strings held by the executor carry their length (in bytes, not counting the
+// null terminator) in a header just before their characters, so it is
+// available in constant time and the strings can hold embedded nulls. they
+// are all allocated by allocstr() (or the functions below, which use it) and
+// must be freed with freestr()
+// allocate a (null-terminated) string of 'len' bytes
+char* allocstr( size_t len );
+void freestr( const char* s );
+// the length of a string allocated by allocstr()
+inline size_t strlength( const char* s ) { return *((const size_t*)s - 1); }
+// compare two strings allocated by allocstr(), including any embedded nulls
+int cmpstr( const char* s1, const char* s2 );
+// (strings of different lengths are never equal, without looking at them)
+inline bool eqstr( const char* s1, const char* s2 )
+{
+	size_t len = strlength( s1 );
+	return len == strlength( s2 ) && memcmp( s1, s2, len ) == 0;
+}
 // allocate and return a copy of a string
 char* copystr( const char* in );
-char* copystr( string in );
-// allocate a concatenation of two strings
+char* copystr( const string & in );
+// allocate and return a copy of a string allocated by allocstr() (including
+// any embedded nulls)
+char* dupstr( const char* in );
+// allocate a concatenation of two strings allocated by allocstr()
 char* catstr( const char* s1, const char* s2 );
 
 // strip the whitespace and leading comments from a string,
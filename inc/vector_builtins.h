@@ -64,6 +64,8 @@ void do_vector_rfind( Frame *frame );
 void do_vector_count( Frame *frame );
 void do_vector_reverse( Frame *frame );
 void do_vector_sort( Frame *frame );
+void do_vector_sort_by( Frame *frame );
+void do_vector_stable_sort( Frame *frame );
 void do_vector_map( Frame *frame );
 void do_vector_filter( Frame *frame );
 void do_vector_reduce( Frame *frame );
@@ -71,6 +73,20 @@ void do_vector_any( Frame *frame );
 void do_vector_all( Frame *frame );
 void do_vector_slice( Frame *frame );
 void do_vector_join( Frame *frame );
+void do_vector_reserve( Frame *frame );
+void do_vector_capacity( Frame *frame );
+// numeric methods
+void do_vector_sum( Frame *frame );
+void do_vector_mean( Frame *frame );
+void do_vector_dot( Frame *frame );
+void do_vector_argmin( Frame *frame );
+void do_vector_argmax( Frame *frame );
+void do_vector_scale( Frame *frame );
+void do_vector_add( Frame *frame );
+void do_vector_sub( Frame *frame );
+void do_vector_mul( Frame *frame );
+void do_vector_cumsum( Frame *frame );
+void do_vector_clip( Frame *frame );
 // 'enumerable interface'
 void do_vector_rewind( Frame *frame );
 void do_vector_next( Frame *frame );
@@ -180,6 +180,10 @@ Code* PassTwo( const char* module_name, PassOneReturnValue p1rv, PassTwoFlags fl
 	// free items
 	cmpPsr->free( cmpPsr );      
 
+	if( flags.optimize )
+		compiler->Optimize();
+	compiler->Compact();
+
 	return compiler->GetCode();
 }
 
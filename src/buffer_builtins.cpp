@@ -0,0 +1,281 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// buffer_builtins.cpp
+// builtin buffer methods for the deva language
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#include "buffer_builtins.h"
+#include "builtins_helpers.h"
+#include "number.h"
+#include <algorithm>
+
+using namespace std;
+
+
+namespace deva
+{
+
+
+const string buffer_builtin_names[] = 
+{
+	string( "length" ),
+	string( "slice" ),
+	string( "find" ),
+	string( "to_string" ),
+	string( "to_vector" ),
+};
+NativeFunctionPtr buffer_builtin_fcns[] = 
+{
+	do_buffer_length,
+	do_buffer_slice,
+	do_buffer_find,
+	do_buffer_to_string,
+	do_buffer_to_vector,
+};
+Object buffer_builtin_fcn_objs[] = 
+{
+	Object( do_buffer_length ),
+	Object( do_buffer_slice ),
+	Object( do_buffer_find ),
+	Object( do_buffer_to_string ),
+	Object( do_buffer_to_vector ),
+};
+const int num_of_buffer_builtins = sizeof( buffer_builtin_names ) / sizeof( buffer_builtin_names[0] );
+
+
+bool IsBufferBuiltin( const string & name )
+{
+	const string* i = find( buffer_builtin_names, buffer_builtin_names + num_of_buffer_builtins, name );
+	if( i != buffer_builtin_names + num_of_buffer_builtins ) return true;
+	else return false;
+}
+
+NativeFunction GetBufferBuiltin( const string & name )
+{
+	const string* i = find( buffer_builtin_names, buffer_builtin_names + num_of_buffer_builtins, name );
+	if( i == buffer_builtin_names + num_of_buffer_builtins )
+	{
+		NativeFunction nf;
+		nf.p = NULL;
+		return nf;
+	}
+	// compute the index of the function in the look-up table(s)
+	long l = (long)i;
+	l -= (long)&buffer_builtin_names;
+	int idx = l / sizeof( string );
+	if( idx > num_of_buffer_builtins )
+	{
+		NativeFunction nf;
+		nf.p = NULL;
+		return nf;
+	}
+	else
+	{
+		// return the function
+		NativeFunction nf;
+		nf.p = buffer_builtin_fcns[idx];
+		nf.is_method = true;
+		return nf;
+	}
+}
+
+Object* GetBufferBuiltinObjectRef( const string & name )
+{
+	const string* i = find( buffer_builtin_names, buffer_builtin_names + num_of_buffer_builtins, name );
+	if( i == buffer_builtin_names + num_of_buffer_builtins )
+	{
+		return NULL;
+	}
+	// compute the index of the function in the look-up table(s)
+	long l = (long)i;
+	l -= (long)&buffer_builtin_names;
+	int idx = l / sizeof( string );
+	if( idx > num_of_buffer_builtins )
+	{
+		return NULL;
+	}
+	else
+	{
+		// return the function object
+		return &buffer_builtin_fcn_objs[idx];
+	}
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// buffer builtins
+/////////////////////////////////////////////////////////////////////////////
+
+void do_buffer_length( Frame *frame )
+{
+	BuiltinHelper helper( "buffer", "length", frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_buffer );
+
+	helper.ReturnVal( Object( (int64_t)self->buf->size() ) );
+}
+
+void do_buffer_slice( Frame *frame )
+{
+	BuiltinHelper helper( "buffer", "slice", frame );
+
+	helper.CheckNumberOfArguments( 3 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_buffer );
+
+	Object* startobj = helper.GetLocalN( 1 );
+	helper.ExpectPositiveIntegralNumber( startobj );
+	int start = (int)NumToInt( *startobj );
+
+	Object* endobj = helper.GetLocalN( 2 );
+	helper.ExpectIntegralNumber( endobj );
+	int end = (int)NumToInt( *endobj );
+
+	size_t sz = self->buf->size();
+
+	if( end == -1 )
+		end = (int)sz;
+
+	if( (size_t)start > sz || start < 0 )
+		throw RuntimeException( "Invalid 'start' argument in buffer built-in method 'slice'." );
+	if( (size_t)end > sz || end < 0 )
+		throw RuntimeException( "Invalid 'end' argument in buffer built-in method 'slice'." );
+	if( end < start )
+		throw RuntimeException( "Invalid arguments in buffer built-in method 'slice': start is greater than end." );
+
+	// the slice is a view of our bytes, no copying
+	helper.ReturnVal( Object( CreateBuffer( *(self->buf), start, end ) ) );
+}
+
+void do_buffer_find( Frame *frame )
+{
+	BuiltinHelper helper( "buffer", "find", frame );
+
+	helper.CheckNumberOfArguments( 2, 4 );
+	int num_args = frame->NumArgsPassed();
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_buffer );
+
+	// the value to find: a byte, or a sequence of bytes (buffer or string)
+	Object* value = helper.GetLocalN( 1 );
+	helper.ExpectTypes( value, obj_number, obj_buffer, obj_string );
+	unsigned char byte;
+	const unsigned char* seq;
+	size_t seq_len;
+	if( value->type == obj_number )
+	{
+		helper.ExpectIntegralNumber( value );
+		byte = (unsigned char)NumToInt( *value );
+		seq = &byte;
+		seq_len = 1;
+	}
+	else if( value->type == obj_buffer )
+	{
+		seq = value->buf->data();
+		seq_len = value->buf->size();
+	}
+	else
+	{
+		seq = (const unsigned char*)(const char*)value->s;
+		seq_len = strlength( value->s );
+	}
+
+	int start = 0;
+	int end = -1;
+	if( num_args > 2 )
+	{
+		Object* startobj = helper.GetLocalN( 2 );
+		helper.ExpectPositiveIntegralNumber( startobj );
+		start = (int)NumToInt( *startobj );
+	}
+	if( num_args > 3 )
+	{
+		Object* endobj = helper.GetLocalN( 3 );
+		helper.ExpectIntegralNumber( endobj );
+		end = (int)NumToInt( *endobj );
+	}
+
+	size_t sz = self->buf->size();
+
+	if( end == -1 )
+		end = (int)sz;
+
+	if( (size_t)start > sz || start < 0 )
+		throw RuntimeException( "Invalid 'start' argument in buffer built-in method 'find'." );
+	if( (size_t)end > sz || end < 0 )
+		throw RuntimeException( "Invalid 'end' argument in buffer built-in method 'find'." );
+	if( end < start )
+		throw RuntimeException( "Invalid arguments in buffer built-in method 'find': start is greater than end." );
+
+	const unsigned char* b = self->buf->data() + start;
+	const unsigned char* e = self->buf->data() + end;
+	const unsigned char* i = search( b, e, seq, seq + seq_len );
+
+	if( seq_len == 0 || i == e )
+		helper.ReturnVal( Object( obj_null ) );
+	else
+		helper.ReturnVal( Object( (int64_t)(i - self->buf->data()) ) );
+}
+
+void do_buffer_to_string( Frame *frame )
+{
+	BuiltinHelper helper( "buffer", "to_string", frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_buffer );
+
+	// (like readstring(), the string ends at the first null byte, if any)
+	string s( (const char*)self->buf->data(), self->buf->size() );
+	const char* str = frame->GetParent()->AddString( s );
+
+	helper.ReturnVal( Object( str ) );
+}
+
+void do_buffer_to_vector( Frame *frame )
+{
+	BuiltinHelper helper( "buffer", "to_vector", frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_buffer );
+
+	size_t sz = self->buf->size();
+	Vector* vec = CreateVector();
+	if( sz > vector_inline_size )
+		vec->Pack();
+	vec->reserve( sz );
+	for( size_t i = 0; i < sz; ++i )
+		vec->push_back( Object( (int64_t)self->buf->operator[]( i ) ) );
+
+	helper.ReturnVal( Object( vec ) );
+}
+
+
+} // end namespace deva
@@ -30,6 +30,7 @@
 
 #include "builtins.h"
 #include "builtins_helpers.h"
+#include "number.h"
 #include <algorithm>
 #include <sstream>
 #include <cstdio>
@@ -91,6 +92,12 @@ const string builtin_names[] =
 	string( "vector_of" ),
 	string( "raise" ),
 	string( "dir" ),
+	string( "buffer" ),
+	string( "is_buffer" ),
+	string( "readbuffer" ),
+	string( "stringbuilder" ),
+	string( "is_stringbuilder" ),
+	string( "evalstats" ),
 };
 // ...and function pointers to the executor functions for them
 NativeFunction builtin_fcns[] = 
@@ -146,6 +153,12 @@ NativeFunction builtin_fcns[] =
 	{do_vector_of, false},
 	{do_raise, false},
 	{do_dir, false},
+	{do_buffer, false},
+	{do_is_buffer, false},
+	{do_readbuffer, false},
+	{do_stringbuilder, false},
+	{do_is_stringbuilder, false},
+	{do_evalstats, false},
 };
 Object builtin_fcn_objs[] = 
 {
@@ -200,6 +213,12 @@ Object builtin_fcn_objs[] =
 	Object( do_vector_of ),
 	Object( do_raise ),
 	Object( do_dir ),
+	Object( do_buffer ),
+	Object( do_is_buffer ),
+	Object( do_readbuffer ),
+	Object( do_stringbuilder ),
+	Object( do_is_stringbuilder ),
+	Object( do_evalstats ),
 };
 const int num_of_builtins = sizeof( builtin_names ) / sizeof( builtin_names[0] );
 
@@ -412,10 +431,9 @@ void do_chr( Frame *frame )
 	Object* o = helper.GetLocalN( 0 );
 	helper.ExpectType( o, obj_number );
 
-	char c = (char)(o->d);
-	char* s = new char[2];
+	char c = (char)NumToInt( *o );
+	char* s = allocstr( 1 );
 	s[0] = c;
-	s[1] = '\0';
 	frame->GetParent()->AddString( s );
 
 	helper.ReturnVal( Object( s ) );
@@ -442,13 +460,13 @@ void do_length( Frame *frame )
 	helper.CheckNumberOfArguments( 1 );
 
 	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectTypes( o, obj_string, obj_vector, obj_map, obj_class, obj_instance );
+	helper.ExpectTypes( o, obj_string, obj_vector, obj_map, obj_class, obj_instance, obj_buffer );
 
 	int len;
 	// string
 	if( o->type == obj_string )
 	{
-		len = (int)string( o->s ).size();
+		len = (int)strlength( o->s );
 	}
 	// vector
 	else if( o->type == obj_vector )
@@ -460,8 +478,13 @@ void do_length( Frame *frame )
 	{
 		len = (int)o->m->size();
 	}
+	// buffer
+	else if( o->type == obj_buffer )
+	{
+		len = (int)o->buf->size();
+	}
 
-	helper.ReturnVal( Object( (double)len ) );
+	helper.ReturnVal( Object( (int64_t)len ) );
 }
 
 void do_copy( Frame *frame )
@@ -497,9 +520,8 @@ void do_copy( Frame *frame )
 		copy = Object( v );
 	}
 
-	// it's a (shallow) copy, all the children have been copied, so need to
-	// inc-ref children
-	IncRefChildren( copy );
+	// (it's a (shallow) copy, which shares its children with the original
+	// until either is modified, so the children need no inc-ref'ing)
 
 	helper.ReturnVal( copy );
 }
@@ -555,7 +577,7 @@ void do_exit( Frame *frame )
 	{
 		Object* o = helper.GetLocalN( 0 );
 		helper.ExpectIntegralNumber( o );
-		ex->Exit( (int)o->d );
+		ex->Exit( (int)NumToInt( *o ) );
 	}
 	else
 		ex->Exit( 0 );
@@ -575,7 +597,7 @@ void do_num( Frame *frame )
 	switch( o->type )
 	{
 	case obj_number:
-		d = o->d;
+		d = o->Num();
 		break;
 	case obj_string:
 	case obj_symbol_name:
@@ -589,10 +611,10 @@ void do_num( Frame *frame )
 		d = (double)(size_t)o->sz;
 		break;
 	case obj_native_obj:
-		d = (double)(size_t)o->no;
+		d = (double)(size_t)(void*)o->no;
 		break;
 	case obj_native_function:
-		d = (double)(size_t)o->nf.p;
+		d = (double)(size_t)(NativeFunctionPtr)o->nf.p;
 		break;
 	case obj_function:
 		d = (double)(size_t)o->f->addr;
@@ -606,38 +628,30 @@ void do_num( Frame *frame )
 	helper.ReturnVal( Object( d ) );
 }
 
-void do_range( Frame *frame )
+// get the start, end and step of a range from the (1-3) arguments to 'range'
+void GetRangeArgs( Object* args[], int num_args, int & start, int & end, int & step )
 {
-	BuiltinHelper helper( NULL, "range", frame );
-	helper.CheckNumberOfArguments( 1, 3 );
-
-	int step = 1;
-	int start = 0;
-	int end = -1;
-
-	Object *stepobj, *startobj, *endobj;
+	BuiltinHelper helper( NULL, "range", NULL );
 
-	int num_args = frame->NumArgsPassed();
+	step = 1;
+	start = 0;
+	end = -1;
 
-	startobj = helper.GetLocalN( 0 );
-	helper.ExpectPositiveIntegralNumber( startobj );
-	start = (int)startobj->d;
+	helper.ExpectPositiveIntegralNumber( args[0] );
+	start = (int)NumToInt( *args[0] );
 
 	if( num_args == 3 )
 	{
-		endobj = helper.GetLocalN( 1 );
-		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		helper.ExpectIntegralNumber( args[1] );
+		end = (int)NumToInt( *args[1] );
 
-		stepobj = helper.GetLocalN( 2 );
-		helper.ExpectPositiveIntegralNumber( stepobj );
-		step = (int)stepobj->d;
+		helper.ExpectPositiveIntegralNumber( args[2] );
+		step = (int)NumToInt( *args[2] );
 	}
 	else if( num_args == 2 )
 	{
-		endobj = helper.GetLocalN( 1 );
-		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		helper.ExpectIntegralNumber( args[1] );
+		end = (int)NumToInt( *args[1] );
 	}
 
 	// if we only have one arg, start = 0 and end = start-arg
@@ -649,14 +663,36 @@ void do_range( Frame *frame )
 
 	if( start < 0 || end < 0 || step < 0 )
 		throw RuntimeException( "Arguments to 'range' must be positive integral numbers." );
+	// (a zero step would never get anywhere)
+	if( step == 0 )
+		throw RuntimeException( "Step argument to 'range' must not be zero." );
+}
+
+void do_range( Frame *frame )
+{
+	BuiltinHelper helper( NULL, "range", frame );
+	helper.CheckNumberOfArguments( 1, 3 );
+
+	int num_args = frame->NumArgsPassed();
+	Object* args[3];
+	for( int i = 0; i < num_args; i++ )
+		args[i] = helper.GetLocalN( i );
+
+	int start, end, step;
+	GetRangeArgs( args, num_args, start, end, step );
 
 	// generate the range
 	// convert to a vector of numbers
 	Vector* vec = CreateVector();
-	vec->reserve( (int)((end - start) / step) );
-	for( double c = start; c < end; c += step )
+	int count = (end - start) / step;
+	// (stored packed, unless it fits the inline storage)
+	if( count > (int)vector_inline_size )
+		vec->Pack();
+	if( count > 0 )
+		vec->reserve( count );
+	for( int c = start; c < end; c += step )
 	{
-		vec->push_back( Object( c ) );
+		vec->push_back( Object( (int64_t)c ) );
 	}
 
 	helper.ReturnVal( Object( vec ) );
@@ -675,7 +711,7 @@ void do_vector_of( Frame *frame )
 
 	nobj = helper.GetLocalN( 1 );
 	helper.ExpectPositiveIntegralNumber( nobj );
-	n = (int)nobj->d;
+	n = (int)NumToInt( *nobj );
 
 	if( n < 0 )
 		throw RuntimeException( "Argument 'n' to 'vector_of' must be a positive integral number." );
@@ -715,6 +751,24 @@ void do_eval( Frame *frame )
 	helper.ReturnVal( ret );
 }
 
+// statistics for the eval() compile cache
+void do_evalstats( Frame *frame )
+{
+	BuiltinHelper helper( NULL, "evalstats", frame );
+
+	helper.CheckNumberOfArguments( 0 );
+
+	const char* names[] = { "hits", "misses", "entries", "size" };
+	size_t values[] = { ex->EvalCacheHits(), ex->EvalCacheMisses(), ex->EvalCacheEntries(), ex->EvalCacheSize() };
+	Map* m = CreateMap();
+	for( int i = 0; i < 4; i++ )
+	{
+		const char* name = frame->GetParent()->AddString( string( names[i] ) );
+		m->insert( make_pair( Object( name ), Object( (int64_t)values[i] ) ) );
+	}
+	helper.ReturnVal( Object( m ) );
+}
+
 void do_open( Frame *frame )
 {
 	BuiltinHelper helper( NULL, "open", frame );
@@ -787,7 +841,7 @@ void do_read( Frame *frame )
 	Object* num_bytes_obj = helper.GetLocalN( 1 );
 	helper.ExpectIntegralNumber( num_bytes_obj );
 	
-	int num_bytes = (int)num_bytes_obj->d;
+	int num_bytes = (int)NumToInt( *num_bytes_obj );
 
 	// allocate space for bytes plus a null-terminator
 	unsigned char* s = new unsigned char[num_bytes + 1];
@@ -797,6 +851,8 @@ void do_read( Frame *frame )
 
 	// convert to a vector of numbers
 	Vector* vec = CreateVector();
+	if( bytes_read > vector_inline_size )
+		vec->Pack();
 	vec->reserve( bytes_read );
 	for( size_t c = 0; c < bytes_read; ++c )
 	{
@@ -808,9 +864,34 @@ void do_read( Frame *frame )
 	helper.ReturnVal( Object( vec ) );
 }
 
-// if there are embedded nulls in the bytes read the string
-// returned will only contain up to the first null...
-// read() should be used in this case, not readstring
+void do_readbuffer( Frame *frame )
+{
+	BuiltinHelper helper( NULL, "readbuffer", frame );
+
+	helper.CheckNumberOfArguments( 2 );
+
+	Object* file = helper.GetLocalN( 0 );
+	helper.ExpectType( file, obj_native_obj );
+	Object* num_bytes_obj = helper.GetLocalN( 1 );
+	helper.ExpectPositiveIntegralNumber( num_bytes_obj );
+	
+	size_t num_bytes = (size_t)NumToInt( *num_bytes_obj );
+
+	// read straight into the buffer's bytes
+	Buffer* buf = CreateBuffer( num_bytes );
+	size_t bytes_read = num_bytes ? fread( (void*)buf->MutableData(), 1, num_bytes, (FILE*)(file->no) ) : 0;
+	// if we didn't read the full amount, keep only the bytes read
+	if( bytes_read != num_bytes )
+	{
+		Buffer* b = CreateBuffer( buf->data(), bytes_read );
+		delete buf;
+		buf = b;
+	}
+
+	helper.ReturnVal( Object( buf ) );
+}
+
+// (the string returned holds all the bytes read, including any embedded nulls)
 void do_readstring( Frame *frame )
 {
 	BuiltinHelper helper( NULL, "readstring", frame );
@@ -822,28 +903,21 @@ void do_readstring( Frame *frame )
 	Object* num_bytes_obj = helper.GetLocalN( 1 );
 	helper.ExpectIntegralNumber( num_bytes_obj );
 	
-	size_t num_bytes = (size_t)num_bytes_obj->d;
+	size_t num_bytes = (size_t)NumToInt( *num_bytes_obj );
 
 	// allocate space for bytes plus a null-terminator
-	char* s = new char[num_bytes + 1];
-	// zero out the bytes
-	memset( s, 0, num_bytes + 1 );
+	char* s = allocstr( num_bytes );
 	size_t bytes_read = fread( (void*)s, 1, num_bytes, (FILE*)(file->no) );
 	// if we didn't read the full amount, we need to re-alloc and copy so that
-	// we don't leak the extra bytes when they are assigned to a string DevaObject
+	// the string's length is the number of bytes actually read
 	if( bytes_read != num_bytes )
 	{
-		char* new_s = new char[bytes_read + 1];
-		new_s[bytes_read] = '\0';
+		char* new_s = allocstr( bytes_read );
 		memcpy( (void*)new_s, (void*)s, bytes_read );
-		delete [] s;
+		freestr( s );
 		s = new_s;
 	}
 
-	// if there are embedded nulls in the bytes read the string
-	// returned will only contain up to the first null...
-	// read() should be used in this case, not readstring
-
 	// add the buffer (string) to the parent frame's string collection
 	// so that it will be freed
 	ex->CurrentFrame()->GetParent()->AddString( s );
@@ -890,17 +964,12 @@ void do_readline( Frame *frame )
 	if( ferror( (FILE*)(file->no) ) )
 		throw RuntimeException( "Error accessing file in built-in method 'readline'." );
 
-	// if we didn't fill the buffer, we need to re-alloc and copy so that
-	// we don't leak the extra bytes when they are assigned to a string DevaObject
+	// copy what was read into a string of the right length
 	size_t bytes_read = strlen( buffer );
-	if( bytes_read != count )
-	{
-		char* new_buf = new char[bytes_read + 1];
-		new_buf[bytes_read] = '\0';
-		memcpy( (void*)new_buf, (void*)buffer, bytes_read );
-		delete [] buffer;
-		buffer = new_buf;
-	}
+	char* new_buf = allocstr( bytes_read );
+	memcpy( (void*)new_buf, (void*)buffer, bytes_read );
+	delete [] buffer;
+	buffer = new_buf;
 
 	// add the buffer (string) to the parent frame's string collection
 	// so that it will be freed
@@ -948,17 +1017,12 @@ void do_readlines( Frame *frame )
 			buf = buffer + count-1;
 			count += BUF_SZ - 1;
 		}
-		// if we didn't fill the buffer, we need to re-alloc and copy so that
-		// we don't leak the extra bytes when they are assigned to a string DevaObject
+		// copy what was read into a string of the right length
 		size_t bytes_read = strlen( buffer );
-		if( bytes_read != count )
-		{
-			char* new_buf = new char[bytes_read + 1];
-			new_buf[bytes_read] = '\0';
-			memcpy( (void*)new_buf, (void*)buffer, bytes_read );
-			delete [] buffer;
-			buffer = new_buf;
-		}
+		char* new_buf = allocstr( bytes_read );
+		memcpy( (void*)new_buf, (void*)buffer, bytes_read );
+		delete [] buffer;
+		buffer = new_buf;
 
 		// add the buffer (string) to the parent frame's string collection
 		// so that it will be freed
@@ -989,9 +1053,18 @@ void do_write( Frame *frame )
 	Object* num_bytes_obj = helper.GetLocalN( 1 );
 	helper.ExpectIntegralNumber( num_bytes_obj );
 	Object* source = helper.GetLocalN( 2 );
-	helper.ExpectType( source, obj_vector );
+	helper.ExpectTypes( source, obj_vector, obj_buffer );
 	
-	size_t num_bytes = (size_t)num_bytes_obj->d;
+	size_t num_bytes = (size_t)NumToInt( *num_bytes_obj );
+
+	// buffers are written directly
+	if( source->type == obj_buffer )
+	{
+		size_t len = num_bytes < source->buf->size() ? num_bytes : source->buf->size();
+		size_t bytes_written = len ? fwrite( (const void*)source->buf->data(), 1, len, (FILE*)(file->no) ) : 0;
+		helper.ReturnVal( Object( (int64_t)bytes_written ) );
+		return;
+	}
 
 	size_t len = num_bytes < source->v->size() ? num_bytes : source->v->size();
 	unsigned char* data = new unsigned char[len];
@@ -999,18 +1072,18 @@ void do_write( Frame *frame )
 	for( size_t c = 0; c < len; ++c )
 	{
 		// ensure this object is a number
-		Object o = source->v->operator[]( c );
+		Object o = source->v->Get( c );
 		if( o.type != obj_number )
 			throw RuntimeException( "'source' vector in built-in function 'write' contains objects that are not numeric." );
 
 		// copy the item's data
-		data[c] = (unsigned char)o.d;
+		data[c] = (unsigned char)NumToInt( o );
 	}
 	size_t bytes_written = fwrite( (void*)data, 1, len, (FILE*)(file->no) );
 
 	delete [] data;
 
-	helper.ReturnVal( Object( (double)bytes_written ) );
+	helper.ReturnVal( Object( (int64_t)bytes_written ) );
 }
 
 void do_writestring( Frame *frame )
@@ -1026,9 +1099,9 @@ void do_writestring( Frame *frame )
 	Object* source = helper.GetLocalN( 2 );
 	helper.ExpectType( source, obj_string );
 	
-	size_t num_bytes = (size_t)num_bytes_obj->d;
+	size_t num_bytes = (size_t)NumToInt( *num_bytes_obj );
 
-	size_t slen = strlen( source->s );
+	size_t slen = strlength( source->s );
 	size_t len = num_bytes < slen ? num_bytes : slen;
 	size_t bytes_written = fwrite( (void*)(source->s), 1, len, (FILE*)(file->no) );
 
@@ -1093,11 +1166,11 @@ void do_seek( Frame *frame )
 	{
 		Object* originobj = helper.GetLocalN( 2 );
 		helper.ExpectIntegralNumber( originobj );
-		origin = (int)originobj->d;
+		origin = (int)NumToInt( *originobj );
 	}
 	
 	// get the position
-	fseek( (FILE*)(file->no), (dword)posobj->d, origin );
+	fseek( (FILE*)(file->no), (dword)NumToInt( *posobj ), origin );
 
 	helper.ReturnVal( Object( obj_null ) );
 }
@@ -1114,7 +1187,7 @@ void do_tell( Frame *frame )
 	// get the position
 	long int pos = ftell( (FILE*)(file->no) );
 
-	helper.ReturnVal( Object( (double)pos ) );
+	helper.ReturnVal( Object( (int64_t)pos ) );
 }
 
 void do_stdin( Frame *frame )
@@ -1489,7 +1562,6 @@ void do_dir( Frame* frame )
 		// create a new map object that is a copy of the one we received,
 		Map* m = CreateMap( *(o->m) );
 		Object ret = Object( m );
-		IncRefChildren( ret );
 		helper.ReturnVal( ret );
 		}
 		break;
@@ -1559,5 +1631,88 @@ void do_dir( Frame* frame )
 	}
 }
 
+void do_buffer( Frame* frame )
+{
+	BuiltinHelper helper( NULL, "buffer", frame );
+	helper.CheckNumberOfArguments( 1 );
+
+	Object* o = helper.GetLocalN( 0 );
+	helper.ExpectTypes( o, obj_string, obj_vector, obj_buffer );
+
+	Buffer* buf;
+	// string: its bytes
+	if( o->type == obj_string )
+	{
+		buf = CreateBuffer( o->s, strlength( o->s ) );
+	}
+	// vector of numbers: one byte per number
+	else if( o->type == obj_vector )
+	{
+		size_t sz = o->v->size();
+		buf = CreateBuffer( sz );
+		unsigned char* bytes = buf->MutableData();
+		for( size_t i = 0; i < sz; ++i )
+		{
+			Object item = o->v->Get( i );
+			if( item.type != obj_number || !IsIntegral( item ) || NumToInt( item ) < 0 || NumToInt( item ) > 255 )
+			{
+				delete buf;
+				throw RuntimeException( "Vector passed to builtin function 'buffer' must contain only integral numbers from 0 to 255." );
+			}
+			bytes[i] = (unsigned char)NumToInt( item );
+		}
+	}
+	// buffer: a copy (which, for a slice, releases the larger buffer it shares)
+	else
+	{
+		buf = CreateBuffer( *(o->buf) );
+	}
+
+	helper.ReturnVal( Object( buf ) );
+}
+
+void do_is_buffer( Frame* frame )
+{
+	BuiltinHelper helper( NULL, "is_buffer", frame );
+	helper.CheckNumberOfArguments( 1 );
+
+	Object* o = helper.GetLocalN( 0 );
+
+	if( o->type == obj_buffer )
+		helper.ReturnVal( Object( true ) );
+	else
+		helper.ReturnVal( Object( false ) );
+}
+
+void do_stringbuilder( Frame* frame )
+{
+	BuiltinHelper helper( NULL, "stringbuilder", frame );
+	helper.CheckNumberOfArguments( 0, 1 );
+
+	StringBuilder* sb = CreateStringBuilder();
+	// start with the given string, if any
+	if( frame->NumArgsPassed() == 1 )
+	{
+		Object* o = helper.GetLocalN( 0 );
+		helper.ExpectType( o, obj_string );
+		sb->Append( o->s, strlength( o->s ) );
+	}
+
+	helper.ReturnVal( Object( sb ) );
+}
+
+void do_is_stringbuilder( Frame* frame )
+{
+	BuiltinHelper helper( NULL, "is_stringbuilder", frame );
+	helper.CheckNumberOfArguments( 1 );
+
+	Object* o = helper.GetLocalN( 0 );
+
+	if( o->type == obj_stringbuilder )
+		helper.ReturnVal( Object( true ) );
+	else
+		helper.ReturnVal( Object( false ) );
+}
+
 
 } // end namespace deva
@@ -30,6 +30,7 @@
 
 #include "builtins_helpers.h"
 #include "util.h"
+#include "number.h"
 #include <cmath>
 
 namespace deva
@@ -102,15 +103,21 @@ void BuiltinHelper::ExpectTypes( Object* obj, ObjectType t1, ObjectType t2, Obje
 		throw RuntimeException( boost::format( "Unexpected type in %1%%2% %3%." ) % type % (is_method ? "method" : "builtin") % name );
 }
 
+void BuiltinHelper::ExpectTypes( Object* obj, ObjectType t1, ObjectType t2, ObjectType t3, ObjectType t4, ObjectType t5, ObjectType t6 )
+{
+	if( obj->type != t1 && obj->type != t2 && obj->type != t3 && obj->type != t4 && obj->type != t5 && obj->type != t6 )
+		throw RuntimeException( boost::format( "Unexpected type in %1%%2% %3%." ) % type % (is_method ? "method" : "builtin") % name );
+}
+
 void BuiltinHelper::ExpectIntegralNumber( Object* obj )
 {
-	if( obj->type != obj_number || !is_integral( obj->d ) )
+	if( obj->type != obj_number || !IsIntegral( *obj ) )
 		throw RuntimeException( boost::format( "integral number expected in %1%%2% %3%." ) % type % (is_method ? "method" : "builtin") % name );
 }
 
 void BuiltinHelper::ExpectPositiveIntegralNumber( Object* obj )
 {
-	if( obj->type != obj_number || !is_integral( obj->d ) || obj->d < 0.0 )
+	if( obj->type != obj_number || !IsIntegral( *obj ) || obj->Num() < 0.0 )
 		throw RuntimeException( boost::format( "positive integral number expected in %1%%2% %3%." ) % type % (is_method ? "method" : "builtin") % name );
 }
 
@@ -120,6 +127,42 @@ Object* BuiltinHelper::GetLocalN( int local_num )
 	return frame->GetLocalRef( local_num );
 }
 
+const double* BuiltinHelper::GetNumbers( Object* vec, vector<double> & tmp )
+{
+	Vector* v = vec->v;
+	if( v->IsPacked() )
+	{
+		const vector<double> & nums = v->Numbers();
+		return nums.empty() ? NULL : &nums[0];
+	}
+	size_t sz = v->size();
+	tmp.resize( sz );
+	for( size_t i = 0; i < sz; i++ )
+	{
+		Object o = v->Get( i );
+		if( o.type != obj_number )
+			throw RuntimeException( boost::format( "vector of numbers expected in %1%%2% %3%." ) % type % (is_method ? "method" : "builtin") % name );
+		tmp[i] = o.Num();
+	}
+	return tmp.empty() ? NULL : &tmp[0];
+}
+
+Vector* CreateNumberVector( vector<double> & nums )
+{
+	Vector* ret = CreateVector();
+	if( nums.size() > vector_inline_size )
+	{
+		ret->Pack();
+		ret->MutableNumbers().swap( nums );
+	}
+	else
+	{
+		for( size_t i = 0; i < nums.size(); i++ )
+			ret->push_back( NumberObject( nums[i] ) );
+	}
+	return ret;
+}
+
 
 } // end namespace deva
 
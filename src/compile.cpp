@@ -90,24 +90,22 @@ Compiler::Compiler( const char* mod_name, Semantics* sem, bool inter /*=false*/
 			// strip quotes and unescape
 			string str( i->s );
 			str = unescape( strip_quotes( str ) );
-			char* s = new char[str.length()+1];
-			strcpy( s, str.c_str() );
+			char* s = copystr( str );
 			// try to add the string constant, if we aren't allowed to (because
 			// it's a duplicate), free the string
 			if( !code->AddConstant( Object( s ) ) )
-				delete [] s;
+				freestr( s );
 		}
 		else if( i->type == obj_symbol_name )
 		{
 			// strip quotes and unescape
 			string str( i->s );
 			str = unescape( strip_quotes( str ) );
-			char* s = new char[str.length()+1];
-			strcpy( s, str.c_str() );
+			char* s = copystr( str );
 			// try to add the symbol name, if we aren't allowed to (because
 			// it's a duplicate), free the string
 			if( !code->AddConstant( Object( obj_symbol_name, s ) ) )
-				delete [] s;
+				freestr( s );
 		}
 		else
 			code->AddConstant( *i );
@@ -139,6 +137,8 @@ Compiler::Compiler( const char* mod_name, Semantics* sem, bool inter /*=false*/
 	f->module = NULL;
 	f->modulename = module_name;
 	ex->AddFunction( "@main", f );
+	functions.push_back( f );
+	fcn_stack.push_back( f );
 
 	// with its loop-tracking variables
 	in_for_loop.push_back( 0 );
@@ -292,10 +292,9 @@ void Compiler::DefineFun( char* name, char* classname, int line )
 			// strip the string of quotes and unescape it
 			string str( obj.s );
 			str = unescape( strip_quotes( str ) );
-			char* s = new char[str.length()+1];
-			strcpy( s, str.c_str() );
+			char* s = copystr( str );
 			idx = GetConstant( Object( s ) );
-			delete [] s;
+			freestr( s );
 		}
 		else
 			idx = GetConstant( obj );
@@ -306,6 +305,8 @@ void Compiler::DefineFun( char* name, char* classname, int line )
 
 	// add to the list of fcn objects
 	ex->AddFunction( name, fcn );
+	functions.push_back( fcn );
+	fcn_stack.push_back( fcn );
 }
 
 // define an anonymous function and put it on the stack
@@ -383,10 +384,9 @@ void Compiler::DefineLambda( int line )
 			// strip the string of quotes and unescape it
 			string str( obj.s );
 			str = unescape( strip_quotes( str ) );
-			char* s = new char[str.length()+1];
-			strcpy( s, str.c_str() );
+			char* s = copystr( str );
 			idx = GetConstant( Object( s ) );
-			delete [] s;
+			freestr( s );
 		}
 		else
 			idx = GetConstant( obj );
@@ -397,6 +397,8 @@ void Compiler::DefineLambda( int line )
 
 	// add to the list of fcn objects
 	ex->AddFunction( name.c_str(), fcn );
+	functions.push_back( fcn );
+	fcn_stack.push_back( fcn );
 }
 
 void Compiler::EndFun()
@@ -415,6 +417,7 @@ void Compiler::EndFun()
 	BackpatchToCur();
 
 	fcn_scope_stack.pop_back();
+	fcn_stack.pop_back();
 }
 
 // define a class
@@ -495,20 +498,19 @@ void Compiler::String( char* name, int line )
 	// string must be un-quoted and unescaped
 	string str( name );
 	str = unescape( strip_quotes( str ) );
-	char* s = new char[str.length()+1];
-	strcpy( s, str.c_str() );
+	char* s = copystr( str );
 
 	// get the constant pool index for this string
 	int idx = GetConstant( Object( s ) );
 	if( idx == INT_MIN )
 	{
-		delete s;
+		freestr( s );
 		throw ICE( boost::format( "Cannot find constant '%1%'." ) % name );
 	}
 	// emit op to push it onto the stack
 	EmitLineNum( line );
 	Emit( op_pushconst, (dword)idx );
-	delete [] s;
+	freestr( s );
 }
 
 // identifier
@@ -836,7 +838,7 @@ void Compiler::Assign( pANTLR3_BASE_TREE lhs_node, bool parent_is_assign, int li
 				Emit( op_rot3 );
 
 			// simple index
-			Emit( op_tbl_store );
+			Emit( op_tbl_store, code->AddFieldCache() );
 		}
 		else if( num_children == 3 )
 		{
@@ -1287,7 +1289,7 @@ void Compiler::KeyOp( bool is_lhs_of_assign, int num_children, pANTLR3_BASE_TREE
 	if( num_children == 1 )
 	{
 		// (Key ops never generate method_load ops)
-		Emit( op_tbl_load );
+		Emit( op_tbl_load, code->AddFieldCache() );
 	}
 	else if( num_children == 2 )
 	{
@@ -1337,7 +1339,7 @@ void Compiler::DotOp( bool is_lhs_of_assign, pANTLR3_BASE_TREE rhs, pANTLR3_BASE
 	}
 	// otherwise a tbl_load op
 	else
-		Emit( op_tbl_load );
+		Emit( op_tbl_load, code->AddFieldCache() );
 
 }
 
@@ -1543,6 +1545,13 @@ void Compiler::InOp( char* key, char* val, pANTLR3_BASE_TREE container, int line
 		throw ICE( boost::format( "For loop variable '%1%' not found in the local symbols." ) % key );
 	}
 
+	// a single-var loop over a call to 'range' counts instead of iterating
+	// (if 'range' is the builtin at run-time)
+	size_t range_patch = 0;
+	int range_slot = -1;
+	if( !val )
+		range_slot = RangeLoopInit( range_patch );
+
 	EmitLineNum( line );
 
 	// the vector to iterate is on top of the stack, dup it for the calls to
@@ -1561,11 +1570,17 @@ void Compiler::InOp( char* key, char* val, pANTLR3_BASE_TREE container, int line
 
 	// vector to iterate is now on top of the stack again
 
+	// the counting loop starts here
+	if( range_slot != -1 )
+		is->Set( range_patch, (dword)is->Length() );
+
 	// mark the label for the loop beginning
 	AddLabel();
 
 	// generate the for_iter instruction
-	if( !val )
+	if( range_slot != -1 )
+		Emit( op_for_range, (dword)range_slot, (dword)-1 );
+	else if( !val )
 		Emit( op_for_iter, (dword)-1 );
 	else
 		Emit( op_for_iter_pair, (dword)-1 );
@@ -1670,6 +1685,51 @@ void Compiler::InOp( char* key, char* val, pANTLR3_BASE_TREE container, int line
 }
 
 // vectors
+// if the code just emitted is a call to 'range' that a counting loop can
+// replace, turn the call into an op_for_range_init (followed by the call, for
+// when 'range' isn't the builtin at run-time) and return the first of the
+// three locals it uses for the counter, end and step. 'loop_patch' is set to
+// the location of its operand for the address of the loop. returns -1 if
+// this isn't a call to 'range'
+int Compiler::RangeLoopInit( size_t & loop_patch )
+{
+	// not in methods (whose frames have an extra local) or interactive code
+	// (which may run in a frame made before these locals were added)
+	if( interactive || fcn_stack.empty() || fcn_stack.back()->IsMethod() )
+		return -1;
+
+	// 'pushconst range; call <n>'
+	size_t len = is->Length();
+	size_t call_sz = sizeof( byte ) + sizeof( dword );
+	if( len < 2 * call_sz )
+		return -1;
+	const byte* p = is->Bytes() + len - 2 * call_sz;
+	if( (Opcode)p[0] != op_pushconst || (Opcode)p[call_sz] != op_call )
+		return -1;
+	int range_idx = GetConstant( Object( obj_symbol_name, const_cast<char*>("range") ) );
+	dword num_args = *((dword*)(p + call_sz + 1));
+	if( range_idx == INT_MIN || *((dword*)(p + 1)) != (dword)range_idx || num_args < 1 || num_args > 3 )
+		return -1;
+
+	// 'range' mustn't be defined in this module
+	const Symbol* sym = CurrentScope()->Resolve( "range" );
+	if( (sym && !sym->IsUndeclared()) || CurrentScope()->Resolve( "range", sym_function ) )
+		return -1;
+
+	// the locals
+	Function* f = fcn_stack.back();
+	int slot = (int)f->local_names.size();
+	f->local_names.push_back( "@range" );
+	f->local_names.push_back( "@range.end" );
+	f->local_names.push_back( "@range.step" );
+
+	is->Truncate( len - call_sz );
+	Emit( op_for_range_init, num_args, (dword)slot, (dword)-1 );
+	loop_patch = is->Length() - sizeof( dword );
+	Emit( op_call, num_args );
+	return slot;
+}
+
 void Compiler::InOp( char* key, pANTLR3_BASE_TREE container, int line )
 {
 	InOp( key, NULL, container, line );
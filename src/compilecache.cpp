@@ -0,0 +1,222 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// compilecache.cpp
+// shared, content-addressed cache of compiled (.dvc) files
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#include "compilecache.h"
+#include "typedefs.h"
+#include "fileformat.h"
+#include "util.h"
+
+#include <fstream>
+#include <cstdio>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
+#include <ctime>
+#include <boost/filesystem.hpp>
+
+using namespace boost;
+
+namespace deva
+{
+
+extern int _argc;
+extern char** _argv;
+
+static const size_t default_cache_size_mb = 64;
+// temporary files older than this (seconds) were left by a process that died
+// while writing them
+static const time_t stale_temp_age = 60 * 60;
+
+static string CacheDir()
+{
+	const char* dir = getenv( "DEVA_CACHE" );
+	if( !dir || !*dir )
+		return string();
+	system::error_code ec;
+	filesystem::create_directories( filesystem::path( dir ), ec );
+	if( !filesystem::is_directory( filesystem::path( dir ), ec ) )
+		return string();
+	return string( dir );
+}
+
+static size_t CacheSize()
+{
+	const char* sz = getenv( "DEVA_CACHE_SIZE" );
+	if( sz && *sz )
+	{
+		long mb = atol( sz );
+		if( mb > 0 )
+			return (size_t)mb * 1024 * 1024;
+	}
+	return default_cache_size_mb * 1024 * 1024;
+}
+
+// 64-bit FNV-1a
+static inline qword Hash( qword h, const char* p, size_t n )
+{
+	for( size_t i = 0; i < n; i++ )
+	{
+		h ^= (byte)p[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+// a second, unrelated, 64-bit hash for the stamp of an entry (so that two
+// sources would have to collide in both, at the same length, to be confused)
+static inline qword Hash2( const char* p, size_t n )
+{
+	qword h = 0x9e3779b97f4a7c15ULL ^ (qword)n;
+	for( size_t i = 0; i < n; i++ )
+	{
+		h = (h ^ (byte)p[i]) * 0xff51afd7ed558ccdULL;
+		h ^= h >> 29;
+	}
+	return h;
+}
+
+// identifies the compiler: the size and modification time of the running
+// executable, so that a rebuilt deva (whether or not its version or the file
+// format changed) doesn't use entries an older build compiled. if the
+// executable can't be found, the time this file was compiled stands in
+static const string & CompilerId()
+{
+	static string id;
+	if( !id.empty() )
+		return id;
+	system::error_code ec;
+	filesystem::path exe( "/proc/self/exe" );
+	if( !filesystem::exists( exe, ec ) && _argc > 0 && _argv )
+		exe = filesystem::system_complete( filesystem::path( _argv[0] ), ec );
+	qword size = (qword)filesystem::file_size( exe, ec );
+	time_t mtime = ec ? 0 : filesystem::last_write_time( exe, ec );
+	char buf[64];
+	if( ec )
+		sprintf( buf, "%s %s", __DATE__, __TIME__ );
+	else
+		sprintf( buf, "%llu/%llu", (unsigned long long)size, (unsigned long long)mtime );
+	id = buf;
+	return id;
+}
+
+string CompileCacheEntry( const string & dvfile, bool optimize /*= false*/, string* stamp /*= NULL*/ )
+{
+	string dir = CacheDir();
+	if( dir.empty() )
+		return string();
+
+	ifstream file( dvfile.c_str(), ios::binary );
+	if( file.fail() )
+		return string();
+	string src( (istreambuf_iterator<char>( file )), istreambuf_iterator<char>() );
+
+	// the source's full path is part of the key, as it is compiled into the
+	// function objects
+	string path = dvfile;
+	if( !filesystem::path( path ).is_complete() )
+		path = join_paths( get_cwd(), path );
+	string version = string( DEVA_VERSION ) + "/" + file_hdr_ver + "/" + CompilerId() + (optimize ? "/O" : "");
+
+	qword h = 0xcbf29ce484222325ULL;
+	h = Hash( h, version.c_str(), version.size() + 1 );
+	h = Hash( h, path.c_str(), path.size() + 1 );
+	h = Hash( h, src.data(), src.size() );
+
+	char name[32];
+	sprintf( name, "%016llx.dvc", (unsigned long long)h );
+	if( stamp )
+	{
+		char buf[64];
+		sprintf( buf, "%llu/%016llx", (unsigned long long)src.size(), (unsigned long long)Hash2( src.data(), src.size() ) );
+		*stamp = version + "\n" + path + "\n" + buf;
+	}
+	return join_paths( dir, name );
+}
+
+void CompileCacheTouch( const string & entry )
+{
+	system::error_code ec;
+	filesystem::last_write_time( filesystem::path( entry ), time( NULL ), ec );
+}
+
+struct CacheFile
+{
+	time_t mtime;
+	size_t size;
+	filesystem::path path;
+	bool operator < ( const CacheFile & rhs ) const { return mtime < rhs.mtime; }
+};
+
+void CompileCacheTrim()
+{
+	string dir = CacheDir();
+	if( dir.empty() )
+		return;
+
+	// other processes may be adding and removing entries at the same time, so
+	// errors (e.g. an entry that is already gone) are ignored
+	system::error_code ec, iter_ec;
+	vector<CacheFile> entries;
+	size_t total = 0;
+	time_t now = time( NULL );
+	for( filesystem::directory_iterator i( filesystem::path( dir ), iter_ec ), end; !iter_ec && i != end; i.increment( iter_ec ) )
+	{
+		filesystem::path p = i->path();
+		if( !filesystem::is_regular_file( p, ec ) )
+			continue;
+		CacheFile f;
+		f.mtime = filesystem::last_write_time( p, ec );
+		f.size = (size_t)filesystem::file_size( p, ec );
+		f.path = p;
+		if( p.extension().string() != ".dvc" )
+		{
+			if( p.filename().string().find( ".dvc.tmp" ) != string::npos && now - f.mtime > stale_temp_age )
+				filesystem::remove( p, ec );
+			continue;
+		}
+		entries.push_back( f );
+		total += f.size;
+	}
+
+	size_t cap = CacheSize();
+	if( total <= cap )
+		return;
+	sort( entries.begin(), entries.end() );
+	for( size_t i = 0; i < entries.size() && total > cap; i++ )
+	{
+		filesystem::remove( entries[i].path, ec );
+		total -= entries[i].size;
+	}
+}
+
+
+} // end namespace deva
@@ -34,6 +34,8 @@
 #include "module_bit.h"
 #include "module_math.h"
 #include "module_re.h"
+#include "compilecache.h"
+#include "numeric.h"
 
 #include <iostream>
 #include <vector>
@@ -107,6 +109,8 @@ int ANTLR3_CDECL main( int argc, char *argv[] )
 	bool no_dvc = false;
 	bool disasm = false;
 	bool compile_only = false;
+	bool optimize = false;
+	bool precise = false;
 	string output;
 	string input;
 	vector<string> inputs;
@@ -117,6 +121,8 @@ int ANTLR3_CDECL main( int argc, char *argv[] )
 		( "no-dvc", "do NOT write a .dvc compiled byte-code file to disk" )
 		( "compile-only,c", "compile only, do not execute" )
 		( "disasm", "disassemble" )
+		( "optimize,O", "optimize: fold constant expressions and remove unreachable code" )
+		( "precise", "sum vectors (vector.sum/mean/dot) strictly left-to-right, and apply math functions to vectors without SIMD" )
 #ifdef DEBUG
 		( "trace", "show execution trace" )
 		( "reftrace", "show refcount trace" )
@@ -184,6 +190,14 @@ int ANTLR3_CDECL main( int argc, char *argv[] )
 	{
 		compile_only = true;
 	}
+	if( vm.count( "optimize" ) )
+	{
+		optimize = true;
+	}
+	if( vm.count( "precise" ) )
+	{
+		precise = true;
+	}
 	// must be an input file specified
 	if( !vm.count( "input" ) )
 	{
@@ -222,10 +236,14 @@ int ANTLR3_CDECL main( int argc, char *argv[] )
 	Code* code = NULL;
 
 	ex = new Executor();
+	ex->optimize = optimize;
+	SetPreciseReductions( precise );
 
 	ParseReturnValue prv;
 	PassOneReturnValue p1rv;
 	string out_fname;
+	string cache_entry;
+	string stamp;
 	try
 	{
 		// set the file we're compiling
@@ -245,8 +263,34 @@ int ANTLR3_CDECL main( int argc, char *argv[] )
 			struct stat in_statbuf;
 			struct stat out_statbuf;
 
+			// with a shared compile cache, the .dvc file lives in the cache
+			// and is named for the source's contents, so if it exists it is
+			// current
+			cache_entry = CompileCacheEntry( fname, optimize, &stamp );
+			if( !cache_entry.empty() )
+			{
+				out_fname = cache_entry;
+				if( exists( out_fname ) )
+				{
+					try
+					{
+						code = ex->ReadCode( out_fname, stamp );
+						use_dvc = true;
+						CompileCacheTouch( out_fname );
+					}
+					catch( RuntimeException & )
+					{
+						// another process may have evicted the entry (or it is
+						// for another source), just recompile
+					}
+				}
+			}
+			// there's no telling whether an existing .dvc file was optimized,
+			// so when optimizing always recompile
+			else if( optimize )
+				use_dvc = false;
 			// if we can't open the .dvc file, continue on
-			if( stat( out_fname.c_str(), &out_statbuf ) != -1 )
+			else if( stat( out_fname.c_str(), &out_statbuf ) != -1 )
 			{
 				if( stat( fname.c_str(), &in_statbuf ) != -1 ) 
 				{
@@ -268,6 +312,7 @@ int ANTLR3_CDECL main( int argc, char *argv[] )
 			{
 				PassOneFlags p1f; // currently no pass one flags
 				PassTwoFlags p2f;
+				p2f.optimize = optimize;
 
 				// PASS ONE: build the symbol table and check semantics
 				p1rv = PassOne( prv, p1f );
@@ -306,11 +351,15 @@ int ANTLR3_CDECL main( int argc, char *argv[] )
 
 				// by default, write the .dvc file
 				if( !no_dvc )
-					ex->WriteCode( out_fname, code );
+				{
+					ex->WriteCode( out_fname, code, stamp );
+					if( !cache_entry.empty() )
+						CompileCacheTrim();
+				}
 			}
 		}
-		// otherwise, load the .dvc
-		else
+		// otherwise, load the .dvc (unless it was already loaded from the cache)
+		else if( !code )
 		{
 			code = ex->ReadCode( out_fname );
 		}
@@ -331,6 +380,8 @@ int ANTLR3_CDECL main( int argc, char *argv[] )
 			if( disasm )
 			{
 				ex->Decode( code );
+				if( optimize )
+					ex->DumpInlinedCalls();
 			}
 
 			// execute the code
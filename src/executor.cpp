@@ -32,8 +32,12 @@
 #include "string_builtins.h"
 #include "vector_builtins.h"
 #include "map_builtins.h"
+#include "buffer_builtins.h"
+#include "stringbuilder_builtins.h"
 #include "api.h"
 #include "fileformat.h"
+#include "compilecache.h"
+#include "number.h"
 
 #include <algorithm>
 #include <fstream>
@@ -80,10 +84,14 @@ Executor::Executor() :
 	end( NULL ), 
 	scopes( NULL ),
 	is_error( false ),
+	eval_cache_size( 0 ),
+	eval_cache_hits( 0 ),
+	eval_cache_misses( 0 ),
 	debug( false ), 
 	trace( false ),
 	stop_at_breakpoints( false ),
-	stepping( false )
+	stepping( false ),
+	optimize( false )
 {
 	if( instantiated )
 		throw ICE( "Executor is a singleton object, it cannot be instantiated twice." );
@@ -107,28 +115,42 @@ Executor::Executor() :
 	{
 		char* s = copystr( builtin_names[i].c_str() );
 		if( !AddGlobalConstant( Object( obj_symbol_name, s ) ) )
-			delete [] s;
+			freestr( s );
 	}
 	// string builtins
 	for( int i = 0; i < num_of_string_builtins; i++ )
 	{
 		char* s = copystr( string_builtin_names[i].c_str() );
 		if( !AddGlobalConstant( Object( obj_symbol_name, s ) ) )
-			delete [] s;
+			freestr( s );
 	}
 	// vector builtins
 	for( int i = 0; i < num_of_vector_builtins; i++ )
 	{
 		char* s = copystr( vector_builtin_names[i].c_str() );
 		if( !AddGlobalConstant( Object( obj_symbol_name, s ) ) )
-			delete [] s;
+			freestr( s );
 	}
 	// map builtins
 	for( int i = 0; i < num_of_map_builtins; i++ )
 	{
 		char* s = copystr( map_builtin_names[i].c_str() );
 		if( !AddGlobalConstant( Object( obj_symbol_name, s ) ) )
-			delete [] s;
+			freestr( s );
+	}
+	// buffer builtins
+	for( int i = 0; i < num_of_buffer_builtins; i++ )
+	{
+		char* s = copystr( buffer_builtin_names[i].c_str() );
+		if( !AddGlobalConstant( Object( obj_symbol_name, s ) ) )
+			freestr( s );
+	}
+	// string builder builtins
+	for( int i = 0; i < num_of_stringbuilder_builtins; i++ )
+	{
+		char* s = copystr( stringbuilder_builtin_names[i].c_str() );
+		if( !AddGlobalConstant( Object( obj_symbol_name, s ) ) )
+			freestr( s );
 	}
 }
 
@@ -150,13 +172,24 @@ Executor::~Executor()
 	for( size_t i = 0; i < constants.size(); i++ )
 	{
 		ObjectType type = constants.at( i ).type;
-		if( type == obj_string || type == obj_symbol_name ) delete [] constants.at( i ).s;
+		if( type == obj_string || type == obj_symbol_name ) freestr( constants.at( i ).s );
 	}
 	// free the code blocks
 	for( vector<const Code*>::iterator i = code_blocks.begin(); i != code_blocks.end(); ++i )
 	{
 		delete *i;
 	}
+	// and the cached eval() code, and its strings
+	for( map<string, EvalCacheEntry>::iterator i = eval_cache.begin(); i != eval_cache.end(); ++i )
+	{
+		delete i->second.code;
+	}
+	for( set<Object, MapKeyLess>::iterator i = eval_strings.begin(); i != eval_strings.end(); ++i )
+	{
+		freestr( i->s );
+	}
+	// free the instance shapes
+	Shape::FreeShapes();
 }
 
 Object* Executor::FindFunction( string name, string modulename, size_t offset )
@@ -174,7 +207,7 @@ Object* Executor::FindFunction( string name, string modulename, size_t offset )
 		else if( i->second->type == obj_native_function )
 		{
 			// TODO: any check we can do for native fcns module name?
-			if( (size_t)i->second->nf.p == offset )
+			if( (size_t)(NativeFunctionPtr)i->second->nf.p == offset )
 				return i->second;
 		}
 		else
@@ -262,22 +295,32 @@ Object* Executor::FindSymbolInAnyScope( Object sym )
 			return obj;
 
 		// builtin?
-		obj = GetBuiltinObjectRef( sym.s );
+		obj = GetBuiltinObjectRef( string( sym.s ) );
 		if( obj )
 			return obj;
 
 		// string builtin?
-		obj = GetStringBuiltinObjectRef( sym.s );
+		obj = GetStringBuiltinObjectRef( string( sym.s ) );
 		if( obj )
 			return obj;
 
 		// vector builtin?
-		obj = GetVectorBuiltinObjectRef( sym.s );
+		obj = GetVectorBuiltinObjectRef( string( sym.s ) );
 		if( obj )
 			return obj;
 
 		// map builtin?
-		obj = GetMapBuiltinObjectRef( sym.s );
+		obj = GetMapBuiltinObjectRef( string( sym.s ) );
+		if( obj )
+			return obj;
+
+		// buffer builtin?
+		obj = GetBufferBuiltinObjectRef( string( sym.s ) );
+		if( obj )
+			return obj;
+
+		// string builder builtin?
+		obj = GetStringBuilderBuiltinObjectRef( string( sym.s ) );
 		if( obj )
 			return obj;
 	}
@@ -303,15 +346,23 @@ Object Executor::ResolveSymbol( Object sym )
 			// just put the symbol name back on the stack
 			//
 			// string builtin?
-			NativeFunction nf = GetStringBuiltin( sym.s );
+			NativeFunction nf = GetStringBuiltin( string( sym.s ) );
 			if( nf.p )
 				return sym;
 			// vector builtin?
-			nf = GetVectorBuiltin( sym.s );
+			nf = GetVectorBuiltin( string( sym.s ) );
 			if( nf.p )
 				return sym;
 			// map builtin?
-			nf = GetMapBuiltin( sym.s );
+			nf = GetMapBuiltin( string( sym.s ) );
+			if( nf.p )
+				return sym;
+			// buffer builtin?
+			nf = GetBufferBuiltin( string( sym.s ) );
+			if( nf.p )
+				return sym;
+			// string builder builtin?
+			nf = GetStringBuilderBuiltin( string( sym.s ) );
 			if( nf.p )
 				return sym;
 		}
@@ -518,17 +569,17 @@ void Executor::Execute( const Code* const code )
 
 // execute the current (top of stack) code block
 // returns the line number stopped at, or -1 if it reached a 'halt'
-int Executor::ExecuteCode()
+int Executor::ExecuteCode( const Code* const code /*= NULL*/ )
 {
-	BeginExecution();
+	BeginExecution( code );
 	return ContinueExecution();
 }
 
-void Executor::BeginExecution()
+void Executor::BeginExecution( const Code* const c /*= NULL*/ )
 {
-	if( code_blocks.size() == 0 )
+	if( !c && code_blocks.size() == 0 )
 		throw ICE( "No code blocks to execute." );
-	Code* code = (Code*)code_blocks.back();
+	Code* code = (Code*)(c ? c : code_blocks.back());
 
 	// set the ip, bp and end 
 	cur_code = (Code*)code;
@@ -659,42 +710,161 @@ int Executor::StepInto()
 // static used for importing modules and text (via eval())
 static Module* s_currently_importing_module = NULL;
 
+// limits for the eval() compile cache: number of entries, and total size of
+// the cached text and byte-code
+static const size_t eval_cache_max_entries = 256;
+static const size_t eval_cache_max_size = 4 * 1024 * 1024;
+
+Executor::EvalCacheEntry* Executor::FindEvalCache( const string & key )
+{
+	map<string, EvalCacheEntry>::iterator i = eval_cache.find( key );
+	// (text which evals itself can't re-use the code it is running)
+	if( i == eval_cache.end() || i->second.running )
+	{
+		eval_cache_misses++;
+		return NULL;
+	}
+	eval_cache_hits++;
+	// move it to the most recently used end
+	eval_cache_lru.splice( eval_cache_lru.end(), eval_cache_lru, i->second.lru );
+	return &(i->second);
+}
+
+// returns false if the code wasn't cached (the caller still owns it)
+bool Executor::AddEvalCache( const string & key, Code* code, const string & name, Object* main )
+{
+	EvalCacheEntry entry;
+	entry.code = code;
+	entry.name = name;
+	entry.main = main;
+	entry.size = key.size() + code->len;
+	entry.running = false;
+	// (the text may be cached already, if it was running when it was eval'd)
+	if( entry.size > eval_cache_max_size || eval_cache.count( key ) != 0 )
+		return false;
+	// evict the least recently used entries to make room
+	while( !eval_cache.empty() && (eval_cache.size() >= eval_cache_max_entries || eval_cache_size + entry.size > eval_cache_max_size) )
+		EvictEvalCache();
+	code->ShareStrings( eval_strings );
+	entry.lru = eval_cache_lru.insert( eval_cache_lru.end(), key );
+	eval_cache.insert( make_pair( key, entry ) );
+	eval_cache_size += entry.size;
+	return true;
+}
+
+// evict the least recently used entry, freeing its code and '@main'. the
+// modules it ran in stay, without their code
+void Executor::EvictEvalCache()
+{
+	map<string, EvalCacheEntry>::iterator i = eval_cache.find( eval_cache_lru.front() );
+	EvalCacheEntry & entry = i->second;
+	eval_cache_size -= entry.size;
+	modules.erase( entry.name );
+	if( entry.running )
+	{
+		// (it is freed with the executor)
+		AddCode( entry.code );
+	}
+	else
+	{
+		for( multimap<string, Object*>::iterator f = functions.begin(); f != functions.end(); ++f )
+		{
+			if( f->second == entry.main )
+			{
+				functions.erase( f );
+				break;
+			}
+		}
+		delete entry.main->f;
+		delete entry.main;
+		delete entry.code;
+	}
+	eval_cache.erase( i );
+	eval_cache_lru.pop_front();
+}
+
 Object Executor::ExecuteText( const char* const text, bool global /*= false*/, bool ignore_undefined_vars /*= false*/ )
 {
-	static dword count = 0;
-	ostringstream s;
-	s << "[TEXT" << count << "]";
-	count++;
-	string name = s.str();
-	// add the 'text module' name to the list of global constants 
-	AddGlobalConstant( Object( obj_symbol_name, copystr( name ) ) );
-	const Code* code = LoadText( text, name.c_str(), ignore_undefined_vars );
+	// the flags are part of the key, as 'ignore_undefined_vars' changes how
+	// the text is compiled
+	string key( text );
+	key += (char)('0' + (global ? 1 : 0) + (ignore_undefined_vars ? 2 : 0));
 
 	Code* orig_code = cur_code;
 	byte* orig_ip = ip;
 	byte* orig_bp = bp;
 	byte* orig_end = end;
 
+	const Code* code;
+	string name;
+	EvalCacheEntry* cached = FindEvalCache( key );
+	if( cached )
+	{
+		code = cached->code;
+		cached->running = true;
+	}
+	else
+	{
+		static dword count = 0;
+		ostringstream s;
+		s << "[TEXT" << count << "]";
+		count++;
+		name = s.str();
+		// add the 'text module' name to the list of global constants 
+		AddGlobalConstant( Object( obj_symbol_name, copystr( name ) ) );
+		code = LoadText( text, name.c_str(), ignore_undefined_vars );
+	}
+
 	// find our 'module' function, "name@main"
-	Object *eval_main = FindFunction( "@main", name, 0 );
+	Object *eval_main = cached ? cached->main : FindFunction( "@main", name, 0 );
+
+	// each call runs in a module of its own, with a new frame and scope
+	// (cached code's module is not added to 'modules', which has the one it
+	// first ran in)
 	Frame* frame = new Frame( NULL, scopes, code->code, code->code, 0, eval_main->f, true );
 	PushFrame( frame );
 	Scope* scope = new Scope( frame, false, true );
 	PushScope( scope );
 
-	Module* cur_module = AddModule( name.c_str(), code, scope, frame, global );
+	Module* cur_module;
+	if( cached )
+		cur_module = new Module( code, scope, frame, global );
+	else
+		cur_module = AddModule( name.c_str(), code, scope, frame, global );
 	eval_main->f->module = cur_module;
 
+	if( !cached )
+	{
+		// text that defines functions or classes isn't cached: their
+		// function objects point at the module they were last defined in, so
+		// re-running the code would re-bind them away from earlier modules
+		size_t num_fcns = 0;
+		for( multimap<string, Object*>::iterator i = functions.begin(); i != functions.end(); ++i )
+		{
+			if( i->second->type == obj_function && i->second->f->modulename == name )
+				num_fcns++;
+		}
+		if( num_fcns != 1 || !AddEvalCache( key, (Code*)code, name, eval_main ) )
+			AddCode( code );
+		else
+			eval_cache[key].running = true;
+	}
+
 	// currently importing text module, set the flag
 	Module* prev_mod = s_currently_importing_module;
 	s_currently_importing_module = cur_module;
 
 	// execute
-	AddCode( code );
+	// (if it throws the code stays marked as running, and the text is
+	// compiled again the next time, rather than re-using it)
 	bool sab = stop_at_breakpoints;
 	stop_at_breakpoints = false;
-	ExecuteCode();
+	ExecuteCode( code );
 	stop_at_breakpoints = sab;
+	// (the code may have evicted itself, if it eval'd other text)
+	map<string, EvalCacheEntry>::iterator ce = eval_cache.find( key );
+	if( ce != eval_cache.end() && ce->second.code == code )
+		ce->second.running = false;
 	
 	// no longer importing this module, reset the flag
 	s_currently_importing_module = prev_mod;
@@ -702,17 +872,18 @@ Object Executor::ExecuteText( const char* const text, bool global /*= false*/, b
 	// add the module to load-ordered stack (for deletion, searching etc)
 	module_stack.push_back( cur_module );
 
-	// if this was being added to the 'globals', we need to add its constants to
-	// the global constants
-	if( global )
+	// if this was being added to the 'globals', we need to add its
+	// constants to the global constants
+	// (cached code did the first time it ran)
+	if( global && !cached )
 	{
 		for( int i = 0; i < code->NumConstants(); i++ )
 		{
 			Object ob = code->GetConstant( i );
 			if( ob.type == obj_string || ob.type == obj_symbol_name )
-				ob.s = copystr( ob.s );
+				ob.s = dupstr( ob.s );
 			if( !AddGlobalConstant( ob ) )
-				delete [] ob.s;
+				freestr( ob.s );
 		}
 	}
 
@@ -747,15 +918,15 @@ Opcode Executor::ExecuteToReturn( bool skip_breakpoints /*= false*/, bool is_des
 	return op;
 }
 
-// helper for slicing vectors in steps (see vector_builtins.cpp for fcn def)
-static size_t s_step = 1;
-static size_t s_i = 0;
-bool if_step_ex( Object )
+// append to a string builder in place, for the addition assignment operators
+static void AppendToStringBuilder( StringBuilder* sb, const Object & rhs )
 {
-	if( s_i++ % s_step == 0 )
-		return false;
+	if( rhs.type == obj_string )
+		sb->Append( rhs.s, strlength( rhs.s ) );
+	else if( rhs.type == obj_stringbuilder )
+		sb->Append( string( rhs.sb->str() ) );
 	else
-		return true;
+		throw RuntimeException( "Right-hand side of addition assignment operator on a string builder must be a string or a string builder." );
 }
 
 static size_t s_stack_depth = 0;
@@ -764,8 +935,12 @@ Opcode Executor::ExecuteInstruction()
 	dword arg, arg2, arg3;
 	Object o, lhs, rhs, *plhs;
 
-	// decode opcode
+	// decode opcode (behind the prefix, for one with dword operands)
+	byte* instr = ip;
 	Opcode op = (Opcode)*ip;
+	bool wide = op == op_wide;
+	if( wide )
+		op = (Opcode)ip[1];
 
 	if( trace )
 	{
@@ -786,7 +961,7 @@ Opcode Executor::ExecuteInstruction()
 		}
 	}
 
-	ip++;
+	ip += wide ? 2 : 1;
 	switch( op )
 	{
 	case op_nop:
@@ -801,9 +976,8 @@ Opcode Executor::ExecuteInstruction()
 	case op_push:
 		// push an integer value directly
 		// 1 arg
-		arg = *((dword*)ip);
-		stack.push_back( Object( (double)(int)arg ) );
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
+		stack.push_back( Object( (int64_t)(int)arg ) );
 		break;
 	case op_push_true:
 		stack.push_back( Object( true ) );
@@ -815,10 +989,10 @@ Opcode Executor::ExecuteInstruction()
 		stack.push_back( Object( obj_null ) );
 		break;
 	case op_push_zero:
-		stack.push_back( Object( 0.0 ) );
+		stack.push_back( Object( (int64_t)0 ) );
 		break;
 	case op_push_one:
-		stack.push_back( Object( 1.0 ) );
+		stack.push_back( Object( (int64_t)1 ) );
 		break;
 	// TODO: push0, 1, 2, 3 ops are pretty useless. remove them?
 	case op_push0:
@@ -835,8 +1009,7 @@ Opcode Executor::ExecuteInstruction()
 		break;
 	case op_pushlocal:
 		// 1 arg
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		stack.push_back( CurrentFrame()->GetLocal( arg ) );
 		IncRef( stack.back() );
 		break;
@@ -882,7 +1055,7 @@ Opcode Executor::ExecuteInstruction()
 		break;
 	case op_pushconst:
 		// 1 arg: index to constant
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		{
 			// TODO: Resolve the constant sym *here* and remove all the calls to
 			// ResolveSymbol when an obj is popped off the stack ???
@@ -891,11 +1064,10 @@ Opcode Executor::ExecuteInstruction()
 			IncRef( tmp );
 			stack.push_back( tmp );
 		}
-		ip += sizeof( dword );
 		break;
 	case op_storeconst:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant( arg );
 		// find the variable
@@ -906,11 +1078,10 @@ Opcode Executor::ExecuteInstruction()
 		stack.pop_back();
 		DecRef( *plhs );
 		*plhs = rhs;
-		ip += sizeof( dword );
 		break;
 	case op_store_true:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant(arg);
 		// find the variable
@@ -919,11 +1090,10 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( boost::format( "Symbol '%1%' not found." ) % o.s );
 		DecRef( *plhs );
 		*plhs = Object( true );
-		ip += sizeof( dword );
 		break;
 	case op_store_false:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant(arg);
 		// find the variable
@@ -932,11 +1102,10 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( boost::format( "Symbol '%1%' not found." ) % o.s );
 		DecRef( *plhs );
 		*plhs = Object( true );
-		ip += sizeof( dword );
 		break;
 	case op_store_null:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant(arg);
 		// find the variable
@@ -945,17 +1114,15 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( boost::format( "Symbol '%1%' not found." ) % o.s );
 		DecRef( *plhs );
 		*plhs = Object( obj_null );
-		ip += sizeof( dword );
 		break;
 	case op_storelocal:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
 		stack.pop_back();
 		// set the local in the current frame
 		CurrentFrame()->SetLocal( arg, rhs );
-		ip += sizeof( dword );
 		break;
 	case op_storelocal0:
 		rhs = stack.back();
@@ -1030,7 +1197,7 @@ Opcode Executor::ExecuteInstruction()
 	case op_def_local:
 		{
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
 		stack.pop_back();
@@ -1039,7 +1206,6 @@ Opcode Executor::ExecuteInstruction()
 		// define the local in the current scope
 		// (this frame cannot be native fcn, obviously)
 		CurrentScope()->AddSymbol( CurrentFrame()->GetFunction()->local_names.operator[]( arg ), arg );
-		ip += sizeof( dword );
 		}
 		break;
 	case op_def_local0:
@@ -1145,12 +1311,9 @@ Opcode Executor::ExecuteInstruction()
 	case op_def_function:
 		{
 		// 3 args: constant index of fcn name, const idx of module name, address of fcn
-		arg2 = *((dword*)ip);
-		ip += sizeof( dword );
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
-		arg3 = *((dword*)ip);
-		ip += sizeof( dword );
+		arg2 = ReadOperand( ip, wide );
+		arg = ReadOperand( ip, wide );
+		arg3 = ReadOperand( ip, wide );
 		// find the constant for the fcn name
 		Object fcnname = GetConstant( arg2 );
 		if( fcnname.type != obj_string && fcnname.type != obj_symbol_name )
@@ -1162,7 +1325,7 @@ Opcode Executor::ExecuteInstruction()
 			throw ICE( "def_function instruction called with an object that is not a module name." );
 		string module_name( modname.s );
 		// find the function
-		Object* objf = FindFunction( name, module_name, (size_t)arg3 );
+		Object* objf = FindFunction( name, module_name, (size_t)(instr - bp) + (int)arg3 );
 		if( !objf )
 			throw RuntimeException( boost::format( "Function '%1%' not found." ) % name );
 		// if we're currently importing a module, set the functions module ptr
@@ -1185,14 +1348,10 @@ Opcode Executor::ExecuteInstruction()
 	case op_def_method:
 		{
 		// 4 args: constant index of fcn name, const index of class name, const idx of module name, address of fcn
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
-		arg2 = *((dword*)ip);
-		ip += sizeof( dword );
-		dword arg4 = *((dword*)ip);
-		ip += sizeof( dword );
-		arg3 = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
+		arg2 = ReadOperand( ip, wide );
+		dword arg4 = ReadOperand( ip, wide );
+		arg3 = ReadOperand( ip, wide );
 
 		// find the function name
 		Object fcnname = GetConstant( arg );
@@ -1212,7 +1371,7 @@ Opcode Executor::ExecuteInstruction()
 		string module_name( modname.s );
 
 		// find the function
-		Object* objf = FindFunction( function_name, module_name, (size_t)arg3 );
+		Object* objf = FindFunction( function_name, module_name, (size_t)(instr - bp) + (int)arg3 );
 		if( !objf )
 			throw RuntimeException( boost::format( "Function '%1%' not found." ) % function_name );
 
@@ -1233,8 +1392,7 @@ Opcode Executor::ExecuteInstruction()
 	case op_new_map:
 		{
 		// 1 arg: size
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		// create the map
 		Object m = Object( CreateMap() );
 		// populate it with 'arg' pairs off the stack
@@ -1255,8 +1413,7 @@ Opcode Executor::ExecuteInstruction()
 	case op_new_vec:
 		{
 		// 1 arg: size
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		// create the new vector with 'arg' empty slots
 		Object v = Object( CreateVector( (int)arg ) );
 		// populate it with 'arg' items off the stack
@@ -1267,6 +1424,9 @@ Opcode Executor::ExecuteInstruction()
 			stack.pop_back();
 			v.v->operator[]( arg-i-1 ) = o;
 		}
+		// store (non-trivial) all-number literals packed
+		if( arg > vector_inline_size )
+			v.v->Pack();
 		IncRef( v );
 		stack.push_back( v );
 		}
@@ -1274,8 +1434,7 @@ Opcode Executor::ExecuteInstruction()
 	case op_new_class:
 		{
 		// 1 arg: size = number of base classes
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		// create the map and turn it into a class
 		Object m;
 		m.MakeClass( CreateMap() );
@@ -1352,31 +1511,27 @@ Opcode Executor::ExecuteInstruction()
 		break;
 	case op_jmp:
 		// 1 arg: size
-		arg = *((dword*)ip);
-		ip = (byte*)(bp + arg);
+		arg = ReadOperand( ip, wide );
+		ip = instr + (int)arg;
 		break;
 	case op_jmpt:
 		// 1 arg: size
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		o = stack.back();
 		o = ResolveSymbol( o );
 		stack.pop_back();
 		if( o.CoerceToBool() )
-			ip = (byte*)(bp + arg);
-		else
-			ip += sizeof( dword );
+			ip = instr + (int)arg;
 		DecRef( o );
 		break;
 	case op_jmpf:
 		// 1 arg: size
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		o = stack.back();
 		o = ResolveSymbol( o );
 		stack.pop_back();
 		if( !o.CoerceToBool() )
-			ip = (byte*)(bp + arg);
-		else
-			ip += sizeof( dword );
+			ip = instr + (int)arg;
 		DecRef( o );
 		break;
 	case op_eq:
@@ -1397,9 +1552,9 @@ Opcode Executor::ExecuteInstruction()
 		{
 		case obj_null: stack.push_back( Object( rhs.type == obj_null ) ); break;
 		case obj_boolean: stack.push_back( Object( lhs.b == rhs.b ) ); break;
-		case obj_number: stack.push_back( Object( lhs.d == rhs.d ) ); break;
+		case obj_number: stack.push_back( Object( NumEqual( lhs, rhs ) ) ); break;
 		case obj_symbol_name:
-		case obj_string: stack.push_back( Object( strcmp( lhs.s, rhs.s ) == 0 ) ); break;
+		case obj_string: stack.push_back( Object( eqstr( lhs.s, rhs.s ) ) ); break;
 		case obj_vector: stack.push_back( Object( lhs.v == rhs.v ) ); break;
 		case obj_map:
 		case obj_class:
@@ -1411,6 +1566,8 @@ Opcode Executor::ExecuteInstruction()
 		case obj_size: stack.push_back( Object( lhs.sz == rhs.sz ) ); break;
 		case obj_module: stack.push_back( Object( lhs.mod == rhs.mod ) ); break;
 		case obj_native_module: stack.push_back( Object( lhs.nm == rhs.nm ) ); break;
+		case obj_buffer: stack.push_back( Object( lhs.buf->Compare( *rhs.buf ) == 0 ) ); break;
+		case obj_stringbuilder: stack.push_back( Object( lhs.sb == rhs.sb ) ); break;
 		case obj_end: throw ICE( "Invalid object in op_eq." ); break;
 		}
 		break;
@@ -1427,9 +1584,9 @@ Opcode Executor::ExecuteInstruction()
 		{
 		case obj_null: stack.push_back( Object( rhs.type != obj_null ) ); break;
 		case obj_boolean: stack.push_back( Object( lhs.b != rhs.b ) ); break;
-		case obj_number: stack.push_back( Object( lhs.d != rhs.d ) ); break;
+		case obj_number: stack.push_back( Object( !NumEqual( lhs, rhs ) ) ); break;
 		case obj_symbol_name:
-		case obj_string: stack.push_back( Object( strcmp( lhs.s, rhs.s ) != 0 ) ); break;
+		case obj_string: stack.push_back( Object( !eqstr( lhs.s, rhs.s ) ) ); break;
 		case obj_vector: stack.push_back( Object( lhs.v != rhs.v ) ); break;
 		case obj_map:
 		case obj_class:
@@ -1441,9 +1598,21 @@ Opcode Executor::ExecuteInstruction()
 		case obj_size: stack.push_back( Object( lhs.sz != rhs.sz ) ); break;
 		case obj_module: stack.push_back( Object( lhs.mod != rhs.mod ) ); break;
 		case obj_native_module: stack.push_back( Object( lhs.nm != rhs.nm ) ); break;
+		case obj_buffer: stack.push_back( Object( rhs.type != obj_buffer || lhs.buf->Compare( *rhs.buf ) != 0 ) ); break;
+		case obj_stringbuilder: stack.push_back( Object( lhs.sb != rhs.sb ) ); break;
 		case obj_end: throw ICE( "Invalid object in op_neq." ); break;
 		}
 		break;
+	case op_lt_num:
+		// operands the optimizer expects to be numbers. if they are, skip the
+		// symbol resolution and type checks, if not do what op_lt does
+		if( TopTwoAreNumbers() )
+		{
+			rhs = stack.back();
+			stack.pop_back();
+			stack.back() = Object( NumLess( stack.back(), rhs ) );
+			break;
+		}
 	case op_lt:
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
@@ -1456,12 +1625,20 @@ Opcode Executor::ExecuteInstruction()
 		if( lhs.type != rhs.type )
 			throw RuntimeException( "Less-than operator used on operands of different types." );
 		if( lhs.type == obj_number )
-			stack.push_back( Object( lhs.d < rhs.d ) );
+			stack.push_back( Object( NumLess( lhs, rhs ) ) );
 		else if( lhs.type == obj_string )
-			stack.push_back( Object( strcmp( lhs.s, rhs.s ) < 0 ) );
+			stack.push_back( Object( cmpstr( lhs.s, rhs.s ) < 0 ) );
 		else
 			throw RuntimeException( "Operands to less-than operator must be numbers or strings." );
 		break;
+	case op_lte_num:
+		if( TopTwoAreNumbers() )
+		{
+			rhs = stack.back();
+			stack.pop_back();
+			stack.back() = Object( NumLessEqual( stack.back(), rhs ) );
+			break;
+		}
 	case op_lte:
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
@@ -1474,12 +1651,20 @@ Opcode Executor::ExecuteInstruction()
 		if( lhs.type != rhs.type )
 			throw RuntimeException( "Less-than-or-equals operator used on operands of different types." );
 		if( lhs.type == obj_number )
-			stack.push_back( Object( lhs.d <= rhs.d ) );
+			stack.push_back( Object( NumLessEqual( lhs, rhs ) ) );
 		else if( lhs.type == obj_string )
-			stack.push_back( Object( strcmp( lhs.s, rhs.s ) <= 0 ) );
+			stack.push_back( Object( cmpstr( lhs.s, rhs.s ) <= 0 ) );
 		else
 			throw RuntimeException( "Operands to less-than-or-equals operator must be numbers or strings." );
 		break;
+	case op_gt_num:
+		if( TopTwoAreNumbers() )
+		{
+			rhs = stack.back();
+			stack.pop_back();
+			stack.back() = Object( NumLess( rhs, stack.back() ) );
+			break;
+		}
 	case op_gt:
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
@@ -1492,12 +1677,20 @@ Opcode Executor::ExecuteInstruction()
 		if( lhs.type != rhs.type )
 			throw RuntimeException( "Greater-than operator used on operands of different types." );
 		if( lhs.type == obj_number )
-			stack.push_back( Object( lhs.d > rhs.d ) );
+			stack.push_back( Object( NumLess( rhs, lhs ) ) );
 		else if( lhs.type == obj_string )
-			stack.push_back( Object( strcmp( lhs.s, rhs.s ) > 0 ) );
+			stack.push_back( Object( cmpstr( lhs.s, rhs.s ) > 0 ) );
 		else
 			throw RuntimeException( "Operands to greater-than operator must be numbers or strings." );
 		break;
+	case op_gte_num:
+		if( TopTwoAreNumbers() )
+		{
+			rhs = stack.back();
+			stack.pop_back();
+			stack.back() = Object( NumLessEqual( rhs, stack.back() ) );
+			break;
+		}
 	case op_gte:
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
@@ -1510,9 +1703,9 @@ Opcode Executor::ExecuteInstruction()
 		if( lhs.type != rhs.type )
 			throw RuntimeException( "Greater-than-or-equals operator used on operands of different types." );
 		if( lhs.type == obj_number )
-			stack.push_back( Object( lhs.d >= rhs.d ) );
+			stack.push_back( Object( NumLessEqual( rhs, lhs ) ) );
 		else if( lhs.type == obj_string )
-			stack.push_back( Object( strcmp( lhs.s, rhs.s ) >= 0 ) );
+			stack.push_back( Object( cmpstr( lhs.s, rhs.s ) >= 0 ) );
 		else
 			throw RuntimeException( "Operands to greater-than-or-equals operator must be numbers or strings." );
 		break;
@@ -1544,7 +1737,7 @@ Opcode Executor::ExecuteInstruction()
 		stack.pop_back();
 		if( o.type != obj_number )
 			throw RuntimeException( "Negate operator can only be used on numeric objects." );
-		stack.push_back( Object( -o.d ) );
+		stack.push_back( NumNeg( o ) );
 		break;
 	case op_not:
 		o = stack.back();
@@ -1553,6 +1746,14 @@ Opcode Executor::ExecuteInstruction()
 		stack.pop_back();
 		stack.push_back( Object( !o.CoerceToBool() ) );
 		break;
+	case op_add_num:
+		if( TopTwoAreNumbers() )
+		{
+			rhs = stack.back();
+			stack.pop_back();
+			stack.back() = NumAdd( stack.back(), rhs );
+			break;
+		}
 	case op_add:
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
@@ -1567,18 +1768,22 @@ Opcode Executor::ExecuteInstruction()
 		if( lhs.type != rhs.type )
 			throw RuntimeException( "Addition operator used on operands of different types." );
 		if( lhs.type == obj_number )
-			stack.push_back( Object( lhs.d + rhs.d ) );
+			stack.push_back( NumAdd( lhs, rhs ) );
 		else if( lhs.type == obj_string )
 		{
-			size_t len = strlen( lhs.s ) + strlen( rhs.s ) + 1;
-			char* ret = new char[len];
-			memset( ret, 0, len );
-			strcpy( ret, lhs.s );
-			strcat( ret, rhs.s );
+			char* ret = catstr( lhs.s, rhs.s );
 			CurrentFrame()->AddString( ret );
 			stack.push_back( Object( ret ) ); 
 		}
 		break;
+	case op_sub_num:
+		if( TopTwoAreNumbers() )
+		{
+			rhs = stack.back();
+			stack.pop_back();
+			stack.back() = NumSub( stack.back(), rhs );
+			break;
+		}
 	case op_sub:
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
@@ -1590,8 +1795,16 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of subtraction operator must be a number." );
 		if( rhs.type != obj_number )
 			throw RuntimeException( "Right-hand side of subtraction operator must be a number." );
-		stack.push_back( Object( lhs.d - rhs.d ) );
+		stack.push_back( NumSub( lhs, rhs ) );
 		break;
+	case op_mul_num:
+		if( TopTwoAreNumbers() )
+		{
+			rhs = stack.back();
+			stack.pop_back();
+			stack.back() = NumMul( stack.back(), rhs );
+			break;
+		}
 	case op_mul:
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
@@ -1603,8 +1816,16 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of multiplication operator must be a number." );
 		if( rhs.type != obj_number )
 			throw RuntimeException( "Right-hand side of multiplication operator must be a number." );
-		stack.push_back( Object( lhs.d * rhs.d ) );
+		stack.push_back( NumMul( lhs, rhs ) );
 		break;
+	case op_div_num:
+		if( TopTwoAreNumbers() && stack.back().Num() != 0.0 )
+		{
+			rhs = stack.back();
+			stack.pop_back();
+			stack.back() = NumDiv( stack.back(), rhs );
+			break;
+		}
 	case op_div:
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
@@ -1616,10 +1837,18 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of division operator must be a number." );
 		if( rhs.type != obj_number )
 			throw RuntimeException( "Right-hand side of division operator must be a number." );
-		if( rhs.d == 0.0 )
+		if( rhs.Num() == 0.0 )
 			throw RuntimeException( "Division by zero fault." );
-		stack.push_back( Object( lhs.d / rhs.d ) );
+		stack.push_back( NumDiv( lhs, rhs ) );
 		break;
+	case op_mod_num:
+		if( TopTwoAreNumbers() && stack.back().Num() != 0.0 && IsIntegral( stack.back() ) && IsIntegral( stack[stack.size() - 2] ) )
+		{
+			rhs = stack.back();
+			stack.pop_back();
+			stack.back() = NumMod( stack.back(), rhs );
+			break;
+		}
 	case op_mod:
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
@@ -1631,16 +1860,16 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of modulus operator must be a number." );
 		if( rhs.type != obj_number )
 			throw RuntimeException( "Right-hand side of modulus operator must be a number." );
-		if( rhs.d == 0.0 )
+		if( rhs.Num() == 0.0 )
 			throw RuntimeException( "Division by zero fault." );
 		// error if arguments aren't integral numbers...
-		if( !is_integral( lhs.d ) || !is_integral( rhs.d ) )
+		if( !IsIntegral( lhs ) || !IsIntegral( rhs ) )
 			throw RuntimeException( "Operands in modulus operator must be integral numbers." );
-		stack.push_back( Object( (double)((int)lhs.d % (int)rhs.d) ) );
+		stack.push_back( NumMod( lhs, rhs ) );
 		break;
 	case op_add_assign: // add <Op0> and tos and store back into <Op0>
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant( arg );
 		// find the variable
@@ -1651,29 +1880,30 @@ Opcode Executor::ExecuteInstruction()
 		rhs = ResolveSymbol( rhs );
 		DecRef( rhs );
 		stack.pop_back();
+		// string builders grow in place
+		if( plhs->type == obj_stringbuilder )
+		{
+			AppendToStringBuilder( plhs->sb, rhs );
+			break;
+		}
 		if( plhs->type != obj_number && plhs->type != obj_string )
-			throw RuntimeException( "Left-hand side of addition assignment operator must be a number or a string." );
+			throw RuntimeException( "Left-hand side of addition assignment operator must be a number, a string or a string builder." );
 		if( rhs.type != obj_number && rhs.type != obj_string )
 			throw RuntimeException( "Right-hand side of addition assignment operator must be a number or a string." );
 		if( plhs->type != rhs.type )
 			throw RuntimeException( "Addition assignment operator used on operands of different types." );
 		if( plhs->type == obj_number )
-			*plhs = Object( plhs->d + rhs.d );
+			*plhs = NumAdd( *plhs, rhs );
 		else if( plhs->type == obj_string )
 		{
-			size_t len = strlen( plhs->s ) + strlen( rhs.s ) + 1;
-			char* ret = new char[len];
-			memset( ret, 0, len );
-			strcpy( ret, plhs->s );
-			strcat( ret, rhs.s );
+			char* ret = catstr( plhs->s, rhs.s );
 			CurrentFrame()->AddString( ret );
 			*plhs = Object( ret );
 		}
-		ip += sizeof( dword );
 		break;
 	case op_sub_assign:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant( arg );
 		// find the variable
@@ -1687,12 +1917,11 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of subtraction assignment operator must be a number." );
 		if( rhs.type != obj_number && rhs.type != obj_string )
 			throw RuntimeException( "Right-hand side of subtraction assignment operator must be a number." );
-		*plhs = Object( plhs->d - rhs.d );
-		ip += sizeof( dword );
+		*plhs = NumSub( *plhs, rhs );
 		break;
 	case op_mul_assign:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant( arg );
 		// find the variable
@@ -1706,12 +1935,11 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of multiplication assignment operator must be a number." );
 		if( rhs.type != obj_number && rhs.type != obj_string )
 			throw RuntimeException( "Right-hand side of multiplication assignment operator must be a number." );
-		*plhs = Object( plhs->d * rhs.d );
-		ip += sizeof( dword );
+		*plhs = NumMul( *plhs, rhs );
 		break;
 	case op_div_assign:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant( arg );
 		// find the variable
@@ -1725,14 +1953,13 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of division assignment operator must be a number." );
 		if( rhs.type != obj_number && rhs.type != obj_string )
 			throw RuntimeException( "Right-hand side of division assignment operator must be a number." );
-		if( rhs.d == 0.0 )
+		if( rhs.Num() == 0.0 )
 			throw RuntimeException( "Divide-by-zero error." );
-		*plhs = Object( plhs->d / rhs.d );
-		ip += sizeof( dword );
+		*plhs = NumDiv( *plhs, rhs );
 		break;
 	case op_mod_assign:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant( arg );
 		// find the variable
@@ -1746,45 +1973,46 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of modulus assignment operator must be a number." );
 		if( rhs.type != obj_number && rhs.type != obj_string )
 			throw RuntimeException( "Right-hand side of modulus assignment operator must be a number." );
-		if( rhs.d == 0.0 )
+		if( rhs.Num() == 0.0 )
 			throw RuntimeException( "Divide-by-zero error." );
 		// error if arguments aren't integral numbers...
-		if( !is_integral( lhs.d ) || !is_integral( rhs.d ) )
+		if( !IsIntegral( *plhs ) || !IsIntegral( rhs ) )
 			throw RuntimeException( "Operands in modulus operator must be integral numbers." );
-		*plhs = Object( (double)((int)plhs->d / (int)rhs.d) );
-		ip += sizeof( dword );
+		*plhs = NumMod( *plhs, rhs );
 		break;
 	case op_add_assign_local:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the local
 		lhs = CurrentFrame()->GetLocal( arg );
 		rhs = stack.back();
 		rhs = ResolveSymbol( rhs );
 		stack.pop_back();
+		// string builders grow in place
+		if( lhs.type == obj_stringbuilder )
+		{
+			AppendToStringBuilder( lhs.sb, rhs );
+			DecRef( rhs );
+			break;
+		}
 		if( lhs.type != obj_number && lhs.type != obj_string )
-			throw RuntimeException( "Left-hand side of addition assignment operator must be a number or a string." );
+			throw RuntimeException( "Left-hand side of addition assignment operator must be a number, a string or a string builder." );
 		if( rhs.type != obj_number && rhs.type != obj_string )
 			throw RuntimeException( "Right-hand side of addition assignment operator must be a number or a string." );
 		if( lhs.type != rhs.type )
 			throw RuntimeException( "Addition assignment operator used on operands of different types." );
 		if( lhs.type == obj_number )
-			CurrentFrame()->SetLocal( arg, Object( lhs.d + rhs.d ) );
+			CurrentFrame()->SetLocal( arg, NumAdd( lhs, rhs ) );
 		else if( lhs.type == obj_string )
 		{
-			size_t len = strlen( lhs.s ) + strlen( rhs.s ) + 1;
-			char* ret = new char[len];
-			memset( ret, 0, len );
-			strcpy( ret, lhs.s );
-			strcat( ret, rhs.s );
+			char* ret = catstr( lhs.s, rhs.s );
 			CurrentFrame()->AddString( ret );
 			CurrentFrame()->SetLocal( arg, Object( ret ) );
 		}
-		ip += sizeof( dword );
 		break;
 	case op_sub_assign_local:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the local
 		lhs = CurrentFrame()->GetLocal( arg );
 		// find the variable
@@ -1795,12 +2023,11 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of subtraction assignment operator must be a number." );
 		if( rhs.type != obj_number )
 			throw RuntimeException( "Right-hand side of subtraction assignment operator must be a number." );
-		CurrentFrame()->SetLocal( arg, Object( lhs.d - rhs.d ) );
-		ip += sizeof( dword );
+		CurrentFrame()->SetLocal( arg, NumSub( lhs, rhs ) );
 		break;
 	case op_mul_assign_local:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the local
 		lhs = CurrentFrame()->GetLocal( arg );
 		rhs = stack.back();
@@ -1810,12 +2037,11 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of multiplication assignment operator must be a number." );
 		if( rhs.type != obj_number )
 			throw RuntimeException( "Right-hand side of multiplication assignment operator must be a number." );
-		CurrentFrame()->SetLocal( arg, Object( lhs.d * rhs.d ) );
-		ip += sizeof( dword );
+		CurrentFrame()->SetLocal( arg, NumMul( lhs, rhs ) );
 		break;
 	case op_div_assign_local:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the local
 		lhs = CurrentFrame()->GetLocal( arg );
 		if( lhs )
@@ -1827,14 +2053,13 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of division assignment operator must be a number." );
 		if( rhs.type != obj_number )
 			throw RuntimeException( "Right-hand side of division assignment operator must be a number." );
-		if( rhs.d == 0.0 )
+		if( rhs.Num() == 0.0 )
 			throw RuntimeException( "Divide-by-zero error." );
-		CurrentFrame()->SetLocal( arg, Object( lhs.d / rhs.d ) );
-		ip += sizeof( dword );
+		CurrentFrame()->SetLocal( arg, NumDiv( lhs, rhs ) );
 		break;
 	case op_mod_assign_local:
 		// 1 arg
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 		// look-up the local
 		lhs = CurrentFrame()->GetLocal( arg );
 		rhs = stack.back();
@@ -1844,13 +2069,12 @@ Opcode Executor::ExecuteInstruction()
 			throw RuntimeException( "Left-hand side of modulus assignment operator must be a number." );
 		if( rhs.type != obj_number )
 			throw RuntimeException( "Right-hand side of modulus assignment operator must be a number." );
-		if( rhs.d == 0.0 )
+		if( rhs.Num() == 0.0 )
 			throw RuntimeException( "Divide-by-zero error." );
 		// error if arguments aren't integral numbers...
-		if( !is_integral( lhs.d ) || !is_integral( rhs.d ) )
+		if( !IsIntegral( lhs ) || !IsIntegral( rhs ) )
 			throw RuntimeException( "Operands in modulus operator must be integral numbers." );
-		CurrentFrame()->SetLocal( arg, Object( (double)((int)lhs.d % (int)rhs.d) ) );
-		ip += sizeof( dword );
+		CurrentFrame()->SetLocal( arg, NumMod( lhs, rhs ) );
 		break;
 	case op_inc:
 		{
@@ -1861,7 +2085,7 @@ Opcode Executor::ExecuteInstruction()
 		// has to be numeric
 		if( o.type != obj_number )
 			throw RuntimeException( "Operand to increment operator must be numeric." );
-		Object o2( o.d + 1 );
+		Object o2 = NumInc( o );
 		stack.push_back( o2 );
 		}
 		break;
@@ -1874,7 +2098,7 @@ Opcode Executor::ExecuteInstruction()
 		// has to be numeric
 		if( o.type != obj_number )
 			throw RuntimeException( "Operand to decrement operator must be numeric." );
-		Object o2( o.d - 1 );
+		Object o2 = NumDec( o );
 		stack.push_back( o2 );
 		}
 		break;
@@ -1882,8 +2106,7 @@ Opcode Executor::ExecuteInstruction()
 	case op_call_method: // call function with <Op0> args on on stack, fcn after args
 		{
 		// 1 arg: number of args passed
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		// get the fcn
 		o = stack.back();
 		o = ResolveSymbol( o );
@@ -1897,7 +2120,7 @@ Opcode Executor::ExecuteInstruction()
 			if( !callablePtr )
 			{
 				// builtin?
-				NativeFunction nf = GetBuiltin( o.s );
+				NativeFunction nf = GetBuiltin( string( o.s ) );
 				if( nf.p )
 					callable = Object( nf );
 				else
@@ -1953,6 +2176,9 @@ Opcode Executor::ExecuteInstruction()
 			if( i == callable.m->end() )
 				throw ICE( "Unable to find '__name__' member in class object." );
 			inst->insert( pair<Object, Object>( _class, i->second ) );
+			// give it the shape for its class's members, fields added by the
+			// constructors will transition it from there
+			inst->InitShape();
 
 			// create our instance
 			Object instance;
@@ -1960,8 +2186,8 @@ Opcode Executor::ExecuteInstruction()
 
 			// inc ref it before we do anything with it
 			IncRef( instance );
-			// and its children, which we just copied
-			IncRefChildren( instance );
+			// (its children were inc-ref'd when the copy of the class was
+			// modified above)
 
 			// recursively call the constructors on this object and its base classes
 			CallConstructors( callable, instance, arg );
@@ -2006,7 +2232,7 @@ Opcode Executor::ExecuteInstruction()
 	case op_return:
 		{
 		// 1 arg: number of scopes to leave
-		arg = *((dword*)ip);
+		arg = ReadOperand( ip, wide );
 
 		// get the frame
 		Frame* frame = callstack.back();
@@ -2062,15 +2288,13 @@ Opcode Executor::ExecuteInstruction()
 		break;
 	case op_exit_loop:
 		// 2 args: jump target address, number of scopes to leave
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
-		arg2 = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
+		arg2 = ReadOperand( ip, wide );
 		// leave the scopes
 		for( dword i = 0; i < arg2; i++ )
 			PopScope();
 		// jump out of loop
-		ip = (byte*)(bp + arg);
+		ip = instr + (int)arg;
 		break;
 	case op_enter:
 		PushScope( new Scope( callstack.back() ) );
@@ -2078,12 +2302,69 @@ Opcode Executor::ExecuteInstruction()
 	case op_leave:
 		PopScope();
 		break;
+	case op_for_range_init:
+		{
+		// 3 args: number of args to 'range', first of the loop's locals,
+		// address of the loop
+		arg = ReadOperand( ip, wide );
+		arg2 = ReadOperand( ip, wide );
+		arg3 = ReadOperand( ip, wide );
+		// 'range' may have been re-defined (or be shadowed by a caller's
+		// local), if so leave it for the code that follows to call. the
+		// counter local records which it was: an integer only when counting
+		o = ResolveSymbol( stack.back() );
+		if( o.type != obj_native_function || o.nf.p != do_range || arg < 1 || arg > 3 || stack.size() < arg + 1 )
+		{
+			*CurrentFrame()->GetLocalRef( arg2 ) = Object( obj_null );
+			break;
+		}
+		Object* args[3];
+		for( dword i = 0; i < arg; i++ )
+			args[i] = &stack[stack.size() - 1 - arg + i];
+		int start, end, step;
+		GetRangeArgs( args, (int)arg, start, end, step );
+		for( dword i = 0; i <= arg; i++ )
+		{
+			DecRef( stack.back() );
+			stack.pop_back();
+		}
+		Frame* frame = CurrentFrame();
+		*frame->GetLocalRef( arg2 ) = Object( (int64_t)start );
+		*frame->GetLocalRef( arg2 + 1 ) = Object( (int64_t)end );
+		*frame->GetLocalRef( arg2 + 2 ) = Object( (int64_t)step );
+		// (the loop keeps an item on the stack, as other 'for' loops do)
+		stack.push_back( Object( obj_null ) );
+		ip = instr + (int)arg3;
+		}
+		break;
+	case op_for_range:
+		// 2 args: first of the loop's locals, address to jump to if done looping
+		arg = ReadOperand( ip, wide );
+		{
+		// (see op_for_range_init)
+		Frame* frame = CurrentFrame();
+		Object* counter = frame->GetLocalRef( arg );
+		if( counter->IsInt() )
+		{
+			arg2 = ReadOperand( ip, wide );
+			int64_t i = counter->i;
+			if( i < frame->GetLocalRef( arg + 1 )->i )
+			{
+				stack.push_back( Object( i ) );
+				*counter = Object( i + frame->GetLocalRef( arg + 2 )->i );
+			}
+			else
+				ip = instr + (int)arg2;
+			break;
+		}
+		}
+		// not counting, 'range' wasn't the builtin: iterate over what it
+		// returned
 	case op_for_iter:
 	case op_for_iter_pair:
 		{
 		// 1 arg: size/address to jump to if done looping
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		// the iterable object is on the top of the stack, get it but don't
 		// pop it - we'll need it for the loop
 		lhs = stack.back();
@@ -2148,7 +2429,7 @@ Opcode Executor::ExecuteInstruction()
 			throw ICE( "Non-boolean returned as first item from 'next' in op_for_iter." );
 		// if 'false', we're done, jump to end (stored in 'arg')
 		if( !cont.b )
-			ip = (byte*)(bp + arg);
+			ip = instr + (int)arg;
 		// otherwise push the item(s) onto the stack
 		else
 		{
@@ -2175,12 +2456,14 @@ Opcode Executor::ExecuteInstruction()
 		}
 		break;
 	case op_tbl_load:// tos = tos1[tos]
+		{
+		FieldCache & fc = cur_code->field_caches[ReadOperand( ip, wide )];
 		rhs = stack.back();
 		stack.pop_back();
 		lhs = stack.back();
 		lhs = ResolveSymbol( lhs );
 		stack.pop_back();
-		if( !IsRefType( lhs.type ) && lhs.type != obj_module && lhs.type != obj_native_module && lhs.type != obj_string && lhs.type != obj_symbol_name )
+		if( !IsRefType( lhs.type ) && lhs.type != obj_module && lhs.type != obj_native_module && lhs.type != obj_string && lhs.type != obj_symbol_name && lhs.type != obj_buffer && lhs.type != obj_stringbuilder )
 			throw RuntimeException( boost::format( "'%1%' is not a type with members." ) % lhs );
 
 		// string:
@@ -2189,20 +2472,62 @@ Opcode Executor::ExecuteInstruction()
 			// handle string built-in methods
 			//
 			// validate the indexer type
-			if( rhs.type != obj_number || !is_integral( rhs.d ) )
+			if( rhs.type != obj_number || !IsIntegral( rhs ) )
 				throw RuntimeException( "Argument to string indexer must be an integral number." );
 			// validate the bounds
-			if( rhs.d > strlen( lhs.s ) )
-				throw RuntimeException( boost::format( "Out-of-bounds in string index: '%1%' is greater than the length of '%2%'" ) % rhs.d % lhs.s );
+			if( rhs.Num() > strlength( lhs.s ) )
+				throw RuntimeException( boost::format( "Out-of-bounds in string index: '%1%' is greater than the length of '%2%'" ) % rhs.Num() % lhs.s );
 			// create a new (single-character) string of the indexed character,
-			char* c = new char[2];
-			c[0] = lhs.s[(size_t)rhs.d];
-			c[1] = '\0';
+			char* c = allocstr( 1 );
+			c[0] = lhs.s[(size_t)NumToInt( rhs )];
 			// add it to the current scope
 			CurrentFrame()->AddString( c );
 			// return it on the stack
 			stack.push_back( Object( c ) );
 		}
+		// buffer:
+		else if( lhs.type == obj_buffer )
+		{
+			if( rhs.type == obj_string || rhs.type == obj_symbol_name )
+			{
+				// check for buffer built-in method
+				NativeFunction nf = GetBufferBuiltin( string( rhs.s ) );
+				if( nf.p )
+				{
+					if( !nf.is_method )
+						throw ICE( "Buffer builtin not marked as a method." );
+					stack.push_back( Object( nf ) );
+				}
+				else
+					throw RuntimeException( "Invalid buffer index or method." );
+			}
+			else
+			{
+				if( rhs.type != obj_number || !IsIntegral( rhs ) )
+					throw RuntimeException( "Index to a buffer must be an integral number." );
+				int64_t idx = NumToInt( rhs );
+				// out-of-bounds check
+				if( idx < 0 || (size_t)idx >= lhs.buf->size() )
+					throw RuntimeException( "Out-of-bounds error indexing buffer." );
+				stack.push_back( Object( (int64_t)lhs.buf->operator[]( (size_t)idx ) ) );
+			}
+		}
+		// string builder:
+		else if( lhs.type == obj_stringbuilder )
+		{
+			if( rhs.type != obj_string && rhs.type != obj_symbol_name )
+				throw RuntimeException( "Invalid string builder method." );
+			// check for string builder built-in method
+			NativeFunction nf = GetStringBuilderBuiltin( string( rhs.s ) );
+			if( nf.p )
+			{
+				if( !nf.is_method )
+					throw ICE( "String builder builtin not marked as a method." );
+				stack.push_back( Object( nf ) );
+			}
+			else
+				throw RuntimeException( "Invalid string builder method." );
+		}
 		// module:
 		else if( lhs.type == obj_module )
 		{
@@ -2248,63 +2573,57 @@ Opcode Executor::ExecuteInstruction()
 			if( rhs.type != obj_number )
 				throw RuntimeException( "Index to a vector must be a numeric values." );
 			// error if arguments aren't integral numbers...
-			if( !is_integral( rhs.d ) )
+			if( !IsIntegral( rhs ) )
 				throw RuntimeException( "Index to a vector must be an integral value." );
-			dword idx = (dword)rhs.d;
+			dword idx = (dword)NumToInt( rhs );
 			// out-of-bounds check
 			if( lhs.v->size() <= idx || idx < 0 )
 				throw RuntimeException( "Out-of-bounds error indexing vector." );
-			Object obj = lhs.v->operator[]( idx );
+			Object obj = lhs.v->Get( idx );
 			IncRef( obj );
 			stack.push_back( obj );
 		}
 		// map/class/instance:
 		else if( IsMapType( lhs.type ) )
 		{
+			// instance with a shape? check this instruction's cached
+			// shape/slot before searching the map
+			bool cache = lhs.type == obj_instance && lhs.m->GetShape();
+			if( cache )
+			{
+				if( fc.Hit( lhs.m->GetShape(), rhs ) )
+				{
+					Object obj = lhs.m->GetSlot( fc.slot );
+					IncRef( obj );
+					stack.push_back( obj );
+					DecRef( lhs );
+					DecRef( rhs );
+					break;
+				}
+			}
 			// find the rhs (key in the lhs (map)
-			Map::iterator i = lhs.m->find( rhs );
-			if( i == lhs.m->end() )
+			// (reading through a const ref, so a map sharing its pairs with
+			// a copy keeps sharing them)
+			const MapBase & m = *lhs.m;
+			Map::const_iterator i = m.find( rhs );
+			if( i == m.end() )
 			{
-				// if this was a symbol name, try looking for it as a string,
-				// since 'a.b;' is syntactic sugar for 'a["b"];'
-				// conversely, if this was a string, try looking for it as a
-				// symbol name
+				// string and symbol name keys compare equal ('a.b;' is
+				// syntactic sugar for 'a["b"];'), so a name that isn't in the
+				// map can only be a built-in method
 				if( rhs.type == obj_symbol_name || rhs.type == obj_string )
 				{
-					// look for it in the map first...
-					Map::iterator it = lhs.m->find( Object( rhs.s ) );
-					// not found? try it as a symbol name
-					if( it == lhs.m->end() )
-						it = lhs.m->find( Object( obj_symbol_name, rhs.s ) );
-					if( it != lhs.m->end() )
+					// check for map built-in method
+					NativeFunction nf = GetMapBuiltin( string( rhs.s ) );
+					if( nf.p )
 					{
-						Object obj = it->second;
-						if( obj.type == obj_function || obj.type == obj_native_function )
-						{
-							if( obj.type == obj_function && !obj.f->IsMethod() )
-								throw ICE( "class/instance method not marked as a method." );
-							if( obj.type == obj_native_function && !obj.nf.is_method )
-								throw ICE( "class/instance native method not marked as a method." );
-						}
-						// push the object
-						stack.push_back( obj );
+						if( !nf.is_method )
+							throw ICE( "Map builtin not marked as a method." );
+						// push the method
+						stack.push_back( Object( nf ) );
 					}
-					// else try it as a built-in method
 					else
-					{
-						// check for map built-in method
-						NativeFunction nf = GetMapBuiltin( string( rhs.s ) );
-						if( nf.p )
-						{
-							if( !nf.is_method )
-								throw ICE( "Map builtin not marked as a method." );
-							// push the method
-							stack.push_back( Object( nf ) );
-						}
-						else
-							throw RuntimeException( boost::format( "Invalid map key or method: '%1%'." ) % rhs.s );
-
-					}
+						throw RuntimeException( boost::format( "Invalid map key or method: '%1%'." ) % rhs.s );
 					DecRef( lhs );
 					DecRef( rhs );
 					break;
@@ -2312,14 +2631,19 @@ Opcode Executor::ExecuteInstruction()
 				else 
 					throw RuntimeException( "Invalid key value. Item not found." );
 			}
-			IncRef( i->second );
-			stack.push_back( i->second );
+			// cache the slot for the next time through
+			if( cache )
+				fc.Set( lhs.m->GetShape(), lhs.m->GetShape()->FindSlot( rhs ) );
+			Object obj = i->second;
+			IncRef( obj );
+			stack.push_back( obj );
 		}
 		else
 			throw ICE( "Invalid type in tbl_load instruction." );
 
 		DecRef( lhs );
 		DecRef( rhs );
+		}
 		break;
 	case op_method_load:// tos = tos1[tos], but leaves tos1 ('self') on the stack
 		{
@@ -2328,8 +2652,8 @@ Opcode Executor::ExecuteInstruction()
 		lhs = stack.back();
 		lhs = ResolveSymbol( lhs );
 		stack.pop_back();
-		if( !IsRefType( lhs.type ) && lhs.type != obj_module && lhs.type != obj_native_module && lhs.type != obj_string && lhs.type != obj_symbol_name )
-			throw RuntimeException( boost::format( "'%1%' is not a type that has methods (string, vector, map, class, instance or module)." ) % lhs );
+		if( !IsRefType( lhs.type ) && lhs.type != obj_module && lhs.type != obj_native_module && lhs.type != obj_string && lhs.type != obj_symbol_name && lhs.type != obj_buffer && lhs.type != obj_stringbuilder )
+			throw RuntimeException( boost::format( "'%1%' is not a type that has methods (string, vector, map, class, instance, buffer, string builder or module)." ) % lhs );
 
 		// string:
 		if( lhs.type == obj_string )
@@ -2352,6 +2676,44 @@ Opcode Executor::ExecuteInstruction()
 
 			break;
 		}
+		// buffer:
+		else if( lhs.type == obj_buffer )
+		{
+			if( rhs.type != obj_string && rhs.type != obj_symbol_name )
+				throw RuntimeException( boost::format( "Expected method name, found '%1%'." ) % rhs );
+
+			// check for buffer built-in method
+			NativeFunction nf = GetBufferBuiltin( string( rhs.s ) );
+			if( nf.p )
+			{
+				if( !nf.is_method )
+					throw ICE( "Buffer builtin not marked as a method." );
+				stack.push_back( lhs );
+				IncRef( lhs );
+				stack.push_back( Object( nf ) );
+			}
+			else
+				throw RuntimeException( "Invalid buffer method." );
+		}
+		// string builder:
+		else if( lhs.type == obj_stringbuilder )
+		{
+			if( rhs.type != obj_string && rhs.type != obj_symbol_name )
+				throw RuntimeException( boost::format( "Expected method name, found '%1%'." ) % rhs );
+
+			// check for string builder built-in method
+			NativeFunction nf = GetStringBuilderBuiltin( string( rhs.s ) );
+			if( nf.p )
+			{
+				if( !nf.is_method )
+					throw ICE( "String builder builtin not marked as a method." );
+				stack.push_back( lhs );
+				IncRef( lhs );
+				stack.push_back( Object( nf ) );
+			}
+			else
+				throw RuntimeException( "Invalid string builder method." );
+		}
 		// module:
 		else if( lhs.type == obj_module )
 		{
@@ -2401,57 +2763,29 @@ Opcode Executor::ExecuteInstruction()
 		else if( IsMapType( lhs.type ) )
 		{
 			// find the rhs (key in the lhs (map)
-			Map::iterator i = lhs.m->find( rhs );
-			if( i == lhs.m->end() )
+			// (reading through a const ref, so a map sharing its pairs with
+			// a copy keeps sharing them)
+			const MapBase & m = *lhs.m;
+			Map::const_iterator i = m.find( rhs );
+			if( i == m.end() )
 			{
-				// if this was a symbol name, try looking for it as a string,
-				// since 'a.b;' is syntactic sugar for 'a["b"];'
-				// conversely, if it is a string, try looking for it as a symbol
-				// name 
+				// string and symbol name keys compare equal ('a.b;' is
+				// syntactic sugar for 'a["b"];'), so a name that isn't in the
+				// map can only be a built-in method
 				if( rhs.type == obj_symbol_name || rhs.type == obj_string )
 				{
-					// look for it in the map first...
-					Map::iterator it = lhs.m->find( Object( rhs.s ) );
-					// try it as a symbol name
-					if( it == lhs.m->end() )
-						it = lhs.m->find( Object( obj_symbol_name, rhs.s ) );
-					if( it != lhs.m->end() )
+					// check for map built-in method
+					NativeFunction nf = GetMapBuiltin( string( rhs.s ) );
+					if( nf.p )
 					{
-						Object obj = it->second;
-						if( obj.type == obj_function || obj.type == obj_native_function )
-						{
-							if( obj.type == obj_function && !obj.f->IsMethod() )
-								throw ICE( "class/instance method not marked as a method." );
-							if( obj.type == obj_native_function && !obj.nf.is_method )
-								throw ICE( "class/instance native method not marked as a method." );
-							// push the class/instance ('this') for instances/classes
-							if( lhs.type == obj_instance || lhs.type == obj_class )
-							{
-								IncRef( lhs );
-								stack.push_back( lhs );
-							}
-						}
-						IncRef( obj );
-						// push the object
-						stack.push_back( obj );
+						if( !nf.is_method )
+							throw ICE( "Map builtin not marked as a method." );
+						stack.push_back( lhs );
+						IncRef( lhs );
+						stack.push_back( Object( nf ) );
 					}
-					// try it as a built-in method
 					else
-					{
-						// check for map built-in method
-						NativeFunction nf = GetMapBuiltin( string( rhs.s ) );
-						if( nf.p )
-						{
-							if( !nf.is_method )
-								throw ICE( "Map builtin not marked as a method." );
-							stack.push_back( lhs );
-							IncRef( lhs );
-							stack.push_back( Object( nf ) );
-						}
-						else
-							throw RuntimeException( boost::format( "Invalid map key or method: '%1%'." ) % rhs.s );
-
-					}
+						throw RuntimeException( boost::format( "Invalid map key or method: '%1%'." ) % rhs.s );
 					DecRef( lhs );
 					break;
 				}
@@ -2472,8 +2806,9 @@ Opcode Executor::ExecuteInstruction()
 				}
 			}
 			// push the object
-			IncRef( i->second );
-			stack.push_back( i->second );
+			Object obj = i->second;
+			IncRef( obj );
+			stack.push_back( obj );
 		}
 		else
 			throw ICE( "Invalid type in method_load instruction." );
@@ -2505,7 +2840,7 @@ Opcode Executor::ExecuteInstruction()
 		if( o.type == obj_string )
 		{
 			int start, end;
-			int sz = (int)strlen( o.s );
+			int sz = (int)strlength( o.s );
 			if( sz == 0 )
 			{
 				start = 0;
@@ -2513,8 +2848,8 @@ Opcode Executor::ExecuteInstruction()
 			}
 			else
 			{
-				start = idx1.type == obj_null ? sz : (int)idx1.d;
-				end = idx2.type == obj_null ? sz : (int)idx2.d;
+				start = idx1.type == obj_null ? sz : (int)NumToInt( idx1 );
+				end = idx2.type == obj_null ? sz : (int)NumToInt( idx2 );
 			}
 
 			// handle negative values
@@ -2537,9 +2872,9 @@ Opcode Executor::ExecuteInstruction()
 				end = start;
 
 			// slice the string
-			// (strings are immutable. create a copy and add it to the calling frame)
-			string s( o.s );
-			string r = s.substr( start, end - start );
+			// (strings are immutable. create a copy of the sliced characters
+			// and add it to the calling frame)
+			string r( o.s + start, end - start );
 			const char* ret = CurrentFrame()->AddString( r );
 			stack.push_back( Object( ret ) );
 		}
@@ -2554,8 +2889,8 @@ Opcode Executor::ExecuteInstruction()
 			}
 			else
 			{
-				start = idx1.type == obj_null ? sz : (int)idx1.d;
-				end = idx2.type == obj_null ? sz : (int)idx2.d;
+				start = idx1.type == obj_null ? sz : (int)NumToInt( idx1 );
+				end = idx2.type == obj_null ? sz : (int)NumToInt( idx2 );
 			}
 
 			// handle negative values
@@ -2578,17 +2913,55 @@ Opcode Executor::ExecuteInstruction()
 				end = start;
 
 			// slice the vector
-			Object ret;
-			// create a new vector object that is a copy of the 'sub-vector' we're
-			// looking for
-			Vector* v = CreateVector( *(o.v), start, end );
-			ret = Object( v );
+			// (large slices are views sharing the vector's items)
+			Object ret = Object( CreateVector( *(o.v), start, end ) );
+
+			IncRef( ret );
+			stack.push_back( ret );
+		}
+		else if( o.type == obj_buffer )
+		{
+			int start, end;
+			int sz = (int)o.buf->size();
+			if( sz == 0 )
+			{
+				start = 0;
+				end = 0;
+			}
+			else
+			{
+				start = idx1.type == obj_null ? sz : (int)NumToInt( idx1 );
+				end = idx2.type == obj_null ? sz : (int)NumToInt( idx2 );
+			}
+
+			// handle negative values
+			if( start < 0 )
+				start = sz + start;
+			if( end < 0 )
+				end = sz + end;
+
+			// check the indices & step value and convert to sane values, if
+			// necessary
+			if( start > sz )
+				start = sz;
+			if( start < 0 )
+				start = 0;
+			if( end > sz )
+				end = sz;
+			if( end < 0 )
+				end = 0;
+			if( end < start )
+				end = start;
+
+			// slice the buffer
+			// (a view sharing the buffer's bytes)
+			Object ret = Object( CreateBuffer( *(o.buf), start, end ) );
 
 			IncRef( ret );
 			stack.push_back( ret );
 		}
 		else
-			throw RuntimeException( boost::format( "Invalid slice: '%1%' is not a vector or string." ) % o );
+			throw RuntimeException( boost::format( "Invalid slice: '%1%' is not a vector, string or buffer." ) % o );
 
 		DecRef( o );
 		}
@@ -2618,13 +2991,13 @@ Opcode Executor::ExecuteInstruction()
 		if( !is_integral( idx2.type ) )
 			throw RuntimeException( "'step' value in slice must be an integral number." );
 
-		int step = (int)idx3.d;
+		int step = (int)NumToInt( idx3 );
 
 		// string
 		if( o.type == obj_string )
 		{
 			int start, end;
-			int sz = (int)strlen( o.s );
+			int sz = (int)strlength( o.s );
 			if( sz == 0 )
 			{
 				start = 0;
@@ -2632,8 +3005,8 @@ Opcode Executor::ExecuteInstruction()
 			}
 			else
 			{
-				start = idx1.type == obj_null ? sz : (int)idx1.d;
-				end = idx2.type == obj_null ? sz : (int)idx2.d;
+				start = idx1.type == obj_null ? sz : (int)NumToInt( idx1 );
+				end = idx2.type == obj_null ? sz : (int)NumToInt( idx2 );
 			}
 
 			// handle negative values
@@ -2658,26 +3031,22 @@ Opcode Executor::ExecuteInstruction()
 				throw RuntimeException( "Invalid 'step' argument in slice: 'step' is less than one." );
 
 			// slice the string
-			// (strings are immutable. create a copy and add it to the calling frame)
-			string s( o.s );
+			// (strings are immutable. create a copy of the sliced characters
+			// and add it to the calling frame)
 			if( step == 1 )
 			{
-				string r = s.substr( start, end - start );
+				string r( o.s + start, end - start );
 				const char* ret = CurrentFrame()->AddString( r );
 				stack.push_back( Object( ret ) );
 			}
-			// otherwise the string class doesn't help us, have to do it manually
+			// otherwise walk it grabbing every 'nth' character
 			else
 			{
-				// first get the substring from start to end positions
-				string r = s.substr( start, end - start );
-				// call 'reserve' on the string to reduce allocations?
 				string slice;
-				slice.reserve( r.length() / step );
-				// then walk it grabbing every 'nth' character
-				for( size_t i = 0; i < r.length(); i += step )
+				slice.reserve( (end - start + step - 1) / step );
+				for( int i = start; i < end; i += step )
 				{
-					slice += r[i];
+					slice += o.s[i];
 				}
 				const char* ret = CurrentFrame()->AddString( slice );
 				stack.push_back( Object( ret ) );
@@ -2694,8 +3063,8 @@ Opcode Executor::ExecuteInstruction()
 			}
 			else
 			{
-				start = idx1.type == obj_null ? sz : (int)idx1.d;
-				end = idx2.type == obj_null ? sz : (int)idx2.d;
+				start = idx1.type == obj_null ? sz : (int)NumToInt( idx1 );
+				end = idx2.type == obj_null ? sz : (int)NumToInt( idx2 );
 			}
 
 			// handle negative values
@@ -2720,35 +3089,76 @@ Opcode Executor::ExecuteInstruction()
 				throw RuntimeException( "Invalid 'step' argument in slice: 'step' is less than one." );
 
 			// slice the vector
-			Object ret;
-			// if 'step' is '1' (the default)
-			if( step == 1 )
+			// (large slices are views sharing the vector's items)
+			Object ret = Object( CreateVector( *(o.v), start, end, step ) );
+
+			IncRef( ret );
+			stack.push_back( ret );
+		}
+		else if( o.type == obj_buffer )
+		{
+			int start, end;
+			int sz = (int)o.buf->size();
+			if( sz == 0 )
 			{
-				// create a new vector object that is a copy of the 'sub-vector' we're
-				// looking for
-				Vector* v = CreateVector( *(o.v), start, end );
-				ret = Object( v );
+				start = 0;
+				end = 0;
 			}
-			// otherwise the vector class doesn't help us, have to do it manually
 			else
 			{
-				Vector* v = CreateVector();
-				s_i = 0;
-				s_step = step;
-				remove_copy_if( o.v->begin() + start, o.v->begin() + end, back_inserter( *v ), if_step_ex );
-				ret = Object( v );
+				start = idx1.type == obj_null ? sz : (int)NumToInt( idx1 );
+				end = idx2.type == obj_null ? sz : (int)NumToInt( idx2 );
 			}
 
-			IncRef( ret );
-			stack.push_back( ret );
-		}
-		else
-			throw RuntimeException( boost::format( "Invalid slice: '%1%' is not a vector or string." ) % o );
-
-		DecRef( o );
+			// handle negative values
+			if( start < 0 )
+				start = sz + start;
+			if( end < 0 )
+				end = sz + end;
+
+			// check the indices & step value and convert to sane values, if
+			// necessary
+			if( start > sz )
+				start = sz;
+			if( start < 0 )
+				start = 0;
+			if( end > sz )
+				end = sz;
+			if( end < 0 )
+				end = 0;
+			if( end < start )
+				end = start;
+			if( step < 1 )
+				throw RuntimeException( "Invalid 'step' argument in slice: 'step' is less than one." );
+
+			// slice the buffer
+			Object ret;
+			// if 'step' is '1' (the default) the slice is a view sharing the
+			// buffer's bytes
+			if( step == 1 )
+				ret = Object( CreateBuffer( *(o.buf), start, end ) );
+			// otherwise copy every 'nth' byte
+			else
+			{
+				Buffer* b = CreateBuffer( (size_t)((end - start + step - 1) / step) );
+				unsigned char* bytes = b->MutableData();
+				for( int i = start; i < end; i += step )
+					*bytes++ = o.buf->operator[]( i );
+				ret = Object( b );
+			}
+
+			IncRef( ret );
+			stack.push_back( ret );
+		}
+		else
+			throw RuntimeException( boost::format( "Invalid slice: '%1%' is not a vector, string or buffer." ) % o );
+
+		DecRef( o );
 		}
 		break;
 	case op_tbl_store:// tos2[tos1] = tos
+		{
+		dword cache = ReadOperand( ip, wide );
 		o = stack.back();
 		o = ResolveSymbol( o );
 		stack.pop_back();
@@ -2766,16 +3176,16 @@ Opcode Executor::ExecuteInstruction()
 		if( lhs.type == obj_string )
 		{
 			// validate the indexer type
-			if( rhs.type != obj_number || !is_integral( rhs.d ) )
+			if( rhs.type != obj_number || !IsIntegral( rhs ) )
 				throw RuntimeException( "Argument to string indexer must be an integral number." );
 			// validate the bounds
-			if( rhs.d > strlen( lhs.s ) )
-				throw RuntimeException( boost::format( "Out-of-bounds in string index: '%1%' is greater than the length of '%2%'" ) % rhs.d % lhs.s );
+			if( rhs.Num() > strlength( lhs.s ) )
+				throw RuntimeException( boost::format( "Out-of-bounds in string index: '%1%' is greater than the length of '%2%'" ) % rhs.Num() % lhs.s );
 
 			// strings are immutable, so we need to create a new string with the 
 			// modified contents and add it to the current scope's string collection
-			char* s = copystr( lhs.s );
-			size_t idx = (size_t)rhs.d;
+			char* s = dupstr( lhs.s );
+			size_t idx = (size_t)NumToInt( rhs );
 			s[idx] = lhs.s[idx];
 			// add it to the current scope
 			CurrentFrame()->AddString( s );
@@ -2788,25 +3198,56 @@ Opcode Executor::ExecuteInstruction()
 			if( rhs.type != obj_number )
 				throw RuntimeException( "Vectors can only be indexed with numeric values." );
 			// error if arguments aren't integral numbers...
-			if( !is_integral( rhs.d ) )
+			if( !IsIntegral( rhs ) )
 				throw RuntimeException( "Index to a vector must be an integral value." );
-			int idx = (int)rhs.d;
+			int idx = (int)NumToInt( rhs );
 			// out-of-bounds check
 			if( lhs.v->size() <= (dword)idx || idx < 0 )
 				throw RuntimeException( "Out-of-bounds error indexing vector." );
 			// dec ref the current tos2[tos1], as we're assigning into it
-			DecRef( lhs.v->operator[]( idx ) );
+			Object old = lhs.v->Get( idx );
+			DecRef( old );
 			// set the new value
-			lhs.v->operator[]( idx ) = o;
+			lhs.v->Set( idx, o );
 		}
 		// map/class/instance:
 		else
 		{
+			Shape* shape = lhs.m->GetShape();
+			// instance with a shape? check this instruction's cached
+			// shape/slot before searching the map
+			if( shape && lhs.type == obj_instance )
+			{
+				FieldCache & fc = cur_code->field_caches[cache];
+				if( fc.Hit( shape, rhs ) )
+				{
+					Object & slot = lhs.m->MutableSlot( fc.slot );
+					Object old = slot;
+					slot = o;
+					// dec ref the old value, as we've assigned over it
+					DecRef( old );
+					break;
+				}
+				size_t sz = lhs.m->size();
+				Object & val = lhs.m->operator[]( rhs );
+				Object old = val;
+				val = o;
+				// new field? move the instance to the shape that has it
+				if( lhs.m->size() != sz )
+					lhs.m->AddToShape( rhs, &val );
+				shape = lhs.m->GetShape();
+				if( shape )
+					fc.Set( shape, shape->FindSlot( rhs ) );
+				// dec ref the old value, as we've assigned over it
+				DecRef( old );
+				break;
+			}
 			// dec ref the current tos2[tos1], as we're assigning into it
 			DecRef( lhs.m->operator[]( rhs ) );
 			// set the new value
 			lhs.m->operator[]( rhs ) = o;
 		}
+		}
 		break;
 	case op_storeslice2:
 		{
@@ -2833,8 +3274,8 @@ Opcode Executor::ExecuteInstruction()
 		int sz = (int)lhs.v->size();
 		if( sz != 0 )
 		{
-			int start = idx1.type == obj_null ? sz : (int)idx1.d;
-			int end = idx2.type == obj_null ? sz : (int)idx2.d;
+			int start = idx1.type == obj_null ? sz : (int)NumToInt( idx1 );
+			int end = idx2.type == obj_null ? sz : (int)NumToInt( idx2 );
 
 			// handle negative values
 			if( start < 0 )
@@ -2905,9 +3346,9 @@ Opcode Executor::ExecuteInstruction()
 
 		int sz = (int)lhs.v->size();
 
-		int start = idx1.type == obj_null ? sz : (int)idx1.d;
-		int end = idx2.type == obj_null ? sz : (int)idx2.d;
-		int step = (int)idx3.d;
+		int start = idx1.type == obj_null ? sz : (int)NumToInt( idx1 );
+		int end = idx2.type == obj_null ? sz : (int)NumToInt( idx2 );
+		int step = (int)NumToInt( idx3 );
 
 		// handle negative values
 		if( start < 0 )
@@ -2997,14 +3438,14 @@ Opcode Executor::ExecuteInstruction()
 			if( rhs.type != obj_number )
 				throw RuntimeException( "Vectors can only be indexed with numeric values." );
 			// error if arguments aren't integral numbers...
-			if( !is_integral( rhs.d ) )
+			if( !IsIntegral( rhs ) )
 				throw RuntimeException( "Index to a vector must be an integral value." );
-			int idx = (int)rhs.d;
+			int idx = (int)NumToInt( rhs );
 			// out-of-bounds check
 			if( lhs.v->size() <= (dword)idx || idx < 0 )
 				throw RuntimeException( "Out-of-bounds error indexing vector." );
 
-			Object lhsob = lhs.v->operator[]( idx );
+			Object lhsob = lhs.v->Get( idx );
 			if( lhsob.type != obj_number && lhsob.type != obj_string )
 				throw RuntimeException( "left-hand side of '+=' operator must be a number or a string." );
 			if( o.type != obj_number && o.type != obj_string )
@@ -3013,35 +3454,23 @@ Opcode Executor::ExecuteInstruction()
 				throw RuntimeException( "left-hand and right-hand sides of '+=' operator must be the same type." );
 			if( o.type == obj_number )
 			{
-				double d = lhsob.d + o.d;
-				lhs.v->operator[]( idx ) = Object( d );
+				lhs.v->Set( idx, NumAdd( lhsob, o ) );
 			}
 			else
 			{
-				size_t len = strlen( lhsob.s ) + strlen( o.s ) + 1;
-				char* ret = new char[len];
-				memset( ret, 0, len );
-				strcpy( ret, lhsob.s );
-				strcat( ret, o.s );
+				char* ret = catstr( lhsob.s, o.s );
 				CurrentFrame()->AddString( ret );
-				lhs.v->operator[]( idx ) = Object( ret );
+				lhs.v->Set( idx, Object( ret ) );
 			}
 		}
 		// map/class/instance:
 		else
 		{
+			// (string and symbol name keys compare equal, so a single probe
+			// finds either)
 			Map::iterator it = lhs.m->find( rhs );
 			if( it == lhs.m->end() )
-			{
-				if( rhs.type == obj_symbol_name )
-				{
-					// rhs is a symbol, convert it to a string
-					rhs = Object( rhs.s );
-					it = lhs.m->find( Object( rhs.s ) );
-				}
-				if( it == lhs.m->end() )
-					throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
-			}
+				throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
 			Object lhsob = it->second;
 			if( lhsob.type != obj_number && lhsob.type != obj_string )
 				throw RuntimeException( "left-hand side of '+=' operator must be a number or a string." );
@@ -3051,18 +3480,13 @@ Opcode Executor::ExecuteInstruction()
 				throw RuntimeException( "left-hand and right-hand sides of '+=' operator must be the same type." );
 			if( o.type == obj_number )
 			{
-				double d = lhsob.d + o.d;
-				lhs.m->operator[]( rhs ) = Object( d );
+				it->second = NumAdd( lhsob, o );
 			}
 			else
 			{
-				size_t len = strlen( lhsob.s ) + strlen( o.s ) + 1;
-				char* ret = new char[len];
-				memset( ret, 0, len );
-				strcpy( ret, lhsob.s );
-				strcat( ret, o.s );
+				char* ret = catstr( lhsob.s, o.s );
 				CurrentFrame()->AddString( ret );
-				lhs.m->operator[]( rhs ) = Object( ret );
+				it->second = Object( ret );
 			}
 		}
 		break;
@@ -3086,45 +3510,36 @@ Opcode Executor::ExecuteInstruction()
 			if( rhs.type != obj_number )
 				throw RuntimeException( "Vectors can only be indexed with numeric values." );
 			// error if arguments aren't integral numbers...
-			if( !is_integral( rhs.d ) )
+			if( !IsIntegral( rhs ) )
 				throw RuntimeException( "Index to a vector must be an integral value." );
-			int idx = (int)rhs.d;
+			int idx = (int)NumToInt( rhs );
 			// out-of-bounds check
 			if( lhs.v->size() <= (dword)idx || idx < 0 )
 				throw RuntimeException( "Out-of-bounds error indexing vector." );
 
-			Object lhsob = lhs.v->operator[]( idx );
+			Object lhsob = lhs.v->Get( idx );
 			if( lhsob.type != obj_number )
 				throw RuntimeException( "left-hand side of '-=' operator must be a number." );
 			if( o.type != obj_number )
 				throw RuntimeException( "right-hand side of '-=' operator must be a number." );
 
-			double d = lhsob.d - o.d;
-			lhs.v->operator[]( idx ) = Object( d );
+			lhs.v->Set( idx, NumSub( lhsob, o ) );
 		}
 		// map/class/instance:
 		else
 		{
+			// (string and symbol name keys compare equal, so a single probe
+			// finds either)
 			Map::iterator it = lhs.m->find( rhs );
 			if( it == lhs.m->end() )
-			{
-				if( rhs.type == obj_symbol_name )
-				{
-					// rhs is a symbol, convert it to a string
-					rhs = Object( rhs.s );
-					it = lhs.m->find( Object( rhs.s ) );
-				}
-				if( it == lhs.m->end() )
-					throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
-			}
+				throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
 			Object lhsob = it->second;
 			if( lhsob.type != obj_number )
 				throw RuntimeException( "left-hand side of '-=' operator must be a number." );
 			if( o.type != obj_number )
 				throw RuntimeException( "right-hand side of '-=' operator must be a number." );
 
-			double d = lhsob.d - o.d;
-			lhs.m->operator[]( rhs ) = Object( d );
+			it->second = NumSub( lhsob, o );
 		}
 		break;
 	case op_mul_tbl_store:	// tos2[tos1] *= tos
@@ -3147,45 +3562,36 @@ Opcode Executor::ExecuteInstruction()
 			if( rhs.type != obj_number )
 				throw RuntimeException( "Vectors can only be indexed with numeric values." );
 			// error if arguments aren't integral numbers...
-			if( !is_integral( rhs.d ) )
+			if( !IsIntegral( rhs ) )
 				throw RuntimeException( "Index to a vector must be an integral value." );
-			int idx = (int)rhs.d;
+			int idx = (int)NumToInt( rhs );
 			// out-of-bounds check
 			if( lhs.v->size() <= (dword)idx || idx < 0 )
 				throw RuntimeException( "Out-of-bounds error indexing vector." );
 
-			Object lhsob = lhs.v->operator[]( idx );
+			Object lhsob = lhs.v->Get( idx );
 			if( lhsob.type != obj_number )
 				throw RuntimeException( "left-hand side of '*=' operator must be a number." );
 			if( o.type != obj_number )
 				throw RuntimeException( "right-hand side of '*=' operator must be a number." );
 
-			double d = lhsob.d * o.d;
-			lhs.v->operator[]( idx ) = Object( d );
+			lhs.v->Set( idx, NumMul( lhsob, o ) );
 		}
 		// map/class/instance:
 		else
 		{
+			// (string and symbol name keys compare equal, so a single probe
+			// finds either)
 			Map::iterator it = lhs.m->find( rhs );
 			if( it == lhs.m->end() )
-			{
-				if( rhs.type == obj_symbol_name )
-				{
-					// rhs is a symbol, convert it to a string
-					rhs = Object( rhs.s );
-					it = lhs.m->find( Object( rhs.s ) );
-				}
-				if( it == lhs.m->end() )
-					throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
-			}
+				throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
 			Object lhsob = it->second;
 			if( lhsob.type != obj_number )
 				throw RuntimeException( "left-hand side of '*=' operator must be a number." );
 			if( o.type != obj_number )
 				throw RuntimeException( "right-hand side of '*=' operator must be a number." );
 
-			double d = lhsob.d * o.d;
-			lhs.m->operator[]( rhs ) = Object( d );
+			it->second = NumMul( lhsob, o );
 		}
 		break;
 	case op_div_tbl_store:	// tos2[tos1] /= tos
@@ -3208,45 +3614,36 @@ Opcode Executor::ExecuteInstruction()
 			if( rhs.type != obj_number )
 				throw RuntimeException( "Vectors can only be indexed with numeric values." );
 			// error if arguments aren't integral numbers...
-			if( !is_integral( rhs.d ) )
+			if( !IsIntegral( rhs ) )
 				throw RuntimeException( "Index to a vector must be an integral value." );
-			int idx = (int)rhs.d;
+			int idx = (int)NumToInt( rhs );
 			// out-of-bounds check
 			if( lhs.v->size() <= (dword)idx || idx < 0 )
 				throw RuntimeException( "Out-of-bounds error indexing vector." );
 
-			Object lhsob = lhs.v->operator[]( idx );
+			Object lhsob = lhs.v->Get( idx );
 			if( lhsob.type != obj_number )
 				throw RuntimeException( "left-hand side of '/=' operator must be a number." );
 			if( o.type != obj_number )
 				throw RuntimeException( "right-hand side of '/=' operator must be a number." );
 
-			double d = lhsob.d / o.d;
-			lhs.v->operator[]( idx ) = Object( d );
+			lhs.v->Set( idx, NumDiv( lhsob, o ) );
 		}
 		// map/class/instance:
 		else
 		{
+			// (string and symbol name keys compare equal, so a single probe
+			// finds either)
 			Map::iterator it = lhs.m->find( rhs );
 			if( it == lhs.m->end() )
-			{
-				if( rhs.type == obj_symbol_name )
-				{
-					// rhs is a symbol, convert it to a string
-					rhs = Object( rhs.s );
-					it = lhs.m->find( Object( rhs.s ) );
-				}
-				if( it == lhs.m->end() )
-					throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
-			}
+				throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
 			Object lhsob = it->second;
 			if( lhsob.type != obj_number )
 				throw RuntimeException( "left-hand side of '/=' operator must be a number." );
 			if( o.type != obj_number )
 				throw RuntimeException( "right-hand side of '/=' operator must be a number." );
 
-			double d = lhsob.d / o.d;
-			lhs.m->operator[]( rhs ) = Object( d );
+			it->second = NumDiv( lhsob, o );
 		}
 		break;
 	case op_mod_tbl_store:	// tos2[tos1] %= tos
@@ -3269,41 +3666,33 @@ Opcode Executor::ExecuteInstruction()
 			if( rhs.type != obj_number )
 				throw RuntimeException( "Vectors can only be indexed with numeric values." );
 			// error if arguments aren't integral numbers...
-			if( !is_integral( rhs.d ) )
+			if( !IsIntegral( rhs ) )
 				throw RuntimeException( "Index to a vector must be an integral value." );
-			int idx = (int)rhs.d;
+			int idx = (int)NumToInt( rhs );
 			// out-of-bounds check
 			if( lhs.v->size() <= (dword)idx || idx < 0 )
 				throw RuntimeException( "Out-of-bounds error indexing vector." );
 
-			Object lhsob = lhs.v->operator[]( idx );
+			Object lhsob = lhs.v->Get( idx );
 			if( lhsob.type != obj_number )
 				throw RuntimeException( "left-hand side of '%=' operator must be a number." );
 			if( o.type != obj_number )
 				throw RuntimeException( "right-hand side of '%=' operator must be a number." );
 
 			// ensure integral arguments
-			if( !is_integral( o.d ) || !is_integral( lhsob.d ) )
+			if( !IsIntegral( o ) || !IsIntegral( lhsob ) )
 				throw RuntimeException( "arguments to '%=' must be integral values." );
 
-			double d = (int)lhsob.d % (int)o.d;
-			lhs.v->operator[]( idx ) = Object( d );
+			lhs.v->Set( idx, NumMod( lhsob, o ) );
 		}
 		// map/class/instance:
 		else
 		{
+			// (string and symbol name keys compare equal, so a single probe
+			// finds either)
 			Map::iterator it = lhs.m->find( rhs );
 			if( it == lhs.m->end() )
-			{
-				if( rhs.type == obj_symbol_name )
-				{
-					// rhs is a symbol, convert it to a string
-					rhs = Object( rhs.s );
-					it = lhs.m->find( Object( rhs.s ) );
-				}
-				if( it == lhs.m->end() )
-					throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
-			}
+				throw RuntimeException( boost::format( "Invalid index into map: '%1%'." ) % rhs );
 			Object lhsob = it->second;
 			if( lhsob.type != obj_number )
 				throw RuntimeException( "left-hand side of '%=' operator must be a number." );
@@ -3311,17 +3700,15 @@ Opcode Executor::ExecuteInstruction()
 				throw RuntimeException( "right-hand side of '%=' operator must be a number." );
 
 			// ensure integral arguments
-			if( !is_integral( o.d ) || !is_integral( lhsob.d ) )
+			if( !IsIntegral( o ) || !IsIntegral( lhsob ) )
 				throw RuntimeException( "arguments to '%=' must be integral values." );
 
-			double d = (int)lhsob.d % (int)o.d;
-			lhs.m->operator[]( rhs ) = Object( d );
+			it->second = NumMod( lhsob, o );
 		}
 		break;
 	case op_dup:
 		// 1 arg:
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		for( dword i = 0; i < arg; i++ )
 		{
 			stack.push_back( stack.back() );
@@ -3369,8 +3756,7 @@ Opcode Executor::ExecuteInstruction()
 		break;
 	case op_rot:
 		// 1 arg: integer number for how far to rotate
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		// verify the stack is deep enough
 		if( stack.size() < (dword)arg+1 )
 			throw ICE( "Stack error: not enough elements on the stack for 'rot' instruction." );
@@ -3412,8 +3798,7 @@ Opcode Executor::ExecuteInstruction()
 		break;
 	case op_import:
 		// 1 arg:
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant( arg );
 		if( o.type != obj_symbol_name )
@@ -3423,8 +3808,7 @@ Opcode Executor::ExecuteInstruction()
 	case op_def_class:
 		{
 		// 1 arg:
-		arg = *((dword*)ip);
-		ip += sizeof( dword );
+		arg = ReadOperand( ip, wide );
 		// look-up the constant
 		o = GetConstant( arg );
 		if( o.type != obj_symbol_name && o.type != obj_string )
@@ -3440,6 +3824,28 @@ Opcode Executor::ExecuteInstruction()
 			classes.insert( make_pair( name, vector<Function*>() ) );
 		}
 		break;
+	case op_inline_guard:
+		{
+		// 2 args: constant index of the function name, address of the call
+		// to make instead of the inlined code
+		arg = ReadOperand( ip, wide );
+		arg2 = ReadOperand( ip, wide );
+		o = GetConstant( arg );
+		Object fcn = ResolveSymbol( o );
+		// the name must still be bound to the (only) function of that name in
+		// the code being executed
+		if( fcn.type == obj_function && !fcn.f->IsMethod() && strcmp( fcn.f->name.c_str(), o.s ) == 0
+			&& (fcn.f->InModule() ? fcn.f->module->code : code_blocks[0]) == cur_code )
+		{
+			// clear the error state/object, as calling the function would
+			if( is_error )
+				DecRef( error );
+			is_error = false;
+		}
+		else
+			ip = instr + (int)arg2;
+		}
+		break;
 	case op_breakpoint:
 		break;
 	case op_halt:
@@ -3454,157 +3860,21 @@ Opcode Executor::ExecuteInstruction()
 
 Opcode Executor::SkipInstruction()
 {
-	// decode opcode
+	// decode opcode (behind the prefix, for one with dword operands)
 	Opcode op = (Opcode)*ip;
+	if( op == op_wide && ip + 1 < end )
+		op = (Opcode)ip[1];
 
-	ip++;
-	switch( op )
+	// (a breakpoint has no operands)
+	if( op == op_breakpoint )
 	{
-	// 0 args
-	case op_nop:
-	case op_pop:
-	case op_push_true:
-	case op_push_false:
-	case op_push_null:
-	case op_push_zero:
-	case op_push_one:
-	case op_push0:
-	case op_push1:
-	case op_push2:
-	case op_push3:
-	case op_pushlocal0:
-	case op_pushlocal1:
-	case op_pushlocal2:
-	case op_pushlocal3:
-	case op_pushlocal4:
-	case op_pushlocal5:
-	case op_pushlocal6:
-	case op_pushlocal7:
-	case op_pushlocal8:
-	case op_pushlocal9:
-	case op_storelocal0:
-	case op_storelocal1:
-	case op_storelocal2:
-	case op_storelocal3:
-	case op_storelocal4:
-	case op_storelocal5:
-	case op_storelocal6:
-	case op_storelocal7:
-	case op_storelocal8:
-	case op_storelocal9:
-	case op_def_local0:
-	case op_def_local1:
-	case op_def_local2:
-	case op_def_local3:
-	case op_def_local4:
-	case op_def_local5:
-	case op_def_local6:
-	case op_def_local7:
-	case op_def_local8:
-	case op_def_local9:
-	case op_eq:
-	case op_neq:
-	case op_lt:
-	case op_lte:
-	case op_gt:
-	case op_gte:
-	case op_or:
-	case op_and:
-	case op_neg:
-	case op_not:
-	case op_add:
-	case op_sub:
-	case op_mul:
-	case op_div:
-	case op_mod:
-	case op_enter:
-	case op_leave:
-	case op_tbl_load:
-	case op_method_load:
-	case op_loadslice2:
-	case op_loadslice3:
-	case op_tbl_store:
-	case op_storeslice2:
-	case op_storeslice3:
-	case op_add_tbl_store:
-	case op_sub_tbl_store:
-	case op_mul_tbl_store:
-	case op_div_tbl_store:
-	case op_mod_tbl_store:
-	case op_dup1:
-	case op_dup2:
-	case op_dup3:
-	case op_dup_top_n:
-	case op_dup_top1:
-	case op_dup_top2:
-	case op_dup_top3:
-	case op_swap:
-	case op_rot2:
-	case op_rot3:
-	case op_rot4:
-	case op_halt:
-	case op_breakpoint:
-	case op_inc:
-	case op_dec:
-		break;
-
-	// 1 arg
-	case op_push:
-	case op_pushlocal:
-	case op_pushconst:
-	case op_storeconst:
-	case op_store_true:
-	case op_store_false:
-	case op_store_null:
-	case op_storelocal:
-	case op_def_local:
-	case op_new_map:
-	case op_new_vec:
-	case op_new_class:
-	case op_jmp:
-	case op_jmpt:
-	case op_jmpf:
-	case op_add_assign:
-	case op_sub_assign:
-	case op_div_assign:
-	case op_mod_assign:
-	case op_add_assign_local:
-	case op_sub_assign_local:
-	case op_mul_assign_local:
-	case op_div_assign_local:
-	case op_mod_assign_local:
-	case op_call:
-	case op_call_method:
-	case op_return:
-	case op_for_iter:
-	case op_for_iter_pair:
-	case op_dup:
-	case op_rot:
-	case op_import:
-	case op_def_class:
-		ip += sizeof( dword );
-		break;
-
-	// 2 args
-	case op_exit_loop:
-		ip += 2 * sizeof( dword );
-		break;
-
-	// 3 args
-	case op_def_function:
-		ip += 3 * sizeof( dword );
-		break;
-
-	// 4 args
-	case op_def_method:
-		ip += 4 * sizeof( dword );
-		break;
-
-	case op_illegal:
-	default:
-		throw ICE( "Illegal instruction" );
-		break;
+		ip++;
+		return op;
 	}
+	size_t sz = InstructionSize( ip, end - ip );
+	if( sz == 0 )
+		throw ICE( "Illegal instruction" );
+	ip += sz;
 	return op;
 }
 
@@ -3810,6 +4080,39 @@ void Executor::ExecuteFunction( NativeFunction nf, int num_args, bool method_cal
 	recursion_counter--;
 }
 
+Frame* Executor::BeginNativeCalls( NativeFunction nf, int num_args )
+{
+	Frame* frame = new Frame( CurrentFrame(), scopes, ip, ip - sizeof(dword) - 1, num_args, nf );
+	Scope* scope = new Scope( frame, true );
+	PushFrame( frame );
+	PushScope( scope );
+	return frame;
+}
+
+Object Executor::CallNative( Frame* frame )
+{
+	NativeFunction nf = frame->GetNativeFunction();
+	size_t stack_size = stack.size();
+	// clear the error state/object
+	if( is_error && nf.p != do_error && nf.p != do_seterror && nf.p != do_geterror )
+	{
+		is_error = false;
+		DecRef( error );
+	}
+	// execute the function
+	nf.p( frame );
+	// check the stack
+	if( stack.size() != stack_size + 1 )
+		throw ICE( "Native function corrupted the stack." );
+	return PopStack();
+}
+
+void Executor::EndNativeCalls()
+{
+	PopScope();
+	PopFrame();
+}
+
 // breakpoints
 bool Executor::SetBreakpoint( string filename, int line )
 {
@@ -3998,6 +4301,7 @@ const Code* Executor::LoadText( const char* const text, const char* const name,
 		p1f.ignore_undefined_vars = ignore_undefined_vars;
 		PassTwoFlags p2f;
 		p2f.interactive = ignore_undefined_vars;
+		p2f.optimize = optimize;
 
 		// PASS ONE: build the symbol table and check semantics
 		p1rv = PassOne( prv, p1f );
@@ -4037,6 +4341,7 @@ const Code* const Executor::LoadModule( string module_name, string fname )
 	{
 		PassOneFlags p1f; // currently no pass one flags
 		PassTwoFlags p2f;
+		p2f.optimize = optimize;
 
 		// PASS ONE: build the symbol table and check semantics
 		p1rv = PassOne( prv, p1f );
@@ -4108,8 +4413,21 @@ Object Executor::ImportModule( const char* module_name )
 	struct stat in_statbuf;
 	struct stat out_statbuf;
 
+	// with a shared compile cache, the .dvc file lives in the cache and is
+	// named for the source's contents, so if it exists it is current
+	string stamp;
+	string cache_entry = CompileCacheEntry( dvfile, optimize, &stamp );
+	if( !cache_entry.empty() )
+	{
+		dvcfile = cache_entry;
+		use_dvc = exists( dvcfile );
+	}
+	// there's no telling whether an existing .dvc file was optimized, so when
+	// optimizing always recompile
+	else if( optimize )
+		use_dvc = false;
 	// if we can't open the .dvc file, can't load it
-	if( stat( dvcfile.c_str(), &out_statbuf ) != -1 )
+	else if( stat( dvcfile.c_str(), &out_statbuf ) != -1 )
 	{
 		if( stat( dvfile.c_str(), &in_statbuf ) != -1 ) 
 		{
@@ -4124,24 +4442,37 @@ Object Executor::ImportModule( const char* module_name )
 
 	const Code* code = NULL;
 
-	// if we're not using the dvc file, 
-	// load and compile the code and write the dvc file
-	if( !use_dvc )
+	// read the existing .dvc file
+	if( use_dvc )
+	{
+		try
+		{
+			code = ReadCode( dvcfile, stamp );
+		}
+		catch( RuntimeException & )
+		{
+			// another process may have evicted the cache entry (or the entry
+			// is for another source), just recompile
+			if( cache_entry.empty() )
+				throw;
+		}
+		if( code && !cache_entry.empty() )
+			CompileCacheTouch( dvcfile );
+	}
+	// otherwise load and compile the code and write the dvc file
+	if( !code )
 	{
 		code = LoadModule( mod, dvfile );
 		if( !code )
 			throw RuntimeException( boost::format( "Unable to load module '%1%'." ) % mod );
-		WriteCode( dvcfile, code );
-	}
-	else
-	{
-		// otherwise we can just read the existing .dvc file
-		code = ReadCode( dvcfile );
+		WriteCode( dvcfile, code, stamp );
+		if( !cache_entry.empty() )
+			CompileCacheTrim();
 	}
 	// add the constant for this module name
 	char* str = copystr( mod );
 	if( !cur_code->AddConstant( Object( obj_symbol_name, str ) ) )
-		delete[] str;
+		freestr( str );
 
 	// create a new module and add it to the module collection
 	// find our 'module' function, "module@main"
@@ -4193,65 +4524,210 @@ Code* Executor::GetCode( byte* address )
 	return NULL;
 }
 
+// .dvc file helpers: little-endian records, 8-byte aligned sections
+static void PutDword( vector<byte> & buf, dword dw )
+{
+	for( int i = 0; i < 4; i++ )
+		buf.push_back( (byte)(dw >> (i * 8)) );
+}
+
+static void PutQword( vector<byte> & buf, qword qw )
+{
+	PutDword( buf, (dword)qw );
+	PutDword( buf, (dword)(qw >> 32) );
+}
+
+static void SetDword( byte* p, dword dw )
+{
+	for( int i = 0; i < 4; i++ )
+		p[i] = (byte)(dw >> (i * 8));
+}
+
+static void SetQword( byte* p, qword qw )
+{
+	SetDword( p, (dword)qw );
+	SetDword( p + sizeof( dword ), (dword)(qw >> 32) );
+}
+
+static inline dword GetDword( const byte* p )
+{
+	return (dword)p[0] | ((dword)p[1] << 8) | ((dword)p[2] << 16) | ((dword)p[3] << 24);
+}
+
+static inline qword GetQword( const byte* p )
+{
+	return (qword)GetDword( p ) | ((qword)GetDword( p + 4 ) << 32);
+}
+
+// unsigned LEB128: seven bits per byte, low bits first, the high bit set on
+// all but the last byte
+static void PutVarint( vector<byte> & buf, dword dw )
+{
+	while( dw >= 0x80 )
+	{
+		buf.push_back( (byte)(dw | 0x80) );
+		dw >>= 7;
+	}
+	buf.push_back( (byte)dw );
+}
+
+// returns false if the varint runs past 'end' or doesn't fit in a dword
+static bool GetVarint( const byte* & p, const byte* end, dword & dw )
+{
+	dw = 0;
+	for( int shift = 0; shift < 35; shift += 7 )
+	{
+		if( p == end )
+			return false;
+		byte b = *p++;
+		if( shift == 28 && b > 0x0f )
+			return false;
+		dw |= (dword)(b & 0x7f) << shift;
+		if( !(b & 0x80) )
+			return true;
+	}
+	return false;
+}
+
+// signed values are zig-zag encoded, so small negative numbers stay small
+static inline dword ZigZag( int i ) { return ((dword)i << 1) ^ (dword)(i >> 31); }
+static inline int UnZigZag( dword dw ) { return (int)(dw >> 1) ^ -(int)(dw & 1); }
+
+static inline bool HostIsLittleEndian()
+{
+	const dword one = 1;
+	return *(const byte*)&one == 1;
+}
+
+// the string blob of a .dvc file being written, each distinct string is
+// stored once
+class StringBlob
+{
+	vector<byte> data;
+	map<string, dword> offsets;
+
+public:
+	// returns the offset of the string's first character
+	dword Add( const string & s )
+	{
+		map<string, dword>::iterator i = offsets.find( s );
+		if( i != offsets.end() )
+			return i->second;
+		// (the length, then the string, null-terminated and padded with the
+		// zeros the entry is sized and filled with)
+		size_t start = data.size();
+		data.resize( start + sizeof( qword ) + ((s.size() + 1 + 7) & ~(size_t)7), 0 );
+		SetQword( &data[start], (qword)s.size() );
+		dword offset = (dword)(start + sizeof( qword ));
+		if( !s.empty() )
+			memcpy( &data[offset], s.data(), s.size() );
+		offsets.insert( make_pair( s, offset ) );
+		return offset;
+	}
+	const vector<byte> & Data() const { return data; }
+};
+
+// find a section in a mapped .dvc file, validating its bounds
+static byte* FindSection( byte* base, size_t size, const char* tag, size_t & len )
+{
+	dword num_sections = GetDword( base + sizeofFileHdr );
+	byte* entry = base + sizeofFileHdr + 2 * sizeof( dword );
+	for( dword i = 0; i < num_sections; i++, entry += sizeofSectionEntry )
+	{
+		if( memcmp( entry, tag, sizeofSectionTag ) != 0 )
+			continue;
+		dword offset = GetDword( entry + sizeofSectionTag );
+		len = GetDword( entry + sizeofSectionTag + sizeof( dword ) );
+		if( offset % 8 != 0 || offset > size || len > size - offset )
+			throw RuntimeException( boost::format( "Invalid .dvc file: section '%1%' is malformed." ) % tag );
+		return base + offset;
+	}
+	throw RuntimeException( boost::format( "Invalid .dvc file: section '%1%' is missing." ) % tag );
+}
+
+// get a string (and its length) out of the string blob of a mapped .dvc file
+static char* BlobString( byte* blob, size_t blob_len, qword offset, size_t & len )
+{
+	if( offset < sizeof( qword ) || offset > blob_len )
+		throw RuntimeException( "Invalid .dvc file: string offset out of range." );
+	qword qw = GetQword( blob + offset - sizeof( qword ) );
+	if( qw >= blob_len - offset || blob[offset + qw] != 0 )
+		throw RuntimeException( "Invalid .dvc file: string blob is malformed." );
+	len = (size_t)qw;
+	return (char*)blob + offset;
+}
+
+static string BlobStdString( byte* blob, size_t blob_len, qword offset )
+{
+	size_t len = 0;
+	char* s = BlobString( blob, blob_len, offset, len );
+	return string( s, len );
+}
+
+// size the field caches of code read from a .dvc file to hold the largest
+// tbl_load/tbl_store operand
+static void SizeFieldCaches( Code* code )
+{
+	dword num = 0;
+	for( size_t a = 0; a < code->len; )
+	{
+		size_t sz = InstructionSize( code->code + a, code->len - a );
+		if( sz == 0 )
+			throw RuntimeException( "Invalid .dvc file: code section is malformed." );
+		bool wide = (Opcode)code->code[a] == op_wide;
+		Opcode op = (Opcode)code->code[wide ? a + 1 : a];
+		if( op == op_tbl_load || op == op_tbl_store )
+		{
+			byte* p = code->code + a + (wide ? 2 : 1);
+			dword idx = ReadOperand( p, wide );
+			if( idx >= num )
+				num = idx + 1;
+		}
+		a += sz;
+	}
+	code->field_caches.resize( num );
+}
+
 // .dv file writing
-void Executor::WriteCode( string filename, const Code* const code )
+void Executor::WriteCode( string filename, const Code* const code, const string & stamp /*= string()*/ )
 {
-	// open the file for writing
-	ofstream file;
-	file.open( filename.c_str(), ios::binary );
-	if( file.fail() )
-		throw RuntimeException( boost::format( "Unable to open file '%1%'" ) % filename );
+	StringBlob strings;
 
-	// write the header
-	// "deva"
-	file << file_hdr_deva;
-	file << '\0';
-	// "2.0.0"
-	file << file_hdr_ver;
-	file << '\0';
-	// 5 bytes of padding to bring header to 16 bytes
-	file << '\0';
-	file << '\0';
-	file << '\0';
-	file << '\0';
-	file << '\0';
-
-	// write constants
+	// constants
 	// (do NOT write the 'global' constants, they always exist)
-	file << constants_hdr;
-	file << '\0';
-	// padding to byte boundary
-	file << '\0';
-	// section header is followed by dword containing the number of const objects
-	dword num_consts = code->NumConstants();
-	file.write( (char*)&num_consts, sizeof( dword ) );
-	// constant data itself is an array of DevaObject structs:
-	// byte : object type. only number and string are allowed
-	// qword (number) OR 'len+1' bytes (string) : number or null-terminated string
+	vector<byte> consts;
+	PutDword( consts, (dword)code->NumConstants() );
+	PutDword( consts, 0 );
 	for( int i = 0; i < code->NumConstants(); i++ )
 	{
 		Object o = code->GetConstant( i );
-		qword qw = 0;
-		file << (byte)(o.type);
+		PutDword( consts, (dword)o.type );
 		switch( o.type )
 		{
 		case obj_number:
+			if( o.IsInt() )
+			{
+				PutDword( consts, const_flag_int );
+				PutQword( consts, (qword)(int64_t)o.i );
+			}
+			else
 			{
-			int64_t qw = (int64_t)o.d;
-			file.write( (char*)&qw, sizeof( qword ) );
+				// write the bits of the double, so no precision is lost
+				double d = o.d;
+				qword qw = 0;
+				memcpy( &qw, &d, sizeof( qword ) );
+				PutDword( consts, 0 );
+				PutQword( consts, qw );
 			}
 			break;
 		case obj_string:
-			file << o.s;
-			file << '\0';
+		case obj_symbol_name:
+			PutDword( consts, 0 );
+			PutQword( consts, strings.Add( string( o.s, strlength( o.s ) ) ) );
 			break;
 		case obj_size:
-			qw = (qword)o.sz;
-			file.write( (char*)&qw, sizeof( qword ) );
-			break;
-		case obj_symbol_name:
-			file << o.s;
-			file << '\0';
+			PutDword( consts, 0 );
+			PutQword( consts, (qword)o.sz );
 			break;
 		default:
 			// null shouldn't ever happen, null is 'global'
@@ -4261,27 +4737,11 @@ void Executor::WriteCode( string filename, const Code* const code )
 		}
 	}
 
-	// write functions
-	file << functions_hdr;
-	file << '\0';
-	// padding to byte boundary
-	file << '\0';
-	file << '\0';
-	// section header is followed by a dword containing the number of function objects
-	dword dw = (dword)functions.size();
-	file.write( (char*)&dw, sizeof( dword ) );
-	// function object data itself is an array of Function objects:
-	// len+1 bytes : 	name, null-terminated string
-	// len+1 bytes : 	filename
-	// dword :			starting line
-	// len+1 bytes :	classname (zero-length string if non-method)
-	// dword : 			number of arguments
-	// dword : 			'n' number of default arguments
-	// 'n' dwords :		default args (constant pool indices)
-	// dword :			number of locals
-	// dword :			number of names (externals, undeclared vars, functions)
-	// byte[] :			names, len+1 bytes null-terminated string each
-	// dword :			offset in code section of the code for this function
+	// functions
+	vector<byte> funcs;
+	vector<dword> extra;
+	PutDword( funcs, (dword)functions.size() );
+	PutDword( funcs, 0 );
 	for( multimap<string, Object*>::iterator i = functions.begin(); i != functions.end(); ++i )
 	{
 		//////////////////////////////////////////////////////
@@ -4289,282 +4749,266 @@ void Executor::WriteCode( string filename, const Code* const code )
 		//////////////////////////////////////////////////////
 
 		Function* f = i->second->f;
-		// name
-		file << f->name;
-		file << '\0';
+		PutDword( funcs, strings.Add( f->name ) );
+		PutDword( funcs, strings.Add( f->filename ) );
+		PutDword( funcs, f->first_line );
+		PutDword( funcs, strings.Add( f->classname ) );
+		PutDword( funcs, f->num_args );
 
-		// filename (module)
-		file << f->filename;
-		file << '\0';
-
-		// starting line
-		dw = f->first_line;
-		file.write( (char*)&dw, sizeof( dword ) );
-
-		// classname, empty if not method
-		file << f->classname;
-		file << '\0';
-
-		// number of arguments
-		dw = f->num_args;
-		file.write( (char*)&dw, sizeof( dword ) );
-	
 		// default args
-		dw = (dword)(f->default_args.size());
-		file.write( (char*)&dw, sizeof( dword ) );
+		PutDword( funcs, (dword)f->default_args.size() );
+		PutDword( funcs, (dword)extra.size() );
 		for( size_t j = 0; j < f->default_args.size(); j++ )
-		{
-			dw = (dword)(f->default_args[j]);
-			file.write( (char*)&dw, sizeof( dword ) );
-		}
+			extra.push_back( (dword)f->default_args[j] );
 
 		// local names (for debugging & reflection)
-		dw = (dword)(f->local_names.size());
-		file.write( (char*)&dw, sizeof( dword ) );
+		PutDword( funcs, (dword)f->local_names.size() );
+		PutDword( funcs, (dword)extra.size() );
 		for( size_t j = 0; j < f->local_names.size(); j++ )
-		{
-			file << f->local_names[j];
-			file << '\0';
-		}
-	
+			extra.push_back( strings.Add( f->local_names[j] ) );
+
 		// offset in code section of the code for this function
-		dw = f->addr;
-		file.write( (char*)&dw, sizeof( dword ) );
+		PutDword( funcs, f->addr );
+	}
+	for( size_t i = 0; i < extra.size(); i++ )
+		PutDword( funcs, extra[i] );
+
+	// line mapping, sorted by address and delta-encoded
+	vector<byte> lines;
+	PutDword( lines, (dword)code->lines->A2LSize() );
+	PutDword( lines, 0 );
+	dword prev_addr = 0, prev_line = 0;
+	for( LineMap::iterator i = code->lines->A2LBegin(); i != code->lines->A2LEnd(); ++i )
+	{
+		PutVarint( lines, i->first - prev_addr );
+		PutVarint( lines, ZigZag( (int)(i->second - prev_line) ) );
+		prev_addr = i->first;
+		prev_line = i->second;
 	}
 
-	// write line mapping
-	file << linemap_hdr;
-	file << '\0';
-	// padding to byte boundary
-	file << '\0';
-	file << '\0';
-	file << '\0';
-	file << '\0';
-	file << '\0';
-	file << '\0';
-	file << '\0';
-	// section header is followed by a dword containing the number of line map entries
-	dword num_linemaps = (dword)(code->lines->L2ASize());
-	file.write( (char*)&num_linemaps, sizeof( dword ) );
-	// line map data is an array of line map entries:
-	// dword : 			line number
-	// dword :			address of instruction
-	for( map<dword, dword>::iterator i = code->lines->L2ABegin(); i != code->lines->L2AEnd(); ++i )
+	// header and section table
+	// (the source stamp only for compile cache entries)
+	const dword max_sections = 6;
+	const dword num_sections = stamp.empty() ? max_sections - 1 : max_sections;
+	const char* tags[max_sections] = { strings_hdr, constants_hdr, functions_hdr, linemap_hdr, code_hdr, source_hdr };
+	const byte* data[max_sections] = { strings.Data().empty() ? NULL : &strings.Data()[0], &consts[0], &funcs[0], &lines[0], code->code, (const byte*)stamp.data() };
+	size_t sizes[max_sections] = { strings.Data().size(), consts.size(), funcs.size(), lines.size(), code->len, stamp.size() };
+
+	// (filled in place, the header and section table have a fixed size)
+	vector<byte> hdr( sizeofFileHdr + 2 * sizeof( dword ) + num_sections * sizeofSectionEntry, 0 );
+	byte* h = &hdr[0];
+	memcpy( h, file_hdr_deva, sizeof( file_hdr_deva ) );
+	memcpy( h + sizeof( file_hdr_deva ), file_hdr_ver, sizeof( file_hdr_ver ) );
+	SetDword( h + sizeofFileHdr, num_sections );
+	byte* entry = h + sizeofFileHdr + 2 * sizeof( dword );
+	size_t offset = hdr.size();
+	for( dword i = 0; i < num_sections; i++, entry += sizeofSectionEntry )
 	{
-		dw = i->first;
-		file.write( (char*)&dw, sizeof( dword ) );
-		dw = i->second;
-		file.write( (char*)&dw, sizeof( dword ) );
+		memcpy( entry, tags[i], sizeofSectionTag );
+		SetDword( entry + sizeofSectionTag, (dword)offset );
+		SetDword( entry + sizeofSectionTag + sizeof( dword ), (dword)sizes[i] );
+		offset = (offset + sizes[i] + 7) & ~(size_t)7;
+	}
+
+	// write to a temporary file and rename it into place, so that other
+	// processes never see a partly written file
+	string tmpname = temp_file_name( filename );
+	ofstream file;
+	file.open( tmpname.c_str(), ios::binary );
+	if( file.fail() )
+		throw RuntimeException( boost::format( "Unable to open file '%1%'" ) % filename );
+
+	static const char zeros[8] = { 0 };
+	file.write( (const char*)&hdr[0], hdr.size() );
+	for( dword i = 0; i < num_sections; i++ )
+	{
+		if( sizes[i] != 0 )
+			file.write( (const char*)data[i], sizes[i] );
+		if( sizes[i] % 8 != 0 )
+			file.write( zeros, 8 - sizes[i] % 8 );
 	}
 
-	// write bytecode
-	file.write( (const char*)code->code, code->len );
-	
 	// close the file
 	file.close();
+	if( file.fail() || !rename_file( tmpname, filename ) )
+	{
+		remove_file( tmpname );
+		throw RuntimeException( boost::format( "Unable to write file '%1%'" ) % filename );
+	}
 }
 
 // .dv file reading
-Code* Executor::ReadCode( string filename )
+// the file is mapped rather than read: the byte-code is used in place and,
+// where the host's size_t matches the on-disk string length header (64-bit,
+// little-endian), so are the string constants
+Code* Executor::ReadCode( string filename, const string & stamp /*= string()*/ )
 {
+	MappedFile* mapping = new MappedFile( filename );
 	Code* code = new Code();
 	code->lines = new LineMap();
+	code->mapping = mapping;
 
-	// open the file for reading
-	ifstream file;
-	file.open( filename.c_str(), ios::binary );
-	if( file.fail() )
-		throw RuntimeException( boost::format( "Unable to open input file '%1%' for read." ) % filename );
-
-	// read the header
-	char deva[5] = {0};
-	char ver[6] = {0};
-	file.read( deva, 5 );
-	if( strcmp( deva, "deva") != 0 )
-		throw RuntimeException( "Invalid .dvc file: header missing 'deva' tag." );
-	file.read( ver, 6 );
-	if( strcmp( ver, "2.0.0" ) != 0 )
-		 throw RuntimeException( boost::format( "Invalid .dvc version number: %1%." ) % ver );
-	char pad[6] = {0};
-	file.read( pad, 5 );
-	if( pad[0] != 0 || pad[1] != 0 || pad[2] != 0 || pad[3] != 0 || pad[4] != 0 )
-		throw RuntimeException( "Invalid .dvc file: malformed header after version number." );
-
-	// read the constants
-	char consts_hdr[7];
-	char consts_hdr_pad[1];
-	file.read( consts_hdr, 7 );
-	if( strcmp( consts_hdr, ".const" ) != 0 )
-		throw RuntimeException( "Invalid .dvc file: constant section header missing or malformed." );
-	file.read( consts_hdr_pad, 1 );
-	if( consts_hdr_pad[0] != 0 )
-		throw RuntimeException( "Invalid .dvc file: constant section header missing or malformed." );
-	// section header is followed by dword containing the number of const objects
-	dword num_consts = 0;
-	file.read( (char*)&num_consts, sizeof( dword ) );
-	// constant data itself is an array of DevaObject structs:
-	// byte : object type. only number and string are allowed
-	// qword (number) OR 'len+1' bytes (string) : number or null-terminated string
-	for( dword i = 0; i < num_consts; i++ )
+	try
 	{
-		Object o;
-		byte type;
-		file.read( (char*)&type, sizeof( byte ) );
-		o.type = (ObjectType)type;
-		switch( type )
+		byte* base = mapping->Data();
+		size_t size = mapping->Size();
+
+		// check the header
+		if( size < sizeofFileHdr + 2 * sizeof( dword ) || memcmp( base, file_hdr_deva, sizeof( file_hdr_deva ) ) != 0 )
+			throw RuntimeException( "Invalid .dvc file: header missing 'deva' tag." );
+		const char* ver = (const char*)base + sizeof( file_hdr_deva );
+		if( memcmp( ver, file_hdr_ver, sizeof( file_hdr_ver ) ) != 0 )
+			throw RuntimeException( boost::format( "Invalid .dvc version number: %1%." ) % string( ver, sizeof( file_hdr_ver ) - 1 ) );
+		const byte* pad = (const byte*)ver + sizeof( file_hdr_ver );
+		if( pad[0] != 0 || pad[1] != 0 || pad[2] != 0 || pad[3] != 0 || pad[4] != 0 )
+			throw RuntimeException( "Invalid .dvc file: malformed header after version number." );
+		dword num_sections = GetDword( base + sizeofFileHdr );
+		if( num_sections > (size - sizeofFileHdr - 2 * sizeof( dword )) / sizeofSectionEntry )
+			throw RuntimeException( "Invalid .dvc file: section table missing or malformed." );
+
+		// a compile cache entry must be the one for the source being loaded
+		// (and not one whose name is the same hash)
+		if( !stamp.empty() )
 		{
-		case obj_number:
-			{
-			int64_t qw = 0;
-			file.read( (char*)&qw, sizeof( qword ) );
-			o.d = (double)qw;
-			}
-			break;
-		case obj_string:
-			{
-			string s;
-			getline( file, s, '\0' );
-			o.s = copystr( s );
-			}
-			break;
-		case obj_size:
-			file.read( (char*)&o.sz, sizeof( dword ) );
-			break;
-		case obj_symbol_name:
+			size_t len = 0;
+			byte* p = FindSection( base, size, source_hdr, len );
+			if( len != stamp.size() || memcmp( p, stamp.data(), len ) != 0 )
+				throw RuntimeException( boost::format( "Compiled file '%1%' is not for this source." ) % filename );
+		}
+
+		size_t blob_len = 0;
+		byte* blob = FindSection( base, size, strings_hdr, blob_len );
+
+		// read the constants
+		size_t len = 0;
+		byte* p = FindSection( base, size, constants_hdr, len );
+		if( len < 2 * sizeof( dword ) )
+			throw RuntimeException( "Invalid .dvc file: constant section header missing or malformed." );
+		dword num_consts = GetDword( p );
+		if( num_consts > (len - 2 * sizeof( dword )) / sizeofConstantRecord )
+			throw RuntimeException( "Invalid .dvc file: constant section header missing or malformed." );
+		bool strings_in_place = sizeof( size_t ) == sizeof( qword ) && HostIsLittleEndian();
+		p += 2 * sizeof( dword );
+		for( dword i = 0; i < num_consts; i++, p += sizeofConstantRecord )
+		{
+			Object o;
+			dword type = GetDword( p );
+			dword flags = GetDword( p + sizeof( dword ) );
+			qword payload = GetQword( p + 2 * sizeof( dword ) );
+			bool copied = false;
+			switch( type )
 			{
-			string s;
-			getline( file, s, '\0' );
-			o.s = copystr( s );
+			case obj_number:
+				if( flags & const_flag_int )
+					o = Object( (int64_t)payload );
+				else
+				{
+					double d = 0.0;
+					memcpy( &d, &payload, sizeof( double ) );
+					o = Object( d );
+				}
+				break;
+			case obj_string:
+			case obj_symbol_name:
+				{
+				size_t n = 0;
+				char* s = BlobString( blob, blob_len, payload, n );
+				if( !strings_in_place )
+				{
+					s = copystr( string( s, n ) );
+					copied = true;
+				}
+				if( type == obj_string )
+					o = Object( s );
+				else
+					o = Object( obj_symbol_name, s );
+				}
+				break;
+			case obj_size:
+				o = Object( (size_t)payload );
+				break;
+			default:
+				throw ICE( "Invalid .dvc file: read Object of invalid type for Constant Pool." );
+				break;
 			}
-			break;
-		default:
-			throw ICE( "Invalid .dvc file: read Object of invalid type for Constant Pool." );
-			break;
+			if( !code->AddConstant( o ) && copied )
+				freestr( o.s );
 		}
-		code->AddConstant( o );
-	}
 
-	// read the function table
-	char funcs_hdr[6];
-	file.read( funcs_hdr, 6 );
-	if( strcmp( funcs_hdr, ".func" ) != 0 )
-		throw RuntimeException( "Invalid .dvc file: function section header missing or malformed." );
-	char funcs_hdr_pad[2];
-	file.read( funcs_hdr_pad, 2 );
-	if( funcs_hdr_pad[0] != 0 || funcs_hdr_pad[1] != 0 )
-		throw RuntimeException( "Invalid .dvc file: function section header missing or malformed." );
-	// section header is followed by a dword containing the number of function objects
-	dword num_funcs = 0;
-	file.read( (char*)&num_funcs, sizeof( dword ) );
-	// function object data itself is an array of Function objects:
-	// len+1 bytes : 	name, null-terminated string
-	// len+1 bytes : 	filename
-	// dword :			starting line
-	// len+1 bytes :	classname (zero-length string if non-method)
-	// dword : 			number of arguments
-	// dword : 			'n' number of default arguments
-	// 'n' dwords :		default args (constant pool indices)
-	// dword :			number of locals
-	// dword :			number of names (externals, undeclared vars, functions)
-	// byte[] :			names, len+1 bytes null-terminated string each
-	// dword :			offset in code section of the code for this function
-	for( dword i = 0; i < num_funcs; i++ )
-	{
-		Function* f = new Function();
-		string s;
-		getline( file, s, '\0' );
-		// name
-		f->name = s;
-	
-		// filename
-		getline( file, s, '\0' );
-		f->filename = s;
-	
-		// first line
-		file.read( (char*)&f->first_line, sizeof( dword ) );
-	
-		// classname
-		getline( file, s, '\0' );
-		f->classname = s;
-	
-		// num args
-		file.read( (char*)&f->num_args, sizeof( dword ) );
-	
-		// default args
-		dword num_def_args = 0;
-		file.read( (char*)&num_def_args, sizeof( dword ) );
-		for( size_t j = 0; j < num_def_args; j++ )
+		// read the function table
+		p = FindSection( base, size, functions_hdr, len );
+		if( len < 2 * sizeof( dword ) )
+			throw RuntimeException( "Invalid .dvc file: function section header missing or malformed." );
+		dword num_funcs = GetDword( p );
+		if( num_funcs > (len - 2 * sizeof( dword )) / sizeofFunctionRecord )
+			throw RuntimeException( "Invalid .dvc file: function section header missing or malformed." );
+		byte* extra = p + 2 * sizeof( dword ) + num_funcs * sizeofFunctionRecord;
+		size_t num_extra = (len - 2 * sizeof( dword ) - num_funcs * sizeofFunctionRecord) / sizeof( dword );
+		p += 2 * sizeof( dword );
+		for( dword i = 0; i < num_funcs; i++, p += sizeofFunctionRecord )
 		{
-			dword idx = 0;
-			file.read( (char*)&idx, sizeof( dword ) );
-			f->default_args.push_back( idx );
+			dword num_def_args = GetDword( p + 5 * sizeof( dword ) );
+			dword def_args_idx = GetDword( p + 6 * sizeof( dword ) );
+			dword num_locals = GetDword( p + 7 * sizeof( dword ) );
+			dword locals_idx = GetDword( p + 8 * sizeof( dword ) );
+			if( def_args_idx > num_extra || num_def_args > num_extra - def_args_idx 
+				|| locals_idx > num_extra || num_locals > num_extra - locals_idx )
+				throw RuntimeException( "Invalid .dvc file: function record is malformed." );
+
+			Function* f = new Function();
+			f->name = BlobStdString( blob, blob_len, GetDword( p ) );
+			f->filename = BlobStdString( blob, blob_len, GetDword( p + sizeof( dword ) ) );
+			f->first_line = GetDword( p + 2 * sizeof( dword ) );
+			f->classname = BlobStdString( blob, blob_len, GetDword( p + 3 * sizeof( dword ) ) );
+			f->num_args = GetDword( p + 4 * sizeof( dword ) );
+			for( dword j = 0; j < num_def_args; j++ )
+				f->default_args.push_back( (int)GetDword( extra + (def_args_idx + j) * sizeof( dword ) ) );
+			for( dword j = 0; j < num_locals; j++ )
+				f->local_names.push_back( BlobStdString( blob, blob_len, GetDword( extra + (locals_idx + j) * sizeof( dword ) ) ) );
+			f->addr = GetDword( p + 9 * sizeof( dword ) );
+
+			// module ptr will be set later
+			f->module = NULL;
+			// module name
+			string filepart = get_file_part( f->filename );
+			f->modulename = get_stem( filepart );
+
+			AddFunction( f );
 		}
 
-		// local names (for debugging & reflection)
-		dword num_locals = 0;
-		file.read( (char*)&num_locals, sizeof( dword ) );
-		for( size_t i = 0; i < num_locals; i++ )
+		// read the line mapping
+		p = FindSection( base, size, linemap_hdr, len );
+		if( len < 2 * sizeof( dword ) )
+			throw RuntimeException( "Invalid .dvc file: line map section header missing or malformed." );
+		dword num_linemaps = GetDword( p );
+		// (each entry is at least two bytes)
+		if( num_linemaps > (len - 2 * sizeof( dword )) / 2 )
+			throw RuntimeException( "Invalid .dvc file: line map section header missing or malformed." );
+		const byte* lp = p + 2 * sizeof( dword );
+		const byte* lines_end = p + len;
+		dword addr = 0, line = 0;
+		for( dword i = 0; i < num_linemaps; i++ )
 		{
-			getline( file, s, '\0' );
-			f->local_names.push_back( s );
+			dword addr_delta, line_delta;
+			if( !GetVarint( lp, lines_end, addr_delta ) || !GetVarint( lp, lines_end, line_delta ) )
+				throw RuntimeException( "Invalid .dvc file: line map entry is malformed." );
+			addr += addr_delta;
+			line += (dword)UnZigZag( line_delta );
+			code->lines->AddEntry( addr, line );
 		}
-	
-		// address
-		file.read( (char*)&f->addr, sizeof( dword ) );
-	
-		// module ptr will be set later
-		f->module = NULL;
-		// module name
-		string filepart = get_file_part( f->filename );
-		string mod = get_stem( filepart );
-		f->modulename = mod;
-	
-		AddFunction( f );
-	}
 
-	// read the line mapping
-	char lm_hdr[9];
-	char lm_hdr_pad[7];
-	file.read( lm_hdr, 9 );
-	if( strcmp( lm_hdr, ".linemap" ) != 0 )
-		throw RuntimeException( "Invalid .dvc file: line map section header missing or malformed." );
-	file.read( lm_hdr_pad, 7 );
-	if( lm_hdr_pad[0] != 0 || lm_hdr_pad[1] != 0 || lm_hdr_pad[2] != 0 || lm_hdr_pad[3] != 0 ||
-		lm_hdr_pad[4] != 0 || lm_hdr_pad[5] != 0 || lm_hdr_pad[6] != 0 )
-		throw RuntimeException( "Invalid .dvc file: line map section header missing or malformed." );
-	// section header is followed by a dword containing the number of line map entries
-	dword num_linemaps = 0;
-	file.read( (char*)&num_linemaps, sizeof( dword ) );
-	// line map data is an array of line map entries:
-	// dword : 			line number
-	// dword :			address of instruction
-	for( dword i = 0; i < num_linemaps; i++ )
+		// the byte code is used straight out of the mapping
+		code->code = FindSection( base, size, code_hdr, len );
+		code->len = len;
+		SizeFieldCaches( code );
+	}
+	catch( ... )
 	{
-		dword line = 0;
-		dword addr = 0;
-		file.read( (char*)&line, sizeof( dword ) );
-		file.read( (char*)&addr, sizeof( dword ) );
-		code->lines->Add( line, addr );
+		// (frees the mapping too)
+		delete code;
+		throw;
 	}
 
-	// get the size of the byte code
-	file.seekg( 0, ios::cur );
-	int beg = file.tellg();
-	file.seekg( 0, ios::end );
-	int end = file.tellg();
-	dword bc_length = end - beg;
-	file.seekg( beg );
-
-	// allocate memory for the byte code array
-	code->code = new byte[bc_length];
-	code->len = bc_length;
-
-	// read the file into the byte code array
-	file.read( (char*)(code->code), bc_length );
-
-	// close the file
-	file.close();
-
 	return code;
 }
 
@@ -4587,8 +5031,10 @@ void Executor::Decode( const Code* code)
 		if( line != LineMap::end && prev_line != line )
 			cout << line << endl;
 
-		// decode opcode
+		// decode opcode (behind the prefix, for one with dword operands)
 		op = (Opcode)*p;
+		if( op == op_wide && p + 1 < end )
+			op = (Opcode)p[1];
 		p += PrintOpcode( code, op, b, p );
 		cout << endl;
 	}
@@ -4598,11 +5044,16 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 {
 	int arg, arg2;
 	Object o;
-	int ret = 0;
+	// (addresses are printed as offsets in the code block)
+	const byte* instr = p;
+	int at = (int)(p - b);
+	bool wide = (Opcode)*p == op_wide;
+	if( wide )
+		op = (Opcode)p[1];
 
 	cout.width( 4 );
-	cout << (int)(p - b) << ": " <<  opcodeNames[op] << "\t";
-	p++;
+	cout << at << ": " << (wide ? "wide " : "") << opcodeNames[op] << "\t";
+	p += wide ? 2 : 1;
 	switch( op )
 	{
 	case op_nop:
@@ -4611,9 +5062,8 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 		break;
 	case op_push:
 		// 1 arg
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_push_true:
 	case op_push_false:
@@ -4628,9 +5078,8 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 		break;
 	case op_pushlocal:
 		// 1 arg
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_pushlocal0:
 	case op_pushlocal1:
@@ -4646,49 +5095,43 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 		break;
 	case op_pushconst:
 		// 1 arg: index to constant
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		// look-up the constant
 		o = GetConstant( code, arg );
 		cout << "\t" << arg << " (" << o << ")";
-		ret = sizeof( dword );
 		break;
 	case op_storeconst:
 		// 1 arg
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		// look-up the constant
 		o = GetConstant( code, arg );
 		cout << "\t" << arg << " (" << o << ")";
-		ret = sizeof( dword );
 		break;
 	case op_store_true:
 		// 1 arg
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		// look-up the constant
 		o = GetConstant( code, arg );
 		cout << "\t" << arg << " (" << o << ")";
-		ret = sizeof( dword );
 		break;
 	case op_store_false:
 		// 1 arg
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		// look-up the constant
 		o = GetConstant( code, arg );
 		cout << "\t" << arg << " (" << o << ")";
-		ret = sizeof( dword );
 		break;
 	case op_store_null:
 		// 1 arg
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		// look-up the constant
 		o = GetConstant( code, arg );
 		cout << "\t" << arg << " (" << o << ")";
-		ret = sizeof( dword );
 		break;
 	case op_storelocal:
 		// 1 arg
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_storelocal0:
 	case op_storelocal1:
@@ -4704,9 +5147,8 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 		break;
 	case op_def_local:
 		// 1 arg
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_def_local0:
 	case op_def_local1:
@@ -4723,75 +5165,66 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 	case op_def_function:
 		{
 		// 3 args: constant index of name, const idx of module name, fcn address
+		arg2 = ReadOperand( p, wide );
+		arg = ReadOperand( p, wide );
 		// look-up the module name constant
-		arg = *((dword*)(p + sizeof( dword )));
 		o = GetConstant( code, arg );
 
 		// look-up the module name constant
-		arg2= *((dword*)p);
 		Object o2 = GetConstant( code, arg2 );
 
 		// address
-		dword arg3= *((dword*)(p + (2 * sizeof( dword ))));
+		int arg3 = at + (int)ReadOperand( p, wide );
 
 		cout << arg << " " << arg2 << " (" << o << " # " << o2 << "), " << arg3;
-
-		ret = sizeof( dword ) * 3;
 		}
 		break;
 	case op_def_method:
 		{
 		// 4 args: constant index of function name, constant index of class name, const idx of module name, fcn address
+		arg2 = ReadOperand( p, wide );
+		dword arg3 = ReadOperand( p, wide );
+		arg = ReadOperand( p, wide );
 		// look-up the module name constant
-		arg = *((dword*)( p + (2 * sizeof( dword ))));
 		o = GetConstant( code, arg );
 
 		// look-up the function name constant
-		arg2 = *((dword*)p);
 		Object o2 = GetConstant( code, arg2 );
 
 		// look-up the class name constant
-		dword arg3 = *((dword*)( p + sizeof( dword ) ) );
 		Object o3 = GetConstant( code, arg3 );
 
 		// address
-		dword arg4 = *((dword*)( p + (3 * sizeof( dword ))));
+		int arg4 = at + (int)ReadOperand( p, wide );
 
 		cout << arg << " " << arg2 << " " << arg3 << " (" << o << " # " << o2 << " @ " << o3 << "), " << arg4;
-
-		ret = sizeof( dword ) * 4;
 		}
 		break;
 	case op_new_map:
 		// 1 arg: size
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_new_vec:
 		// 1 arg: size
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_new_class:
 		// 1 arg: size
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_jmp:
 		// 1 arg: size
-		arg = *((dword*)p);
+		arg = at + (int)ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_jmpt:
 	case op_jmpf:
 		// 1 arg: size
-		arg = *((dword*)p);
+		arg = at + (int)ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_eq:
 	case op_neq:
@@ -4810,6 +5243,15 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 	case op_mod:
 	case op_inc:
 	case op_dec:
+	case op_add_num:
+	case op_sub_num:
+	case op_mul_num:
+	case op_div_num:
+	case op_mod_num:
+	case op_lt_num:
+	case op_lte_num:
+	case op_gt_num:
+	case op_gte_num:
 		cout << "\t" << " ";
 		break;
 	case op_add_assign:
@@ -4818,11 +5260,10 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 	case op_div_assign:
 	case op_mod_assign:
 		// 1 arg: lhs
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		// look-up the constant
 		o = GetConstant( code, arg );
 		cout << "\t" << arg << " (" << o << ")";
-		ret = sizeof( dword );
 		break;
 	case op_add_assign_local:
 	case op_sub_assign_local:
@@ -4830,47 +5271,45 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 	case op_div_assign_local:
 	case op_mod_assign_local:
 		// 1 arg: lhs
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_call:
 	case op_call_method:
 		// 1 arg: number of args passed
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_return:
 		// 1 arg: number of scopes to leave
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_exit_loop:
 		// 2 args: jump target address, number of scopes to leave
-		arg = *((dword*)p);
-		ret = sizeof( dword );
-		arg2 = *((dword*)(p + sizeof( dword ) ) );
-		ret = sizeof( dword ) * 2;
+		arg = at + (int)ReadOperand( p, wide );
+		arg2 = ReadOperand( p, wide );
 		cout << "\t" << arg << "\t" << arg2;
 		break;
 	case op_enter:
 	case op_leave:
 		cout << "\t" << " ";
 		break;
+	case op_tbl_load:
+	case op_tbl_store:
+		// 1 arg: field cache index
+		arg = ReadOperand( p, wide );
+		cout << "\t" << arg;
+		break;
 	case op_for_iter:
 	case op_for_iter_pair:
 		// 1 arg: iterable object
-		arg = *((dword*)p);
+		arg = at + (int)ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
-	case op_tbl_load:
 	case op_method_load:
 	case op_loadslice2:
 	case op_loadslice3:
-	case op_tbl_store:
 	case op_storeslice2:
 	case op_storeslice3:
 	case op_add_tbl_store:
@@ -4881,9 +5320,8 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 		break;
 	case op_dup:
 		// 1 arg:
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_dup1:
 	case op_dup2:
@@ -4897,9 +5335,8 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 		break;
 	case op_rot:
 		// 1 arg:
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		cout << "\t" << arg;
-		ret = sizeof( dword );
 		break;
 	case op_rot2:
 	case op_rot3:
@@ -4907,19 +5344,36 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 		break;
 	case op_import:
 		// 1 arg:
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		// look-up the constant
 		o = GetConstant( code, arg );
 		cout << "\t" << arg << " (" << o << ")";
-		ret = sizeof( dword );
 		break;
 	case op_def_class:
 		// 1 arg:
-		arg = *((dword*)p);
+		arg = ReadOperand( p, wide );
 		// look-up the constant
 		o = GetConstant( code, arg );
 		cout << "\t" << arg << " (" << o << ")";
-		ret = sizeof( dword );
+		break;
+	case op_for_range_init:
+		// 3 args: number of args, first local, address of the loop
+		arg = ReadOperand( p, wide );
+		arg2 = ReadOperand( p, wide );
+		cout << "\t" << arg << " " << arg2 << ", " << at + (int)ReadOperand( p, wide );
+		break;
+	case op_for_range:
+		// 2 args: first local, address of the end of the loop
+		arg = ReadOperand( p, wide );
+		arg2 = at + (int)ReadOperand( p, wide );
+		cout << "\t" << arg << ", " << arg2;
+		break;
+	case op_inline_guard:
+		// 2 args: function name, address of the call
+		arg = ReadOperand( p, wide );
+		o = GetConstant( code, arg );
+		arg2 = at + (int)ReadOperand( p, wide );
+		cout << "\t" << arg << " (" << o << "), " << arg2;
 		break;
 	case op_halt:
 		cout << "\t" << " ";
@@ -4932,7 +5386,7 @@ int Executor::PrintOpcode( const Code* code, Opcode op, const byte* b, byte* p )
 		cout << "Error: Invalid instruction.";
 		break;
 	}
-	return ret+1;
+	return (int)(p - instr);
 }
 
 void Executor::DumpFunctions()
@@ -4950,7 +5404,26 @@ void Executor::DumpFunctions()
 		for( size_t j = 0; j < f->local_names.size(); j++ )
 			cout << f->local_names.operator[]( j ) << " ";
 		cout << endl << "code address: " << f->addr << endl;
+		if( f->inlined )
+			cout << "inlined at " << f->inlined << " call site(s)" << endl;
+	}
+}
+
+void Executor::DumpInlinedCalls()
+{
+	cout << "Inlined calls:" << endl;
+	dword total = 0;
+	for( multimap<string,Object*>::iterator i = functions.begin(); i != functions.end(); ++i )
+	{
+		Function* f = i->second->f;
+		if( f->inlined )
+		{
+			cout << "function: " << f->name << ", from file: " << f->filename << ", line: " << f->first_line;
+			cout << ", inlined at " << f->inlined << " call site(s)" << endl;
+			total += f->inlined;
+		}
 	}
+	cout << total << " call site(s) inlined" << endl;
 }
 
 void Executor::DumpConstantPool( const Code* code )
@@ -4964,7 +5437,7 @@ void Executor::DumpConstantPool( const Code* code )
 		else if( o.type == obj_symbol_name )
 			cout << "symbol name: " << o.s << endl;
 		else if( o.type == obj_number )
-			cout << o.d << endl;
+			cout << o.Num() << endl;
 		else if( o.type == obj_boolean )
 			cout << (o.b ? "<boolean-true>" : "<boolean-false>") << endl;
 		else if( o.type == obj_null )
@@ -5033,7 +5506,9 @@ void Executor::DumpTrace( ostream & os )
 	// if there's no code block, there's nothing we can do but fail
 	if( !code )
 		return;
-	line = code->lines->FindLine( loc );
+	// (ip is past the opcode of the instruction that failed, which can be the
+	// last one of its line)
+	line = code->lines->FindLine( loc > 0 ? loc - 1 : loc );
 	f = callstack.back();
 	if( f->IsNative() )
 		os << "file: [Native Module]" << ", at: " << loc << ", in [Native Function]" << endl;
@@ -75,7 +75,7 @@ Frame::~Frame()
 	// free the local strings
 	for( vector<char*>::iterator i = strings.begin(); i != strings.end(); ++i )
 	{
-		delete [] *i;
+		freestr( *i );
 	}
 	// dec ref the args
 	int i = 0;
@@ -95,12 +95,16 @@ Object Frame::CopyStringsFromParent( Object & o )
 {
 	if( o.type == obj_string )
 	{
-		// add the string to the parent and get a ptr to it
-		const char* str = GetParent()->AddString( string( o.s ) );
+		// add a copy of the string to the parent
+		char* str = dupstr( o.s );
+		GetParent()->AddString( str );
 		return Object( str );
 	}
 	else if( o.type == obj_vector )
 	{
+		// (packed vectors hold no strings)
+		if( o.v->IsPacked() )
+			return o;
 		for( Vector::iterator i = o.v->begin(); i != o.v->end(); ++i )
 		{
 			*i = CopyStringsFromParent( *i );
@@ -153,7 +153,7 @@ void do_map_length( Frame *frame )
 
 	int len = (int)self->m->size();
 
-	helper.ReturnVal( Object( (double)len ) );
+	helper.ReturnVal( Object( (int64_t)len ) );
 }
 
 // 'enumerable interface'
@@ -260,6 +260,8 @@ void do_map_remove( Frame* frame )
 	Object* o = helper.GetLocalN( 1 );
 
 	// remove the value
+	// (removing a field drops an instance out of its shape)
+	self->m->MakeDictionary();
 	self->m->erase( *o );
 
 	helper.ReturnVal( Object( obj_null ) );
@@ -340,6 +342,8 @@ void do_map_merge( Frame* frame )
 	helper.ExpectMapType( self );
 	Object* o = helper.GetLocalN( 1 );
 
+	// bulk-added fields aren't tracked by shape, drop to dictionary mode
+	self->m->MakeDictionary();
 	self->m->insert( o->m->begin(), o->m->end() );
 
 	helper.ReturnVal( Object( obj_null ) );
@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// mappedfile.cpp
+// read-only (copy-on-write) file mappings for the deva language
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#include "mappedfile.h"
+#include "exceptions.h"
+
+#include <fstream>
+
+#ifndef MS_WINDOWS
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace deva
+{
+
+
+MappedFile::MappedFile( const string & filename ) : data( NULL ), size( 0 ), mapped( false )
+{
+#ifndef MS_WINDOWS
+	int fd = open( filename.c_str(), O_RDONLY );
+	if( fd == -1 )
+		throw RuntimeException( boost::format( "Unable to open input file '%1%' for read." ) % filename );
+	struct stat statbuf;
+	if( fstat( fd, &statbuf ) == -1 )
+	{
+		close( fd );
+		throw RuntimeException( boost::format( "Unable to open input file '%1%' for read." ) % filename );
+	}
+	size = (size_t)statbuf.st_size;
+	// mmap can't map an empty file, leave it as a NULL/0 mapping
+	if( size != 0 )
+	{
+		void* p = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+		if( p == MAP_FAILED )
+		{
+			close( fd );
+			throw RuntimeException( boost::format( "Unable to map input file '%1%'." ) % filename );
+		}
+		data = (byte*)p;
+		mapped = true;
+	}
+	// the mapping stays valid after the descriptor is closed
+	close( fd );
+#else
+	ifstream file;
+	file.open( filename.c_str(), ios::binary );
+	if( file.fail() )
+		throw RuntimeException( boost::format( "Unable to open input file '%1%' for read." ) % filename );
+	file.seekg( 0, ios::end );
+	size = (size_t)file.tellg();
+	file.seekg( 0, ios::beg );
+	data = new byte[size];
+	file.read( (char*)data, size );
+	file.close();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef MS_WINDOWS
+	if( mapped )
+		munmap( data, size );
+#else
+	delete[] data;
+#endif
+}
+
+
+} // end namespace deva
@@ -31,6 +31,7 @@
 #include "module_bit.h"
 #include "module.h"
 #include "builtins_helpers.h"
+#include "number.h"
 
 
 namespace deva
@@ -88,11 +89,11 @@ void do_bit_and( Frame* f )
 	Object* a = helper.GetLocalN( 1 );
 	helper.ExpectType( a, obj_number );
 
-	size_t n = (size_t)(o->d);
-	size_t op = (size_t)(a->d);
+	size_t n = (size_t)NumToInt( *o );
+	size_t op = (size_t)NumToInt( *a );
 	size_t ret = n & op;
 
-	helper.ReturnVal( Object( (double)ret ) );
+	helper.ReturnVal( Object( (int64_t)ret ) );
 }
 
 void do_bit_or( Frame* f )
@@ -106,11 +107,11 @@ void do_bit_or( Frame* f )
 	Object* a = helper.GetLocalN( 1 );
 	helper.ExpectType( a, obj_number );
 
-	size_t n = (size_t)(o->d);
-	size_t op = (size_t)(a->d);
+	size_t n = (size_t)NumToInt( *o );
+	size_t op = (size_t)NumToInt( *a );
 	size_t ret = n | op;
 
-	helper.ReturnVal( Object( (double)ret ) );
+	helper.ReturnVal( Object( (int64_t)ret ) );
 }
 
 void do_bit_xor( Frame* f )
@@ -124,11 +125,11 @@ void do_bit_xor( Frame* f )
 	Object* a = helper.GetLocalN( 1 );
 	helper.ExpectType( a, obj_number );
 
-	size_t n = (size_t)(o->d);
-	size_t op = (size_t)(a->d);
+	size_t n = (size_t)NumToInt( *o );
+	size_t op = (size_t)NumToInt( *a );
 	size_t ret = n ^ op;
 
-	helper.ReturnVal( Object( (double)ret ) );
+	helper.ReturnVal( Object( (int64_t)ret ) );
 }
 
 void do_bit_complement( Frame* f )
@@ -139,10 +140,10 @@ void do_bit_complement( Frame* f )
 	Object* o = helper.GetLocalN( 0 );
 	helper.ExpectType( o, obj_number );
 
-	size_t n = (size_t)(o->d);
+	size_t n = (size_t)NumToInt( *o );
 	size_t ret = ~n;
 
-	helper.ReturnVal( Object( (double)ret ) );
+	helper.ReturnVal( Object( (int64_t)ret ) );
 }
 
 void do_bit_shift_left( Frame* f )
@@ -156,11 +157,11 @@ void do_bit_shift_left( Frame* f )
 	Object* a = helper.GetLocalN( 1 );
 	helper.ExpectType( a, obj_number );
 
-	size_t n = (size_t)(o->d);
-	size_t op = (size_t)(a->d);
+	size_t n = (size_t)NumToInt( *o );
+	size_t op = (size_t)NumToInt( *a );
 	size_t ret = n << op;
 
-	helper.ReturnVal( Object( (double)ret ) );
+	helper.ReturnVal( Object( (int64_t)ret ) );
 }
 
 void do_bit_shift_right( Frame* f )
@@ -174,11 +175,11 @@ void do_bit_shift_right( Frame* f )
 	Object* a = helper.GetLocalN( 1 );
 	helper.ExpectType( a, obj_number );
 
-	size_t n = (size_t)(o->d);
-	size_t op = (size_t)(a->d);
+	size_t n = (size_t)NumToInt( *o );
+	size_t op = (size_t)NumToInt( *a );
 	size_t ret = n >> op;
 
-	helper.ReturnVal( Object( (double)ret ) );
+	helper.ReturnVal( Object( (int64_t)ret ) );
 }
 
 } // namespace deva
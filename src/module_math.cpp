@@ -31,6 +31,7 @@
 #include "module_math.h"
 #include "builtins_helpers.h"
 #include "module.h"
+#include "numeric.h"
 #include <cmath>
 
 
@@ -112,262 +113,221 @@ NativeModule* GetModuleMath()
 /////////////////////////////////////////////////////////////////////////////
 // module math functions
 /////////////////////////////////////////////////////////////////////////////
-void do_math_cos( Frame* f )
+
+// the math functions take numbers, or vectors of numbers, which return vectors
+// of the results (computed over the numbers as arrays, see numeric.h)
+
+// functions taking one argument
+template<double (*F)( double )>
+static void UnaryMath( Frame* f, const char* name )
 {
-	BuiltinHelper helper( "math", "cos", f, true );
+	BuiltinHelper helper( "math", name, f, true );
 	helper.CheckNumberOfArguments( 1 );
 
 	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
+	helper.ExpectTypes( o, obj_number, obj_vector );
 
-	double ret = cos( o->d );
+	if( o->type == obj_number )
+	{
+		helper.ReturnVal( Object( F( o->Num() ) ) );
+		return;
+	}
 
-	helper.ReturnVal( Object( ret ) );
+	vector<double> tmp;
+	const double* nums = helper.GetNumbers( o, tmp );
+	vector<double> ret( o->v->size() );
+	if( !ret.empty() )
+		MapNumbers<F>( &ret[0], nums, ret.size() );
+
+	helper.ReturnVal( Object( CreateNumberVector( ret ) ) );
 }
 
-void do_math_sin( Frame* f )
+// functions taking two arguments (either of which can be a vector, if both
+// are they must be the same length)
+template<double (*F)( double, double )>
+static void BinaryMath( Frame* f, const char* name )
 {
-	BuiltinHelper helper( "math", "sin", f, true );
-	helper.CheckNumberOfArguments( 1 );
+	BuiltinHelper helper( "math", name, f, true );
+	helper.CheckNumberOfArguments( 2 );
 
 	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
+	helper.ExpectTypes( o, obj_number, obj_vector );
 
-	double ret = sin( o->d );
-
-	helper.ReturnVal( Object( ret ) );
+	Object* a = helper.GetLocalN( 1 );
+	helper.ExpectTypes( a, obj_number, obj_vector );
+
+	if( o->type == obj_number && a->type == obj_number )
+	{
+		helper.ReturnVal( Object( F( o->Num(), a->Num() ) ) );
+		return;
+	}
+
+	size_t sz = o->type == obj_vector ? o->v->size() : a->v->size();
+	if( o->type == obj_vector && a->type == obj_vector && a->v->size() != sz )
+		throw RuntimeException( boost::format( "Vectors passed to math module function '%1%' must be the same length." ) % name );
+
+	vector<double> tmp_o, tmp_a;
+	const double* nums_o = o->type == obj_vector ? helper.GetNumbers( o, tmp_o ) : NULL;
+	const double* nums_a = a->type == obj_vector ? helper.GetNumbers( a, tmp_a ) : NULL;
+	vector<double> ret( sz );
+	if( sz )
+	{
+		ZipNumbers<F>( &ret[0], 
+			nums_o, o->type == obj_number ? o->Num() : 0.0, 
+			nums_a, a->type == obj_number ? a->Num() : 0.0, sz );
+	}
+
+	helper.ReturnVal( Object( CreateNumberVector( ret ) ) );
 }
 
-void do_math_tan( Frame* f )
+// (these have external linkage, so they can be template arguments)
+double MathRadians( double d )
 {
-	BuiltinHelper helper( "math", "tan", f, true );
-	helper.CheckNumberOfArguments( 1 );
+	return (3.14159265359 / 180.0) * d;
+}
 
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
+double MathDegrees( double r )
+{
+	return (180.0 / 3.14159265359) * r;
+}
 
-	double ret = tan( o->d );
+double MathRound( double d )
+{
+	double intpart;
+	double fracpart = modf( d, &intpart );
 
-	helper.ReturnVal( Object( ret ) );
+	if( fracpart >= 0.5 )
+		intpart += 1.0;
+	return intpart;
 }
 
-void do_math_acos( Frame* f )
+void do_math_cos( Frame* f )
 {
-	BuiltinHelper helper( "math", "acos", f, true );
-	helper.CheckNumberOfArguments( 1 );
+	UnaryMath<cos>( f, "cos" );
+}
 
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
+void do_math_sin( Frame* f )
+{
+	UnaryMath<sin>( f, "sin" );
+}
 
-	double ret = acos( o->d );
+void do_math_tan( Frame* f )
+{
+	UnaryMath<tan>( f, "tan" );
+}
 
-	helper.ReturnVal( Object( ret ) );
+void do_math_acos( Frame* f )
+{
+	UnaryMath<acos>( f, "acos" );
 }
 
 void do_math_asin( Frame* f )
 {
-	BuiltinHelper helper( "math", "asin", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = asin( o-> d);
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<asin>( f, "asin" );
 }
 
 void do_math_atan( Frame* f )
 {
-	BuiltinHelper helper( "math", "atan", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = atan( o-> d);
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<atan>( f, "atan" );
 }
 
 void do_math_cosh( Frame* f )
 {
-	BuiltinHelper helper( "math", "cosh", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = cosh( o-> d);
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<cosh>( f, "cosh" );
 }
 
 void do_math_sinh( Frame* f )
 {
-	BuiltinHelper helper( "math", "sinh", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = sinh( o-> d); 
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<sinh>( f, "sinh" );
 }
 
 void do_math_tanh( Frame* f )
 {
-	BuiltinHelper helper( "math", "tanh", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = tanh( o-> d);
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<tanh>( f, "tanh" );
 }
 
 void do_math_exp( Frame* f )
 {
-	BuiltinHelper helper( "math", "exp", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = exp( o->d );  
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<exp>( f, "exp" );
 }
 
 void do_math_log( Frame* f )
 {
-	BuiltinHelper helper( "math", "log", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = log( o->d );
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<log>( f, "log" );
 }
 
 void do_math_log10( Frame* f )
 {
-	BuiltinHelper helper( "math", "log10", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = log10( o->d );
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<log10>( f, "log10" );
 }
 
 void do_math_abs( Frame* f )
 {
-	BuiltinHelper helper( "math", "abs", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = abs( o->d );
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<fabs>( f, "abs" );
 }
 
 void do_math_sqrt( Frame* f )
 {
-	BuiltinHelper helper( "math", "sqrt", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = sqrt( o->d );
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<sqrt>( f, "sqrt" );
 }
 
 void do_math_pow( Frame* f )
 {
-	BuiltinHelper helper( "math", "pow", f, true );
-	helper.CheckNumberOfArguments( 2 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	Object* a = helper.GetLocalN( 1 );
-	helper.ExpectType( a, obj_number );
-
-	double ret = pow( o->d, a->d );
-
-	helper.ReturnVal( Object( ret ) );
+	BinaryMath<pow>( f, "pow" );
 }
 
+// returns [integral part, fractional part] (for a vector: a vector of the
+// integral parts and a vector of the fractional parts)
 void do_math_modf( Frame* f )
 {
 	BuiltinHelper helper( "math", "modf", f, true );
 	helper.CheckNumberOfArguments( 1 );
 
 	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double intpart;
-	double fracpart = modf( o->d, &intpart );
+	helper.ExpectTypes( o, obj_number, obj_vector );
 
 	Vector* ret = CreateVector();
-	ret->push_back( Object( intpart ) );
-	ret->push_back( Object( fracpart ) );
+	if( o->type == obj_number )
+	{
+		double intpart;
+		double fracpart = modf( o->Num(), &intpart );
+
+		ret->push_back( Object( intpart ) );
+		ret->push_back( Object( fracpart ) );
+	}
+	else
+	{
+		vector<double> tmp;
+		const double* nums = helper.GetNumbers( o, tmp );
+		size_t sz = o->v->size();
+		vector<double> ints( sz ), fracs( sz );
+		for( size_t i = 0; i < sz; i++ )
+			fracs[i] = modf( nums[i], &ints[i] );
+
+		Vector* intv = CreateNumberVector( ints );
+		Vector* fracv = CreateNumberVector( fracs );
+		intv->IncRef();
+		fracv->IncRef();
+		ret->push_back( Object( intv ) );
+		ret->push_back( Object( fracv ) );
+	}
 
 	helper.ReturnVal( Object( ret ) );
 }
 
 void do_math_fmod( Frame* f )
 {
-	BuiltinHelper helper( "math", "fmod", f, true );
-	helper.CheckNumberOfArguments( 2 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	Object* a = helper.GetLocalN( 1 );
-	helper.ExpectType( a, obj_number );
-
-	double ret = fmod( o->d, a->d );
-
-	helper.ReturnVal( Object( ret ) );
+	BinaryMath<fmod>( f, "fmod" );
 }
 
 void do_math_floor( Frame* f )
 {
-	BuiltinHelper helper( "math", "floor", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = floor( o->d );
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<floor>( f, "floor" );
 }
 
 void do_math_ceil( Frame* f )
 {
-	BuiltinHelper helper( "math", "ceil", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = ceil( o->d );
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<ceil>( f, "ceil" );
 }
 
 void do_math_pi( Frame* f )
@@ -380,48 +340,19 @@ void do_math_pi( Frame* f )
 
 void do_math_radians( Frame* f )
 {
-	BuiltinHelper helper( "math", "radians", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = (3.14159265359 / 180.0) * o->d;
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<MathRadians>( f, "radians" );
 }
 
 void do_math_degrees( Frame* f )
 {
-	BuiltinHelper helper( "math", "degrees", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double ret = (180.0 / 3.14159265359) * o->d;
-
-	helper.ReturnVal( Object( ret ) );
+	UnaryMath<MathDegrees>( f, "degrees" );
 }
 
 void do_math_round( Frame* f )
 {
-	BuiltinHelper helper( "math", "round", f, true );
-	helper.CheckNumberOfArguments( 1 );
-
-	Object* o = helper.GetLocalN( 0 );
-	helper.ExpectType( o, obj_number );
-
-	double intpart;
-	double fracpart = modf( o->d, &intpart );
-
-	if( fracpart >= 0.5 )
-		intpart += 1.0;
-
-	helper.ReturnVal( Object( intpart ) );
+	UnaryMath<MathRound>( f, "round" );
 }
 
-
 } // namespace deva
 
 
@@ -207,7 +207,7 @@ void do_os_joinpaths( Frame* f )
 		if( s->type != obj_string )
 			throw RuntimeException( "'paths' argument to module 'os' function 'joinpaths' must be a vector containing only strings." );
 
-		v.push_back( s->s );
+		v.push_back( string( s->s ) );
 	}
 	string retstr = join_paths( v );
 
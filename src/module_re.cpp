@@ -112,7 +112,7 @@ void do_re_match( Frame* f )
 
 
 	cmatch match;
-	bool found = regex_match( s->s, match, *((boost::regex*)(r->no)) );
+	bool found = regex_match( (const char*)s->s, match, *((boost::regex*)(r->no)) );
 
 	Vector* vec;
 	if( found )
@@ -150,7 +150,7 @@ void do_re_search( Frame* f )
 	helper.ExpectType( s, obj_string );
 
 	cmatch match;
-	bool found = regex_search( s->s, match, *((boost::regex*)(r->no)) );
+	bool found = regex_search( (const char*)s->s, match, *((boost::regex*)(r->no)) );
 
 	Vector* vec;
 	if( found )
@@ -0,0 +1,323 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// numeric.cpp
+// numeric kernels over arrays of doubles (packed vectors' numbers)
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#include "numeric.h"
+
+// x86 builds with gcc (or clang) get SSE2 and AVX versions of the reductions,
+// compiled for those instruction sets individually (so the rest of the
+// executable doesn't require them) and picked at run-time
+#if defined( __GNUC__ ) && (defined( __x86_64__ ) || defined( __i386__ ))
+#define DEVA_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+namespace deva
+{
+
+
+// gcc compiles the precise versions without -ffast-math's re-ordering (or
+// fused multiply-adds), whatever the build's flags
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#define DEVA_STRICT_FP __attribute__(( optimize( "no-fast-math", "fp-contract=off" ) ))
+#else
+#define DEVA_STRICT_FP
+#endif
+
+
+// precise versions: one sum, in order
+DEVA_STRICT_FP
+static double SumPrecise( const double* a, size_t n )
+{
+	double s = 0;
+	for( size_t i = 0; i < n; i++ )
+		s += a[i];
+	return s;
+}
+
+DEVA_STRICT_FP
+static double DotPrecise( const double* a, const double* b, size_t n )
+{
+	double s = 0;
+	for( size_t i = 0; i < n; i++ )
+		s += a[i] * b[i];
+	return s;
+}
+
+// the math functions on each number, one at a time
+DEVA_STRICT_FP
+void MapNumbersPrecise( double* out, const double* a, size_t n, double (*f)( double ) )
+{
+	for( size_t i = 0; i < n; i++ )
+		out[i] = f( a[i] );
+}
+
+DEVA_STRICT_FP
+void ZipNumbersPrecise( double* out, const double* a, double ka, const double* b, double kb, size_t n, double (*f)( double, double ) )
+{
+	for( size_t i = 0; i < n; i++ )
+		out[i] = f( a ? a[i] : ka, b ? b[i] : kb );
+}
+
+// scalar versions
+// (four partial sums, so that the adds don't all wait on each other)
+static double SumScalar( const double* a, size_t n )
+{
+	double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	size_t i = 0;
+	for( ; i + 4 <= n; i += 4 )
+	{
+		s0 += a[i];
+		s1 += a[i+1];
+		s2 += a[i+2];
+		s3 += a[i+3];
+	}
+	for( ; i < n; i++ )
+		s0 += a[i];
+	return (s0 + s1) + (s2 + s3);
+}
+
+static double DotScalar( const double* a, const double* b, size_t n )
+{
+	double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	size_t i = 0;
+	for( ; i + 4 <= n; i += 4 )
+	{
+		s0 += a[i] * b[i];
+		s1 += a[i+1] * b[i+1];
+		s2 += a[i+2] * b[i+2];
+		s3 += a[i+3] * b[i+3];
+	}
+	for( ; i < n; i++ )
+		s0 += a[i] * b[i];
+	return (s0 + s1) + (s2 + s3);
+}
+
+#ifdef DEVA_X86_SIMD
+// SSE2: two lanes, two accumulators
+__attribute__(( target( "sse2" ) ))
+static double SumSSE2( const double* a, size_t n )
+{
+	__m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+	size_t i = 0;
+	for( ; i + 4 <= n; i += 4 )
+	{
+		s0 = _mm_add_pd( s0, _mm_loadu_pd( a + i ) );
+		s1 = _mm_add_pd( s1, _mm_loadu_pd( a + i + 2 ) );
+	}
+	double lanes[2];
+	_mm_storeu_pd( lanes, _mm_add_pd( s0, s1 ) );
+	double s = lanes[0] + lanes[1];
+	for( ; i < n; i++ )
+		s += a[i];
+	return s;
+}
+
+__attribute__(( target( "sse2" ) ))
+static double DotSSE2( const double* a, const double* b, size_t n )
+{
+	__m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+	size_t i = 0;
+	for( ; i + 4 <= n; i += 4 )
+	{
+		s0 = _mm_add_pd( s0, _mm_mul_pd( _mm_loadu_pd( a + i ), _mm_loadu_pd( b + i ) ) );
+		s1 = _mm_add_pd( s1, _mm_mul_pd( _mm_loadu_pd( a + i + 2 ), _mm_loadu_pd( b + i + 2 ) ) );
+	}
+	double lanes[2];
+	_mm_storeu_pd( lanes, _mm_add_pd( s0, s1 ) );
+	double s = lanes[0] + lanes[1];
+	for( ; i < n; i++ )
+		s += a[i] * b[i];
+	return s;
+}
+
+// AVX: four lanes, two accumulators
+__attribute__(( target( "avx" ) ))
+static double SumAVX( const double* a, size_t n )
+{
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+	size_t i = 0;
+	for( ; i + 8 <= n; i += 8 )
+	{
+		s0 = _mm256_add_pd( s0, _mm256_loadu_pd( a + i ) );
+		s1 = _mm256_add_pd( s1, _mm256_loadu_pd( a + i + 4 ) );
+	}
+	double lanes[4];
+	_mm256_storeu_pd( lanes, _mm256_add_pd( s0, s1 ) );
+	double s = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for( ; i < n; i++ )
+		s += a[i];
+	return s;
+}
+
+__attribute__(( target( "avx" ) ))
+static double DotAVX( const double* a, const double* b, size_t n )
+{
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+	size_t i = 0;
+	for( ; i + 8 <= n; i += 8 )
+	{
+		s0 = _mm256_add_pd( s0, _mm256_mul_pd( _mm256_loadu_pd( a + i ), _mm256_loadu_pd( b + i ) ) );
+		s1 = _mm256_add_pd( s1, _mm256_mul_pd( _mm256_loadu_pd( a + i + 4 ), _mm256_loadu_pd( b + i + 4 ) ) );
+	}
+	double lanes[4];
+	_mm256_storeu_pd( lanes, _mm256_add_pd( s0, s1 ) );
+	double s = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for( ; i < n; i++ )
+		s += a[i] * b[i];
+	return s;
+}
+#endif // DEVA_X86_SIMD
+
+// run-time dispatch
+typedef double (*SumFcn)( const double*, size_t );
+typedef double (*DotFcn)( const double*, const double*, size_t );
+
+static SumFcn ChooseSum()
+{
+#ifdef DEVA_X86_SIMD
+	__builtin_cpu_init();
+	if( __builtin_cpu_supports( "avx" ) )
+		return SumAVX;
+	if( __builtin_cpu_supports( "sse2" ) )
+		return SumSSE2;
+#endif
+	return SumScalar;
+}
+
+static DotFcn ChooseDot()
+{
+#ifdef DEVA_X86_SIMD
+	__builtin_cpu_init();
+	if( __builtin_cpu_supports( "avx" ) )
+		return DotAVX;
+	if( __builtin_cpu_supports( "sse2" ) )
+		return DotSSE2;
+#endif
+	return DotScalar;
+}
+
+static SumFcn sum_fcn = ChooseSum();
+static DotFcn dot_fcn = ChooseDot();
+static bool precise_reductions = false;
+
+void SetPreciseReductions( bool precise )
+{
+	precise_reductions = precise;
+	sum_fcn = precise ? SumPrecise : ChooseSum();
+	dot_fcn = precise ? DotPrecise : ChooseDot();
+}
+
+bool PreciseReductions()
+{
+	return precise_reductions;
+}
+
+double SumNumbers( const double* a, size_t n )
+{
+	return sum_fcn( a, n );
+}
+
+double DotNumbers( const double* a, const double* b, size_t n )
+{
+	return dot_fcn( a, b, n );
+}
+
+size_t MinIndex( const double* a, size_t n )
+{
+	size_t idx = 0;
+	for( size_t i = 1; i < n; i++ )
+	{
+		if( a[i] < a[idx] )
+			idx = i;
+	}
+	return idx;
+}
+
+size_t MaxIndex( const double* a, size_t n )
+{
+	size_t idx = 0;
+	for( size_t i = 1; i < n; i++ )
+	{
+		if( a[i] > a[idx] )
+			idx = i;
+	}
+	return idx;
+}
+
+void AddNumbers( double* out, const double* a, const double* b, size_t n )
+{
+	for( size_t i = 0; i < n; i++ )
+		out[i] = a[i] + b[i];
+}
+
+void SubNumbers( double* out, const double* a, const double* b, size_t n )
+{
+	for( size_t i = 0; i < n; i++ )
+		out[i] = a[i] - b[i];
+}
+
+void MulNumbers( double* out, const double* a, const double* b, size_t n )
+{
+	for( size_t i = 0; i < n; i++ )
+		out[i] = a[i] * b[i];
+}
+
+void AddScalar( double* out, const double* a, double k, size_t n )
+{
+	for( size_t i = 0; i < n; i++ )
+		out[i] = a[i] + k;
+}
+
+void MulScalar( double* out, const double* a, double k, size_t n )
+{
+	for( size_t i = 0; i < n; i++ )
+		out[i] = a[i] * k;
+}
+
+void ClipNumbers( double* out, const double* a, double lo, double hi, size_t n )
+{
+	for( size_t i = 0; i < n; i++ )
+		out[i] = a[i] < lo ? lo : (a[i] > hi ? hi : a[i]);
+}
+
+void CumSum( double* out, const double* a, size_t n )
+{
+	double s = 0;
+	for( size_t i = 0; i < n; i++ )
+	{
+		s += a[i];
+		out[i] = s;
+	}
+}
+
+
+} // end namespace deva
@@ -26,8 +26,10 @@
 // created by jcs, december 18, 2010 
 
 #include "object.h"
+#include "number.h"
 #include "exceptions.h"
 #include "executor.h"
+#include "shape.h"
 #include <set>
 
 using namespace std;
@@ -53,6 +55,8 @@ const char* object_type_names[] =
 	"symbol name",
 	"module",
 	"native module",
+	"buffer",
+	"string builder",
 	"<invalid>"
 };
 
@@ -92,45 +96,262 @@ void IncRef( Object & o )
 #endif 
 		o.m->IncRef();
 	}
+	else if( o.type == obj_buffer )
+	{
+		o.buf->IncRef();
+	}
+	else if( o.type == obj_stringbuilder )
+	{
+		o.sb->IncRef();
+	}
 }
 
-// inc ref this object's children
-// for use when creating a copy of a reference type object
-// (e.g. when creating an instance from a class object)
-void IncRefChildren( Object & o )
+// move the items out of this vector's own store into a (heap) store that
+// other vectors can share. (the items' memory is handed over, not copied, so
+// they stay where they are)
+void VectorBase::MakeShareable() const
 {
-	if( IsVecType( o.type ) )
+	if( store != &own )
+		return;
+	Store* s = new Store();
+	s->items.swap( own.items );
+	s->numbers.swap( own.numbers );
+	s->packed = own.packed;
+	own.packed = false;
+	store = s;
+}
+
+// share the store of 'v' (and its view of it). items in 'v's inline storage
+// are just copied (and inc-ref'd), which is cheaper than a store to share
+void VectorBase::Share( const VectorBase & v )
+{
+	if( v.is_inline() )
 	{
-		// walk the vector's contents
-		for( size_t i = 0; i < o.v->size(); i++ )
+		for( Items::const_iterator i = v.store->items.begin(); i != v.store->items.end(); ++i )
 		{
-			Object obj = o.v->operator[]( i );
-			IncRef( obj );
+			own.items.push_back( *i );
+			IncRef( own.items.back() );
 		}
+		return;
 	}
-	else if( IsMapType( o.type ) )
+	v.MakeShareable();
+	store = v.store;
+	start = v.start;
+	count = v.count;
+	stride = v.stride;
+	store->refs++;
+}
+
+// 'slice constructor': every 'step'th item from 'start' to 'end' of 'v'. a
+// slice of the whole vector shares its store, as does a large slice (as a
+// view). small slices are copied (and their items inc-ref'd), rather than
+// keeping all of 'v's items alive
+VectorBase::VectorBase( const VectorBase & v, size_t start, size_t end, size_t step ) : index( 0 ), store( &own ), start( 0 ), count( 0 ), stride( 0 )
+{
+	size_t n = end > start ? (end - start + step - 1) / step : 0;
+	if( start == 0 && end == v.size() && step == 1 )
+		Share( v );
+	else if( n > vector_inline_size )
 	{
-		// walk the map's contents
-		for( Map::iterator it = o.m->begin(); it != o.m->end(); ++it )
+		v.MakeShareable();
+		store = v.store;
+		this->start = v.Index( start );
+		count = n;
+		stride = (v.stride ? v.stride : 1) * step;
+		store->refs++;
+	}
+	else
+	{
+		store->packed = v.store->packed;
+		for( size_t i = 0; i < n; i++ )
+		{
+			size_t k = v.Index( start + i * step );
+			if( store->packed )
+				store->numbers.push_back( v.store->numbers[k] );
+			else
+			{
+				store->items.push_back( v.store->items[k] );
+				IncRef( store->items.back() );
+			}
+		}
+	}
+}
+
+// copy the items this vector sees (from a shared store) into its own store, so
+// that it can be modified (or, for a view, accessed directly)
+void VectorBase::Separate() const
+{
+	Store* s = &own;
+	size_t n = size();
+	s->packed = store->packed;
+	if( s->packed )
+	{
+		s->numbers.reserve( n );
+		for( size_t i = 0; i < n; i++ )
+			s->numbers.push_back( store->numbers[Index( i )] );
+	}
+	else
+	{
+		s->items.reserve( n );
+		// the new store holds its own refs on the items
+		for( size_t i = 0; i < n; i++ )
+		{
+			s->items.push_back( store->items[Index( i )] );
+			IncRef( s->items.back() );
+		}
+	}
+	// (only a view can be the last user of the store it is leaving)
+	if( --store->refs == 0 )
+	{
+		if( !store->packed )
 		{
-			IncRef( const_cast<Object&>(it->first) );
-			IncRef( it->second );
+			for( Items::iterator i = store->items.begin(); i != store->items.end(); ++i )
+				DecRef( *i );
 		}
+		delete store;
+	}
+	store = s;
+	start = 0;
+	count = 0;
+	stride = 0;
+}
+
+// release the store's refs on its items
+void VectorBase::ReleaseItems()
+{
+	// a shared store keeps its refs, just give up this vector's share of it
+	if( store->refs > 1 )
+	{
+		store->refs--;
+		store = &own;
+		stride = 0;
+		return;
+	}
+	// (packed vectors hold only numbers)
+	if( store->packed )
+		return;
+	// (all of the store's items, not just those a view sees)
+	for( Items::iterator i = store->items.begin(); i != store->items.end(); ++i )
+		DecRef( *i );
+}
+
+// pack a vector, if all its items are numbers
+bool VectorBase::Pack()
+{
+	if( store->packed )
+		return true;
+	for( size_t i = 0; i < size(); i++ )
+	{
+		if( !IsPackable( store->items[Index( i )] ) )
+			return false;
+	}
+	Own();
+	store->numbers.reserve( store->items.size() );
+	for( Items::iterator i = store->items.begin(); i != store->items.end(); ++i )
+		store->numbers.push_back( i->Num() );
+	store->items.clear();
+	store->packed = true;
+	return true;
+}
+
+// convert a packed vector's numbers to Objects
+void VectorBase::DoUnpack() const
+{
+	store->items.reserve( store->numbers.size() );
+	for( vector<double>::const_iterator i = store->numbers.begin(); i != store->numbers.end(); ++i )
+		store->items.push_back( NumberObject( *i ) );
+	// release the numbers' memory
+	vector<double>().swap( store->numbers );
+	store->packed = false;
+}
+
+// move the pairs out of this map's own store into a (heap) store that other
+// maps can share. (map nodes don't move, so the slots stay valid)
+void MapBase::MakeShareable() const
+{
+	if( store != &own )
+		return;
+	Store* s = new Store();
+	s->pairs.swap( own.pairs );
+	store = s;
+}
+
+// copy the shared store into this map's own, so that it can be modified
+void MapBase::Separate()
+{
+	Store* s = &own;
+	s->pairs = store->pairs;
+	// the new store holds its own refs on the keys and values
+	for( iterator i = s->pairs.begin(); i != s->pairs.end(); ++i )
+	{
+		IncRef( const_cast<Object&>(i->first) );
+		IncRef( i->second );
+	}
+	store->refs--;
+	store = s;
+	// point the shape's slots at the new store's values
+	for( size_t i = 0; i < slots.size(); i++ )
+		slots[i] = &(s->pairs.find( shape->FieldName( i ) )->second);
+}
+
+// copy constructor (copies the bytes)
+BufferBase::BufferBase( const BufferBase & b ) : bytes( NULL ), length( b.length ), owner( NULL )
+{
+	if( length )
+	{
+		bytes = new unsigned char[length];
+		memcpy( bytes, b.bytes, length );
 	}
 }
 
+// create with 'n' zero bytes
+BufferBase::BufferBase( size_t n ) : bytes( NULL ), length( n ), owner( NULL )
+{
+	if( length )
+	{
+		bytes = new unsigned char[length];
+		memset( bytes, 0, length );
+	}
+}
+
+// 'slice constructor': a view sharing the bytes of 'b' (or of its owner, if
+// 'b' is itself a view), keeping the owning buffer alive
+BufferBase::BufferBase( BufferBase & b, size_t start, size_t end ) : bytes( b.bytes + start ), length( end - start ), owner( b.owner )
+{
+	// (buffers are only created via Buffer::Create(), so 'b' is a Buffer)
+	if( !owner )
+		owner = static_cast<Buffer*>( &b );
+	owner->IncRef();
+}
+
+BufferBase::~BufferBase()
+{
+	if( owner )
+		owner->DecRef();
+	else
+		delete [] bytes;
+}
+
+// compare contents
+int BufferBase::Compare( const BufferBase & b ) const
+{
+	size_t n = length < b.length ? length : b.length;
+	int ret = n ? memcmp( bytes, b.bytes, n ) : 0;
+	if( ret != 0 )
+		return ret;
+	if( length == b.length )
+		return 0;
+	return length < b.length ? -1 : 1;
+}
+
 // dec ref this object's children
 // for use when destroying an object
 void DecRefChildren( Object & o )
 {
 	if( IsVecType( o.type ) )
 	{
-		// walk the vector's contents
-		for( size_t i = 0; i < o.v->size(); i++ )
-		{
-			Object obj = o.v->operator[]( i );
-			DecRef( obj );
-		}
+		// (the vector's store holds the refs)
+		o.v->ReleaseItems();
 	}
 	else if( IsMapType( o.type ) )
 	{
@@ -174,8 +395,12 @@ int DecRef( Object & o )
 			if( o.type == obj_instance )
 				ex->CallDestructors( o );
 
-			// release its refs on its contents
-			DecRefChildren( o );
+			// release its refs on its contents (unless it shares them with a
+			// copy, which keeps them)
+			if( o.m->IsShared() )
+				o.m->Unshare();
+			else
+				DecRefChildren( o );
 		}
 #ifdef DEBUG
 		if( reftrace )
@@ -186,6 +411,24 @@ int DecRef( Object & o )
 			o.m = NULL;
 		return ret;
 	}
+	else if( o.type == obj_buffer )
+	{
+		if( !o.buf )
+			return 0;
+		int ret = o.buf->DecRef();
+		if( ret == 0 )
+			o.buf = NULL;
+		return ret;
+	}
+	else if( o.type == obj_stringbuilder )
+	{
+		if( !o.sb )
+			return 0;
+		int ret = o.sb->DecRef();
+		if( ret == 0 )
+			o.sb = NULL;
+		return ret;
+	}
 	// non-ref-type
 	return 0;
 }
@@ -200,7 +443,7 @@ bool Object::operator == ( const Object& rhs ) const
 	case obj_null:
 		return true;
 	case obj_number:
-		if( d == rhs.d )
+		if( NumEqual( *this, rhs ) )
 			return true;
 		break;
 	case obj_string:
@@ -249,6 +492,14 @@ bool Object::operator == ( const Object& rhs ) const
 		if( nm == rhs.nm )
 			return true;
 		break;
+	case obj_buffer:
+		if( buf->Compare( *rhs.buf ) == 0 )
+			return true;
+		break;
+	case obj_stringbuilder:
+		if( sb == rhs.sb )
+			return true;
+		break;
 	default:
 		// ???
 		break;
@@ -268,7 +519,7 @@ bool Object::operator < ( const Object & rhs ) const
 		case obj_null:
 			return false;
 		case obj_number:
-			return d < rhs.d;
+			return NumLess( *this, rhs );
 		case obj_symbol_name:
 		case obj_string:
 			return strcmp( s, rhs.s ) < 0;
@@ -292,6 +543,10 @@ bool Object::operator < ( const Object & rhs ) const
 			return mod < rhs.mod;
 		case obj_native_module:
 			return nm < rhs.nm;
+		case obj_buffer:
+			return buf->Compare( *rhs.buf ) < 0;
+		case obj_stringbuilder:
+			return sb < rhs.sb;
 		case obj_end:
 			throw ICE( "Invalid object type (obj_end) in Object::operator <." );
 		default:
@@ -307,7 +562,7 @@ bool Object::CoerceToBool()
 	switch( type )
 	{
 	case obj_number:
-		if( d != 0 )
+		if( IsInt() ? (int64_t)i != 0 : d != 0 )
 			return true;
 		break;
 	case obj_boolean:
@@ -318,7 +573,7 @@ bool Object::CoerceToBool()
 			return true;
 		break;
 	case obj_native_function:
-		if( nf.p != (void*)0 )
+		if( (NativeFunctionPtr)nf.p != NULL )
 			return true;
 		break;
 	case obj_size:
@@ -329,6 +584,10 @@ bool Object::CoerceToBool()
 		if( strlen( s ) > 0 )
 			return true;
 		break;
+	case obj_buffer:
+		return !buf->empty();
+	case obj_stringbuilder:
+		return !sb->empty();
 	case obj_vector:
 	case obj_map:
 	case obj_instance:
@@ -353,7 +612,7 @@ ostream & operator << ( ostream & os, const Object & obj )
 	switch( obj.type )
 	{
 		case obj_number:
-			os << obj.d;
+			os << obj.Num();
 			break;
 		case obj_string:
 			if( prettify_strings )
@@ -395,7 +654,7 @@ ostream & operator << ( ostream & os, const Object & obj )
 			os << "[";
 			for( size_t i = 0; i < obj.v->size(); i++ )
 			{
-				Object val = obj.v->at( i );
+				Object val = obj.v->Get( i );
 				prettify_strings = true;
 				os << val;
 				prettify_strings = false;
@@ -421,9 +680,9 @@ ostream & operator << ( ostream & os, const Object & obj )
 		case obj_native_function:
 			// TODO:
 			if( obj.nf.is_method )
-				os << "native method = " << (void*)obj.nf.p;
+				os << "native method = " << (void*)(NativeFunctionPtr)obj.nf.p;
 			else
-				os << "native function = " << (void*)obj.nf.p;
+				os << "native function = " << (void*)(NativeFunctionPtr)obj.nf.p;
 			break;
 		case obj_class:
 			os << "class: ";
@@ -467,6 +726,26 @@ ostream & operator << ( ostream & os, const Object & obj )
 		case obj_native_module:
 			os << "native module = " << (void*)obj.nm;
 			break;
+		case obj_buffer:
+			{
+			// dump the bytes
+			os << "buffer[";
+			for( size_t i = 0; i < obj.buf->size(); i++ )
+			{
+				os << (int)obj.buf->operator[]( i );
+				if( i+1 != obj.buf->size() )
+					os << ", ";
+			}
+			os << "]";
+			break;
+			}
+		case obj_stringbuilder:
+			// the string built so far
+			if( prettify_strings )
+				os << "'" << obj.sb->str() << "'";
+			else
+				os << obj.sb->str();
+			break;
 		default:
 			os << "ERROR: unknown type";
 	}
@@ -523,6 +802,12 @@ ostream & operator << ( ostream & os, ObjectType t )
 	case obj_native_module:
 		os << "native module";
 		break;
+	case obj_buffer:
+		os << "buffer";
+		break;
+	case obj_stringbuilder:
+		os << "string builder";
+		break;
 	case obj_end:
 	default:
 		os << "<invalid>";
@@ -155,9 +155,120 @@ const char* opcodeNames[] =
 	"rot4", 
 	"import",
 	"def_class",
+	"inline_guard",
+	"add_num",
+	"sub_num",
+	"mul_num",
+	"div_num",
+	"mod_num",
+	"lt_num",
+	"lte_num",
+	"gt_num",
+	"gte_num",
+	"for_range_init",
+	"for_range",
+	"wide",
 	"halt",
 	"breakpoint",
 	"illegal",
 };
 
+// number of operands of an instruction, or -1 if it isn't valid
+int OpcodeNumArgs( Opcode op )
+{
+	switch( op )
+	{
+	case op_push:
+	case op_pushlocal:
+	case op_pushconst:
+	case op_storeconst:
+	case op_store_true:
+	case op_store_false:
+	case op_store_null:
+	case op_storelocal:
+	case op_def_local:
+	case op_new_map:
+	case op_new_vec:
+	case op_new_class:
+	case op_jmp:
+	case op_jmpt:
+	case op_jmpf:
+	case op_add_assign:
+	case op_sub_assign:
+	case op_mul_assign:
+	case op_div_assign:
+	case op_mod_assign:
+	case op_add_assign_local:
+	case op_sub_assign_local:
+	case op_mul_assign_local:
+	case op_div_assign_local:
+	case op_mod_assign_local:
+	case op_call:
+	case op_call_method:
+	case op_return:
+	case op_for_iter:
+	case op_for_iter_pair:
+	case op_dup:
+	case op_rot:
+	case op_import:
+	case op_def_class:
+	case op_tbl_load:
+	case op_tbl_store:
+		return 1;
+	case op_exit_loop:
+	case op_inline_guard:
+	case op_for_range:
+		return 2;
+	case op_def_function:
+	case op_for_range_init:
+		return 3;
+	case op_def_method:
+		return 4;
+	case op_wide:
+		return -1;
+	default:
+		return op <= op_halt ? 0 : -1;
+	}
+}
+
+// index of the operand holding a code address, or -1 if there isn't one
+int OpcodeAddressArg( Opcode op )
+{
+	switch( op )
+	{
+	case op_jmp:
+	case op_jmpt:
+	case op_jmpf:
+	case op_for_iter:
+	case op_for_iter_pair:
+	case op_exit_loop:
+		return 0;
+	case op_inline_guard:
+	case op_for_range:
+		return 1;
+	case op_def_function:
+	case op_for_range_init:
+		return 2;
+	case op_def_method:
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+size_t InstructionSize( const byte* p, size_t len )
+{
+	if( len == 0 )
+		return 0;
+	bool wide = (Opcode)p[0] == op_wide;
+	if( wide && len < 2 )
+		return 0;
+	Opcode op = (Opcode)p[wide ? 1 : 0];
+	int num_args = OpcodeNumArgs( op );
+	if( num_args < 0 )
+		return 0;
+	size_t sz = wide ? 2 + num_args * sizeof( dword ) : 1 + num_args;
+	return sz <= len ? sz : 0;
+}
+
 } // namespace deva
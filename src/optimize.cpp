@@ -0,0 +1,1262 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// optimize.cpp
+// byte-code optimizer for the deva language: inlining, constant folding,
+// dead-code elimination and numeric op specialization over a compiled
+// instruction stream
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#include "compile.h"
+#include "number.h"
+#include "util.h"
+
+#include <climits>
+#include <algorithm>
+
+namespace deva_compile
+{
+
+// the largest function body (in instructions) that is inlined
+static const int max_inline_instrs = 16;
+
+// one decoded instruction. jump targets are kept as instruction indices while
+// optimizing, and turned back into addresses when the stream is re-encoded
+struct Instr
+{
+	Opcode op;
+	dword args[4];
+	int num_args;
+	// original address
+	dword addr;
+	// index of the instruction an address operand refers to, or -1
+	int target;
+	// folded away (reachable code now done by an earlier instruction)
+	bool folded;
+	// unreachable
+	bool dead;
+	// added by the optimizer (inlined code), 'addr' is meaningless
+	bool inserted;
+	// for inserted code, the line it belongs to from here on, or 0 if it
+	// belongs to the line before it
+	dword line;
+
+	inline bool Removed() const { return folded || dead; }
+	inline dword Size() const { return (dword)(sizeof( byte ) + num_args * sizeof( dword )); }
+};
+
+// does control flow never fall through to the next instruction?
+static bool EndsFlow( Opcode op )
+{
+	return op == op_jmp || op == op_exit_loop || op == op_return || op == op_halt;
+}
+
+// first instruction at or after 'i' that is still in the stream
+static int Live( const vector<Instr> & instrs, int i )
+{
+	while( i < (int)instrs.size() && instrs[i].Removed() )
+		i++;
+	return i;
+}
+
+// get the value an instruction pushes, if it pushes a constant number,
+// string, boolean or null
+bool Compiler::ConstantValue( const Instr & in, Object & o )
+{
+	switch( in.op )
+	{
+	case op_push:
+		o = Object( (int64_t)(int)in.args[0] );
+		return true;
+	case op_push_zero:
+		o = Object( (int64_t)0 );
+		return true;
+	case op_push_one:
+		o = Object( (int64_t)1 );
+		return true;
+	case op_push_true:
+		o = Object( true );
+		return true;
+	case op_push_false:
+		o = Object( false );
+		return true;
+	case op_push_null:
+		o = Object( obj_null );
+		return true;
+	case op_pushconst:
+		// (symbol names are variables, not constants)
+		o = ex->GetConstant( code, (int)in.args[0] );
+		return o.type == obj_number || o.type == obj_string;
+	default:
+		return false;
+	}
+}
+
+// turn an instruction into one that pushes the constant 'o'. returns false
+// if there is no way to push it
+bool Compiler::MakeConstantPush( Instr & in, const Object & o )
+{
+	in.num_args = 0;
+	in.target = -1;
+	switch( o.type )
+	{
+	case obj_boolean:
+		in.op = o.b ? op_push_true : op_push_false;
+		return true;
+	case obj_null:
+		in.op = op_push_null;
+		return true;
+	case obj_number:
+		if( o.IsInt() )
+		{
+			int64_t i = o.i;
+			if( i == 0 )
+				in.op = op_push_zero;
+			else if( i == 1 )
+				in.op = op_push_one;
+			else if( i >= INT_MIN && i <= INT_MAX )
+			{
+				in.op = op_push;
+				in.args[0] = (dword)(int)i;
+				in.num_args = 1;
+			}
+			else
+				break;
+			return true;
+		}
+		break;
+	case obj_string:
+		{
+		char* s = dupstr( o.s );
+		if( !code->AddConstant( Object( s ) ) )
+			freestr( s );
+		int idx = GetConstant( Object( o.s ) );
+		if( idx == INT_MIN )
+			return false;
+		in.op = op_pushconst;
+		in.args[0] = (dword)idx;
+		in.num_args = 1;
+		return true;
+		}
+	default:
+		return false;
+	}
+
+	// non-integral (or huge) numbers go in the constant pool. the pool
+	// considers numerically equal numbers the same constant, so NaN and
+	// negative zero (which would find the wrong constant) aren't folded.
+	// (tested on the bits, -ffast-math removes the 'd != d' kind of test)
+	double d = o.Num();
+	if( IsNaN( d ) || IsNegativeZero( d ) )
+		return false;
+	code->AddConstant( o );
+	int idx = GetConstant( o );
+	if( idx == INT_MIN )
+		return false;
+	in.op = op_pushconst;
+	in.args[0] = (dword)idx;
+	in.num_args = 1;
+	return true;
+}
+
+// an instruction made by the optimizer
+static Instr NewInstr( Opcode op, int num_args = 0, dword arg = 0 )
+{
+	Instr in;
+	in.op = op;
+	in.num_args = num_args;
+	in.args[0] = arg;
+	in.addr = (dword)-1;
+	in.target = -1;
+	in.folded = false;
+	in.dead = false;
+	in.inserted = true;
+	in.line = 0;
+	return in;
+}
+
+// the local a local-variable instruction refers to, or -1 if it isn't one
+static int LocalArg( const Instr & in )
+{
+	if( in.op >= op_pushlocal0 && in.op <= op_pushlocal9 )
+		return in.op - op_pushlocal0;
+	if( in.op >= op_storelocal0 && in.op <= op_storelocal9 )
+		return in.op - op_storelocal0;
+	switch( in.op )
+	{
+	case op_pushlocal:
+	case op_storelocal:
+	case op_add_assign_local:
+	case op_sub_assign_local:
+	case op_mul_assign_local:
+	case op_div_assign_local:
+	case op_mod_assign_local:
+		return (int)in.args[0];
+	default:
+		return -1;
+	}
+}
+
+// can an instruction be part of an inlined function body?
+static bool InlinableOp( Opcode op )
+{
+	if( (op >= op_pushlocal0 && op <= op_pushlocal9) || (op >= op_storelocal0 && op <= op_storelocal9) )
+		return true;
+	switch( op )
+	{
+	case op_nop:
+	case op_pop:
+	case op_push:
+	case op_push_true:
+	case op_push_false:
+	case op_push_null:
+	case op_push_zero:
+	case op_push_one:
+	case op_push0:
+	case op_push1:
+	case op_push2:
+	case op_push3:
+	case op_pushlocal:
+	case op_pushconst:
+	case op_storelocal:
+	case op_new_map:
+	case op_new_vec:
+	case op_eq:
+	case op_neq:
+	case op_lt:
+	case op_lte:
+	case op_gt:
+	case op_gte:
+	case op_or:
+	case op_and:
+	case op_neg:
+	case op_not:
+	case op_add:
+	case op_sub:
+	case op_mul:
+	case op_div:
+	case op_mod:
+	case op_add_assign_local:
+	case op_sub_assign_local:
+	case op_mul_assign_local:
+	case op_div_assign_local:
+	case op_mod_assign_local:
+	case op_inc:
+	case op_dec:
+	case op_tbl_load:
+	case op_loadslice2:
+	case op_loadslice3:
+	case op_dup:
+	case op_dup1:
+	case op_dup2:
+	case op_dup3:
+	case op_swap:
+	case op_rot:
+	case op_rot2:
+	case op_rot3:
+	case op_rot4:
+		return true;
+	// anything that jumps, defines things, makes calls (the callee would see
+	// the caller's scopes rather than the inlined function's) or stores to
+	// names (which could mean a different variable in the caller)
+	default:
+		return false;
+	}
+}
+
+// find the extent of each function's body (the def_function is followed by a
+// jump over the body) and the function each instruction belongs to (the
+// innermost one, "@main" for top-level code). returns false if the code
+// doesn't look as expected
+bool Compiler::FunctionExtents( const vector<Instr> & instrs, map<Function*, pair<int, int> > & extents, vector<Function*> & owner )
+{
+	Function* main_fcn = NULL;
+	for( size_t i = 0; i < functions.size(); i++ )
+	{
+		Function* f = functions[i];
+		if( f->name == "@main" )
+		{
+			main_fcn = f;
+			continue;
+		}
+		int start = -1;
+		for( size_t j = 0; j < instrs.size(); j++ )
+		{
+			if( !instrs[j].inserted && instrs[j].addr == f->addr )
+			{
+				start = (int)j;
+				break;
+			}
+		}
+		// (the jump over the body is never removed, but its target and the
+		// first instruction of the body may have been)
+		int jump = start - 1;
+		while( jump >= 0 && instrs[jump].Removed() )
+			jump--;
+		if( start < 1 || jump < 0 || instrs[jump].op != op_jmp )
+			return false;
+		start = Live( instrs, start );
+		int end = Live( instrs, instrs[jump].target );
+		if( end < start )
+			return false;
+		extents[f] = make_pair( start, end );
+	}
+	if( !main_fcn )
+		return false;
+
+	owner.assign( instrs.size(), main_fcn );
+	for( map<Function*, pair<int, int> >::iterator i = extents.begin(); i != extents.end(); ++i )
+	{
+		for( int j = i->second.first; j < i->second.second; j++ )
+		{
+			if( owner[j] == main_fcn || extents[owner[j]].first < i->second.first )
+				owner[j] = i->first;
+		}
+	}
+	return true;
+}
+
+// inline calls to small functions. candidates are non-method functions
+// defined once in this module, whose body is straight-line code that only
+// uses its arguments, and that make no calls (so they're never recursive).
+// a call 'pushconst <name>; call <n>' with all the arguments passed becomes:
+//
+//		inline_guard <name>, slow
+//		storelocal <arg n-1> ... storelocal <arg 0>
+//		<body up to its return, without its 'enter' and with its locals
+//		moved to new locals of the caller>
+//		(set the new locals to null)
+//		jmp done
+//	slow:
+//		pushconst <name>
+//		call <n>
+//	done:
+//
+// the guard checks that the name is still bound to the function at
+// run-time, and makes the call as before if it isn't. the inlined body keeps
+// the function's line numbers (errors in it are reported at them)
+void Compiler::InlineCalls( vector<Instr> & instrs )
+{
+	map<Function*, pair<int, int> > extents;
+	vector<Function*> owner;
+	if( !FunctionExtents( instrs, extents, owner ) )
+		return;
+	map<string, int> name_count;
+	for( map<Function*, pair<int, int> >::iterator i = extents.begin(); i != extents.end(); ++i )
+		name_count[i->first->name]++;
+
+	// the functions that can be inlined, and the names they use
+	map<string, Function*> candidates;
+	map<Function*, vector<string> > names;
+	for( map<Function*, pair<int, int> >::iterator i = extents.begin(); i != extents.end(); ++i )
+	{
+		Function* f = i->first;
+		if( f->IsMethod() || f->name[0] == '@' || name_count[f->name] != 1 || f->local_names.size() != f->num_args )
+			continue;
+		// the body block's 'enter' is skipped when inlining, the body can't
+		// define any names for it to hold
+		bool ok = false;
+		dword enters = 0;
+		vector<string> used;
+		for( int j = i->second.first; j < i->second.second && j - i->second.first <= max_inline_instrs; j++ )
+		{
+			const Instr & in = instrs[j];
+			if( in.op == op_enter && j == i->second.first + (int)enters )
+			{
+				enters++;
+				continue;
+			}
+			if( in.op == op_return )
+			{
+				ok = (in.args[0] == enters);
+				break;
+			}
+			if( !InlinableOp( in.op ) )
+				break;
+			int local = LocalArg( in );
+			if( local != -1 && local >= (int)f->num_args )
+				break;
+			if( in.op == op_pushconst )
+			{
+				Object o = ex->GetConstant( code, (int)in.args[0] );
+				if( o.type == obj_symbol_name )
+					used.push_back( string( o.s ) );
+			}
+		}
+		if( ok )
+		{
+			candidates[f->name] = f;
+			names[f] = used;
+		}
+	}
+	if( candidates.empty() )
+		return;
+
+	// instructions that are jumped to
+	vector<bool> is_target( instrs.size() + 1, false );
+	for( size_t i = 0; i < instrs.size(); i++ )
+	{
+		if( instrs[i].target != -1 )
+			is_target[instrs[i].target] = true;
+	}
+
+	// the new locals for each function inlined into each caller
+	map<pair<Function*, Function*>, dword> bases;
+
+	vector<Instr> out;
+	out.reserve( instrs.size() );
+	vector<int> remap( instrs.size() + 1, -1 );
+	for( size_t i = 0; i < instrs.size(); i++ )
+	{
+		remap[i] = (int)out.size();
+		const Instr & in = instrs[i];
+		Function* f = NULL;
+		Function* caller = owner[i];
+		if( in.op == op_pushconst && i + 1 < instrs.size() && instrs[i+1].op == op_call && !is_target[i+1] && !caller->IsMethod() )
+		{
+			Object o = ex->GetConstant( code, (int)in.args[0] );
+			if( o.type == obj_symbol_name && candidates.count( string( o.s ) ) != 0 )
+			{
+				f = candidates[string( o.s )];
+				// (the function's body must come first, so that its lines
+				// keep the addresses in its own body)
+				if( instrs[i+1].args[0] != f->num_args || f == caller || extents[f].first > (int)i )
+					f = NULL;
+			}
+			// the names the function uses must not be the caller's locals
+			for( size_t j = 0; f && j < names[f].size(); j++ )
+			{
+				if( find( caller->local_names.begin(), caller->local_names.end(), names[f][j] ) != caller->local_names.end() )
+					f = NULL;
+			}
+		}
+		if( !f )
+		{
+			out.push_back( in );
+			out.back().inserted = false;
+			continue;
+		}
+
+		pair<Function*, Function*> key( caller, f );
+		if( bases.count( key ) == 0 )
+		{
+			bases[key] = (dword)caller->local_names.size();
+			for( size_t j = 0; j < f->local_names.size(); j++ )
+				caller->local_names.push_back( string( "@" ) + f->name + "." + f->local_names[j] );
+		}
+		dword base = bases[key];
+
+		// the guard takes the place of the 'pushconst'
+		size_t guard = out.size();
+		out.push_back( in );
+		out.back().op = op_inline_guard;
+		out.back().num_args = 2;
+		out.back().inserted = false;
+		// the arguments
+		for( dword j = f->num_args; j > 0; j-- )
+			out.push_back( NewInstr( op_storelocal, 1, base + j - 1 ) );
+		// the body, which is reported as the lines of the function
+		dword line = 0;
+		for( int j = extents[f].first; instrs[j].op != op_return; j++ )
+		{
+			if( instrs[j].op == op_enter )
+				continue;
+			Instr b = instrs[j];
+			b.inserted = true;
+			b.addr = (dword)-1;
+			dword l = code->lines->FindLine( instrs[j].addr );
+			if( l != line )
+			{
+				b.line = l;
+				line = l;
+			}
+			int local = LocalArg( b );
+			if( local != -1 )
+			{
+				if( b.op >= op_pushlocal0 && b.op <= op_pushlocal9 )
+					b.op = op_pushlocal;
+				else if( b.op >= op_storelocal0 && b.op <= op_storelocal9 )
+					b.op = op_storelocal;
+				b.num_args = 1;
+				b.args[0] = base + (dword)local;
+			}
+			out.push_back( b );
+		}
+		// release the arguments, as leaving the function's frame would
+		size_t after = out.size();
+		for( dword j = 0; j < f->num_args; j++ )
+		{
+			out.push_back( NewInstr( op_push_null ) );
+			out.push_back( NewInstr( op_storelocal, 1, base + j ) );
+		}
+		size_t jump = out.size();
+		out.push_back( NewInstr( op_jmp, 1 ) );
+		// (back on the caller's line)
+		out[after].line = code->lines->FindLine( in.addr );
+		// the call, for when the guard fails
+		out[guard].target = (int)out.size();
+		out.push_back( NewInstr( op_pushconst, 1, in.args[0] ) );
+		remap[i+1] = (int)out.size();
+		out.push_back( instrs[i+1] );
+		out.back().inserted = false;
+		out[jump].target = (int)out.size();
+		i++;
+
+		f->inlined++;
+	}
+	remap[instrs.size()] = (int)out.size();
+
+	// jump targets of the original code
+	for( size_t i = 0; i < out.size(); i++ )
+	{
+		if( !out[i].inserted && out[i].target != -1 && out[i].op != op_inline_guard )
+			out[i].target = remap[out[i].target];
+	}
+	instrs.swap( out );
+}
+
+// the '_num' version of an arithmetic or comparison op, or op_illegal
+static Opcode NumericOp( Opcode op )
+{
+	switch( op )
+	{
+	case op_add: return op_add_num;
+	case op_sub: return op_sub_num;
+	case op_mul: return op_mul_num;
+	case op_div: return op_div_num;
+	case op_mod: return op_mod_num;
+	case op_lt: return op_lt_num;
+	case op_lte: return op_lte_num;
+	case op_gt: return op_gt_num;
+	case op_gte: return op_gte_num;
+	default: return op_illegal;
+	}
+}
+
+// is the symbol named by a 'pushconst' instruction 'name'?
+bool Compiler::PushesSymbol( const Instr & in, const char* name )
+{
+	if( in.op != op_pushconst )
+		return false;
+	Object o = ex->GetConstant( code, (int)in.args[0] );
+	return o.type == obj_symbol_name && strcmp( o.s, name ) == 0;
+}
+
+// pop the type of the tos off a simulated stack (an empty stack means the
+// types below are unknown)
+static bool PopNumber( vector<bool> & stack )
+{
+	if( stack.empty() )
+		return false;
+	bool b = stack.back();
+	stack.pop_back();
+	return b;
+}
+
+// use the '_num' ops where the operands are known to be numbers. this is a
+// simple local type inference: values are tracked on a simulated stack
+// through straight-line code (anything not modeled, and any jump target,
+// forgets what is on the stack), and a local is a number if every value
+// stored to it in its function is one. numbers come from literals,
+// arithmetic, 'length()' calls and the loop variable of 'for' loops over
+// 'range()'. arguments, and all locals of methods, are unknown.
+// none of this needs to be exact: the '_num' ops check their operands (a
+// local can be changed by name from a called function, 'length' or 'range'
+// can be re-defined) and do the same as the general ops if they aren't
+// numbers
+void Compiler::SpecializeNumericOps( vector<Instr> & instrs )
+{
+	map<Function*, pair<int, int> > extents;
+	vector<Function*> owner;
+	if( !FunctionExtents( instrs, extents, owner ) )
+		return;
+
+	vector<bool> is_target( instrs.size() + 1, false );
+	for( size_t i = 0; i < instrs.size(); i++ )
+	{
+		if( !instrs[i].Removed() && instrs[i].target != -1 )
+			is_target[Live( instrs, instrs[i].target )] = true;
+	}
+
+	// locals start out as numbers, until a store says otherwise
+	map<Function*, vector<bool> > num_locals;
+	for( size_t i = 0; i < functions.size(); i++ )
+	{
+		Function* f = functions[i];
+		vector<bool> & v = num_locals[f];
+		v.assign( f->local_names.size(), !f->IsMethod() );
+		for( size_t j = 0; j < v.size() && j < f->num_args; j++ )
+			v[j] = false;
+	}
+
+	// simulate until the local types are settled, then once more to re-write
+	// the ops
+	bool settled = false;
+	while( true )
+	{
+		bool rewrite = settled;
+		bool changed = false;
+		vector<bool> stack;
+		int prev = -1;
+		for( int i = Live( instrs, 0 ); i < (int)instrs.size(); prev = i, i = Live( instrs, i + 1 ) )
+		{
+			Instr & in = instrs[i];
+			vector<bool> & locals = num_locals[owner[i]];
+			if( is_target[i] || prev == -1 || owner[prev] != owner[i] || EndsFlow( instrs[prev].op ) )
+				stack.clear();
+
+			int local = LocalArg( in );
+			if( in.op >= op_def_local0 && in.op <= op_def_local9 )
+				local = in.op - op_def_local0;
+			else if( in.op == op_def_local )
+				local = (int)in.args[0];
+			bool known = local >= 0 && local < (int)locals.size();
+
+			switch( in.op )
+			{
+			case op_push:
+			case op_push_zero:
+			case op_push_one:
+				stack.push_back( true );
+				break;
+			case op_pushconst:
+				stack.push_back( ex->GetConstant( code, (int)in.args[0] ).type == obj_number );
+				break;
+			case op_push_true:
+			case op_push_false:
+			case op_push_null:
+				stack.push_back( false );
+				break;
+			case op_pushlocal:
+			case op_pushlocal0: case op_pushlocal1: case op_pushlocal2: case op_pushlocal3: case op_pushlocal4:
+			case op_pushlocal5: case op_pushlocal6: case op_pushlocal7: case op_pushlocal8: case op_pushlocal9:
+				stack.push_back( known && locals[local] );
+				break;
+			case op_storelocal:
+			case op_storelocal0: case op_storelocal1: case op_storelocal2: case op_storelocal3: case op_storelocal4:
+			case op_storelocal5: case op_storelocal6: case op_storelocal7: case op_storelocal8: case op_storelocal9:
+			case op_def_local:
+			case op_def_local0: case op_def_local1: case op_def_local2: case op_def_local3: case op_def_local4:
+			case op_def_local5: case op_def_local6: case op_def_local7: case op_def_local8: case op_def_local9:
+				if( !PopNumber( stack ) && known && locals[local] )
+				{
+					locals[local] = false;
+					changed = true;
+				}
+				break;
+			// (a number stays a number, or these fail)
+			case op_add_assign_local:
+			case op_sub_assign_local:
+			case op_mul_assign_local:
+			case op_div_assign_local:
+			case op_mod_assign_local:
+			case op_pop:
+			case op_jmpt:
+			case op_jmpf:
+			case op_storeconst:
+				PopNumber( stack );
+				break;
+			case op_neg:
+			case op_inc:
+			case op_dec:
+				PopNumber( stack );
+				stack.push_back( true );
+				break;
+			case op_not:
+				PopNumber( stack );
+				stack.push_back( false );
+				break;
+			case op_add:
+			case op_sub:
+			case op_mul:
+			case op_div:
+			case op_mod:
+			case op_lt:
+			case op_lte:
+			case op_gt:
+			case op_gte:
+				{
+				bool rhs = PopNumber( stack );
+				bool lhs = PopNumber( stack );
+				if( rewrite && lhs && rhs )
+					in.op = NumericOp( in.op );
+				// (add is also string concatenation, the comparisons are
+				// booleans, the rest are numbers or fail)
+				if( in.op == op_add || in.op == op_add_num )
+					stack.push_back( lhs && rhs );
+				else
+					stack.push_back( in.op == op_sub || in.op == op_mul || in.op == op_div || in.op == op_mod
+						|| in.op == op_sub_num || in.op == op_mul_num || in.op == op_div_num || in.op == op_mod_num );
+				}
+				break;
+			case op_eq:
+			case op_neq:
+			case op_or:
+			case op_and:
+				PopNumber( stack );
+				PopNumber( stack );
+				stack.push_back( false );
+				break;
+			case op_dup1:
+				{
+				bool b = stack.empty() ? false : stack.back();
+				stack.push_back( b );
+				}
+				break;
+			case op_swap:
+				{
+				bool a = PopNumber( stack );
+				bool b = PopNumber( stack );
+				stack.push_back( a );
+				stack.push_back( b );
+				}
+				break;
+			case op_call:
+				{
+				// the function and the args
+				for( dword j = 0; j <= in.args[0]; j++ )
+					PopNumber( stack );
+				stack.push_back( prev != -1 && in.args[0] == 1 && PushesSymbol( instrs[prev], "length" ) );
+				}
+				break;
+			case op_for_range:
+				// (a number, unless 'range' wasn't the builtin)
+				stack.clear();
+				stack.push_back( false );
+				stack.push_back( true );
+				break;
+			case op_for_iter:
+				{
+				// 'for( i in range( ... ) )' where a counting loop can't be
+				// used (see Compiler::RangeLoopInit()): the collection is made by a call to
+				// 'range' and then rewound (see Compiler::InOp())
+				static const Opcode prologue[] = { op_pop, op_call_method, op_method_load, op_pushconst, op_dup1, op_call };
+				static const size_t prologue_len = sizeof( prologue ) / sizeof( prologue[0] );
+				// (the loop branches back to the for_iter, so look at its
+				// code rather than the simulated stack)
+				bool range = true;
+				int j = i - 1;
+				for( size_t k = 0; range && k < prologue_len; k++, j-- )
+				{
+					while( j >= 0 && instrs[j].Removed() )
+						j--;
+					range = j >= 0 && instrs[j].op == prologue[k];
+				}
+				while( j >= 0 && instrs[j].Removed() )
+					j--;
+				range = range && j >= 0 && PushesSymbol( instrs[j], "range" );
+				stack.clear();
+				stack.push_back( false );
+				stack.push_back( range );
+				}
+				break;
+			default:
+				// not modeled: forget everything
+				stack.clear();
+				break;
+			}
+		}
+		if( rewrite )
+			break;
+		settled = !changed;
+	}
+}
+
+// evaluate a binary operator on constants, exactly as the executor would.
+// returns false if the operator doesn't apply to the operands (those errors
+// are left for run-time)
+static bool FoldBinary( Opcode op, const Object & lhs, const Object & rhs, Object & r, vector<char*> & strings )
+{
+	bool nums = lhs.type == obj_number && rhs.type == obj_number;
+	bool strs = lhs.type == obj_string && rhs.type == obj_string;
+	switch( op )
+	{
+	case op_add:
+		if( nums )
+			r = NumAdd( lhs, rhs );
+		else if( strs )
+		{
+			char* s = catstr( lhs.s, rhs.s );
+			strings.push_back( s );
+			r = Object( s );
+		}
+		else
+			return false;
+		return true;
+	case op_sub:
+		if( !nums ) return false;
+		r = NumSub( lhs, rhs );
+		return true;
+	case op_mul:
+		if( !nums ) return false;
+		r = NumMul( lhs, rhs );
+		return true;
+	case op_div:
+		if( !nums || rhs.Num() == 0.0 ) return false;
+		r = NumDiv( lhs, rhs );
+		return true;
+	case op_mod:
+		if( !nums || rhs.Num() == 0.0 || !IsIntegral( lhs ) || !IsIntegral( rhs ) ) return false;
+		r = NumMod( lhs, rhs );
+		return true;
+	case op_eq:
+	case op_neq:
+		{
+		bool eq;
+		if( lhs.type != rhs.type )
+		{
+			// (the executor's neq doesn't check the types first)
+			if( op == op_neq ) return false;
+			eq = false;
+		}
+		else if( nums )
+			eq = NumEqual( lhs, rhs );
+		else if( strs )
+			eq = eqstr( lhs.s, rhs.s );
+		else if( lhs.type == obj_boolean )
+			eq = (lhs.b != 0) == (rhs.b != 0);
+		else if( lhs.type == obj_null )
+			eq = true;
+		else
+			return false;
+		r = Object( op == op_eq ? eq : !eq );
+		return true;
+		}
+	case op_lt:
+	case op_lte:
+	case op_gt:
+	case op_gte:
+		if( nums )
+		{
+			if( op == op_lt ) r = Object( NumLess( lhs, rhs ) );
+			else if( op == op_lte ) r = Object( NumLessEqual( lhs, rhs ) );
+			else if( op == op_gt ) r = Object( NumLess( rhs, lhs ) );
+			else r = Object( NumLessEqual( rhs, lhs ) );
+		}
+		else if( strs )
+		{
+			int c = cmpstr( lhs.s, rhs.s );
+			if( op == op_lt ) r = Object( c < 0 );
+			else if( op == op_lte ) r = Object( c <= 0 );
+			else if( op == op_gt ) r = Object( c > 0 );
+			else r = Object( c >= 0 );
+		}
+		else
+			return false;
+		return true;
+	case op_and:
+		r = Object( const_cast<Object&>( lhs ).CoerceToBool() && const_cast<Object&>( rhs ).CoerceToBool() );
+		return true;
+	case op_or:
+		r = Object( const_cast<Object&>( lhs ).CoerceToBool() || const_cast<Object&>( rhs ).CoerceToBool() );
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool IsBinaryOp( Opcode op )
+{
+	switch( op )
+	{
+	case op_add: case op_sub: case op_mul: case op_div: case op_mod:
+	case op_eq: case op_neq: case op_lt: case op_lte: case op_gt: case op_gte:
+	case op_and: case op_or:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// constant folding over one pass of the stream. returns true if anything changed
+bool Compiler::FoldConstants( vector<Instr> & instrs, const vector<bool> & is_target )
+{
+	bool changed = false;
+	vector<char*> strings;
+	// the live instructions of the current basic block, in order
+	vector<int> recent;
+	for( int i = 0; i < (int)instrs.size(); i++ )
+	{
+		Instr & in = instrs[i];
+		if( in.Removed() )
+			continue;
+		// a jump target starts a new basic block
+		if( is_target[i] )
+			recent.clear();
+
+		size_t n = recent.size();
+		Object lhs, rhs, r;
+		if( IsBinaryOp( in.op ) && n >= 2 && !is_target[recent[n-1]] 
+			&& ConstantValue( instrs[recent[n-2]], lhs ) && ConstantValue( instrs[recent[n-1]], rhs )
+			&& FoldBinary( in.op, lhs, rhs, r, strings ) && MakeConstantPush( instrs[recent[n-2]], r ) )
+		{
+			instrs[recent[n-1]].folded = true;
+			in.folded = true;
+			recent.pop_back();
+			changed = true;
+			continue;
+		}
+		if( (in.op == op_neg || in.op == op_not) && n >= 1 && ConstantValue( instrs[recent[n-1]], rhs ) )
+		{
+			bool ok = false;
+			if( in.op == op_not )
+				ok = MakeConstantPush( instrs[recent[n-1]], Object( !rhs.CoerceToBool() ) );
+			else if( rhs.type == obj_number )
+				ok = MakeConstantPush( instrs[recent[n-1]], NumNeg( rhs ) );
+			if( ok )
+			{
+				in.folded = true;
+				changed = true;
+				continue;
+			}
+		}
+		// conditional jump on a constant: either always jump, or never
+		if( (in.op == op_jmpf || in.op == op_jmpt) && n >= 1 && ConstantValue( instrs[recent[n-1]], rhs ) )
+		{
+			Instr & c = instrs[recent[n-1]];
+			if( rhs.CoerceToBool() == (in.op == op_jmpt) )
+			{
+				c.op = op_jmp;
+				c.num_args = 1;
+				c.target = in.target;
+			}
+			else
+				c.folded = true;
+			in.folded = true;
+			changed = true;
+			recent.clear();
+			continue;
+		}
+
+		if( in.target != -1 || EndsFlow( in.op ) )
+			recent.clear();
+		else
+			recent.push_back( i );
+	}
+	for( size_t i = 0; i < strings.size(); i++ )
+		freestr( strings[i] );
+	return changed;
+}
+
+// decode a stream of instructions (with dword operands), with the index of
+// the instruction at each address (the end of the stream included) and the
+// targets of their address operands. returns false if it can't be decoded
+static bool DecodeStream( const byte* bytes, size_t len, vector<Instr> & instrs, vector<int> & index )
+{
+	index.assign( len + 1, -1 );
+	for( size_t a = 0; a < len; )
+	{
+		Instr in;
+		in.op = (Opcode)bytes[a];
+		in.num_args = OpcodeNumArgs( in.op );
+		if( in.num_args < 0 || a + 1 + in.num_args * sizeof( dword ) > len )
+			return false;
+		for( int j = 0; j < in.num_args; j++ )
+			in.args[j] = *((dword*)(bytes + a + 1 + j * sizeof( dword )));
+		in.addr = (dword)a;
+		in.target = -1;
+		in.folded = false;
+		in.dead = false;
+		in.inserted = false;
+		in.line = 0;
+		index[a] = (int)instrs.size();
+		instrs.push_back( in );
+		a += in.Size();
+	}
+	index[len] = (int)instrs.size();
+	for( size_t i = 0; i < instrs.size(); i++ )
+	{
+		int arg = OpcodeAddressArg( instrs[i].op );
+		if( arg == -1 )
+			continue;
+		dword addr = instrs[i].args[arg];
+		if( addr > len || index[addr] == -1 )
+			return false;
+		instrs[i].target = index[addr];
+	}
+	return true;
+}
+
+// constant folding and dead-code elimination. the instruction stream is
+// decoded, optimized and re-encoded, with jump targets, function addresses
+// and the line map adjusted to match
+void Compiler::Optimize()
+{
+	vector<Instr> instrs;
+	size_t len = is->Length();
+	vector<int> index;
+	// (don't touch code we don't understand)
+	if( !DecodeStream( is->Bytes(), len, instrs, index ) )
+		return;
+
+	// inline calls to small functions (not in interactive code, which may run
+	// in another module's frame)
+	if( !interactive )
+	{
+		InlineCalls( instrs );
+		index.assign( len + 1, -1 );
+		for( size_t i = 0; i < instrs.size(); i++ )
+		{
+			if( !instrs[i].inserted )
+				index[instrs[i].addr] = (int)i;
+		}
+		index[len] = (int)instrs.size();
+	}
+
+	// functions are entered at their addresses
+	vector<int> roots;
+	roots.push_back( 0 );
+	for( size_t i = 0; i < functions.size(); i++ )
+	{
+		if( functions[i]->addr > len || index[functions[i]->addr] == -1 )
+			return;
+		roots.push_back( index[functions[i]->addr] );
+	}
+
+	bool changed = true;
+	while( changed )
+	{
+		changed = false;
+
+		// jump targets (removed instructions pass their incoming jumps on)
+		vector<bool> is_target( instrs.size() + 1, false );
+		for( size_t i = 0; i < instrs.size(); i++ )
+		{
+			if( !instrs[i].Removed() && instrs[i].target != -1 )
+				is_target[Live( instrs, instrs[i].target )] = true;
+		}
+		if( FoldConstants( instrs, is_target ) )
+			changed = true;
+
+		// reachability
+		vector<bool> reached( instrs.size() + 1, false );
+		vector<int> work;
+		for( size_t i = 0; i < roots.size(); i++ )
+			work.push_back( Live( instrs, roots[i] ) );
+		while( !work.empty() )
+		{
+			int i = work.back();
+			work.pop_back();
+			while( i < (int)instrs.size() && !reached[i] )
+			{
+				reached[i] = true;
+				const Instr & in = instrs[i];
+				if( in.target != -1 )
+					work.push_back( Live( instrs, in.target ) );
+				if( EndsFlow( in.op ) )
+					break;
+				i = Live( instrs, i + 1 );
+			}
+		}
+		for( size_t i = 0; i < instrs.size(); i++ )
+		{
+			Instr & in = instrs[i];
+			if( in.Removed() )
+				continue;
+			if( !reached[i] )
+			{
+				in.dead = true;
+				changed = true;
+			}
+			// jumps to the next instruction
+			else if( in.target != -1 && Live( instrs, in.target ) == Live( instrs, (int)i + 1 ) )
+			{
+				if( in.op == op_jmp )
+				{
+					in.folded = true;
+					changed = true;
+				}
+				else if( in.op == op_jmpf || in.op == op_jmpt )
+				{
+					// (the condition still has to come off the stack)
+					in.op = op_pop;
+					in.num_args = 0;
+					in.target = -1;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	// use the numeric ops where the operands are known to be numbers
+	if( !interactive )
+		SpecializeNumericOps( instrs );
+
+	// re-encode
+	vector<dword> new_addr( instrs.size() + 1, 0 );
+	dword a = 0;
+	for( size_t i = 0; i < instrs.size(); i++ )
+	{
+		new_addr[i] = a;
+		if( !instrs[i].Removed() )
+			a += instrs[i].Size();
+	}
+	new_addr[instrs.size()] = a;
+	InstructionStream* stream = new InstructionStream( a + 1 );
+	for( size_t i = 0; i < instrs.size(); i++ )
+	{
+		Instr & in = instrs[i];
+		if( in.Removed() )
+			continue;
+		int arg = OpcodeAddressArg( in.op );
+		if( arg != -1 )
+			in.args[arg] = new_addr[Live( instrs, in.target )];
+		stream->Append( (byte)in.op );
+		for( int j = 0; j < in.num_args; j++ )
+			stream->Append( in.args[j] );
+	}
+	delete[] (byte*)is->Bytes();
+	delete is;
+	is = stream;
+
+	for( size_t i = 0; i < functions.size(); i++ )
+		functions[i]->addr = new_addr[Live( instrs, roots[i + 1] )];
+
+	// the line map: lines whose code was removed move to the next instruction
+	// (a breakpoint on them stops there), lines whose code was all dead are
+	// dropped. lines whose code is still there are added first, so that an
+	// address is reported as the line it really belongs to
+	LineMap* lines = new LineMap();
+	for( int moved = 0; moved < 2; moved++ )
+	{
+		// inlined code is reported as the lines of the function it came from
+		// (after the lines whose code is there, before the lines moved to it)
+		for( size_t k = 0; moved == 1 && k < instrs.size(); k++ )
+		{
+			if( !instrs[k].inserted || instrs[k].line == 0 || instrs[k].dead )
+				continue;
+			int n = Live( instrs, (int)k );
+			if( n < (int)instrs.size() && instrs[n].inserted )
+				lines->AddEntry( new_addr[n], instrs[k].line );
+		}
+		for( LineMap::iterator i = code->lines->L2ABegin(); i != code->lines->L2AEnd(); ++i )
+		{
+			if( i->second > len || index[i->second] == -1 )
+				continue;
+			int k = index[i->second];
+			if( k == (int)instrs.size() )
+				continue;
+			if( instrs[k].Removed() != (moved != 0) || instrs[k].dead )
+				continue;
+			k = Live( instrs, k );
+			if( k < (int)instrs.size() )
+				lines->Add( i->first, new_addr[k] );
+		}
+	}
+	delete code->lines;
+	code->lines = lines;
+}
+
+// operand 'j' of an instruction in the compact form: addresses are relative
+// to the instruction
+static int CompactArg( const vector<Instr> & instrs, const vector<dword> & new_addr, size_t i, int j )
+{
+	const Instr & in = instrs[i];
+	if( j == OpcodeAddressArg( in.op ) )
+		return (int)(new_addr[in.target] - new_addr[i]);
+	return (int)in.args[j];
+}
+
+// re-encode the instruction stream in the compact form the executor runs
+// (see opcodes.h), with the function addresses and the line map moved to
+// match. making an instruction wide can move a jump over it out of range of a
+// byte, so the layout is repeated until no more instructions need to be wide
+void Compiler::Compact()
+{
+	vector<Instr> instrs;
+	size_t len = is->Length();
+	vector<int> index;
+	if( !DecodeStream( is->Bytes(), len, instrs, index ) )
+		throw ICE( "Invalid instruction stream." );
+
+	vector<bool> wide( instrs.size(), false );
+	vector<dword> new_addr( instrs.size() + 1, 0 );
+	bool changed = true;
+	while( changed )
+	{
+		changed = false;
+		dword a = 0;
+		for( size_t i = 0; i < instrs.size(); i++ )
+		{
+			new_addr[i] = a;
+			if( wide[i] )
+				a += (dword)(2 + instrs[i].num_args * sizeof( dword ));
+			else
+				a += (dword)(1 + instrs[i].num_args);
+		}
+		new_addr[instrs.size()] = a;
+		for( size_t i = 0; i < instrs.size(); i++ )
+		{
+			for( int j = 0; j < instrs[i].num_args && !wide[i]; j++ )
+			{
+				int arg = CompactArg( instrs, new_addr, i, j );
+				if( arg < SCHAR_MIN || arg > SCHAR_MAX )
+				{
+					wide[i] = true;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	InstructionStream* stream = new InstructionStream( new_addr[instrs.size()] + 1 );
+	for( size_t i = 0; i < instrs.size(); i++ )
+	{
+		if( wide[i] )
+			stream->Append( (byte)op_wide );
+		stream->Append( (byte)instrs[i].op );
+		for( int j = 0; j < instrs[i].num_args; j++ )
+		{
+			int arg = CompactArg( instrs, new_addr, i, j );
+			if( wide[i] )
+				stream->Append( (dword)arg );
+			else
+				stream->Append( (byte)(signed char)arg );
+		}
+	}
+	delete[] (byte*)is->Bytes();
+	delete is;
+	is = stream;
+
+	for( size_t i = 0; i < functions.size(); i++ )
+	{
+		if( functions[i]->addr > len || index[functions[i]->addr] == -1 )
+			throw ICE( boost::format( "Invalid address for function '%1%'." ) % functions[i]->name );
+		functions[i]->addr = new_addr[index[functions[i]->addr]];
+	}
+
+	// (the address to line entries, in order, re-build the same map)
+	LineMap* lines = new LineMap();
+	for( LineMap::iterator i = code->lines->A2LBegin(); i != code->lines->A2LEnd(); ++i )
+	{
+		if( i->first <= len && index[i->first] != -1 )
+			lines->AddEntry( new_addr[index[i->first]], i->second );
+	}
+	delete code->lines;
+	code->lines = lines;
+}
+
+} // namespace deva_compile
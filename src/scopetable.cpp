@@ -62,9 +62,11 @@ void Scope::DeleteData()
 		if( o->type != obj_function )
 			*(o) = Object();
 	}
-	// clear the map & vector 'dead pools' (items to be deleted)
+	// clear the map, vector, buffer & string builder 'dead pools' (items to be deleted)
 	Map::ClearDeadPool();
 	Vector::ClearDeadPool();
+	Buffer::ClearDeadPool();
+	StringBuilder::ClearDeadPool();
 }
 
 Object* Scope::FindSymbol( const char* name ) const
@@ -33,9 +33,12 @@
 #include "semantics.h"
 #include "exceptions.h"
 #include "util.h"
+#include "number.h"
 #include "builtins.h"
 #include "vector_builtins.h"
 #include "map_builtins.h"
+#include "buffer_builtins.h"
+#include "stringbuilder_builtins.h"
 
 namespace deva_compile
 {
@@ -106,7 +109,7 @@ void Semantics::DefineVar( char* name, int line, VariableModifier mod /*= mod_no
 	// disallow defining builtins as non-locals... ???
 	if( mod == mod_none || mod == mod_external )
 	{
-		if( IsBuiltin( string( name ) ) || IsVectorBuiltin( string( name ) ) || IsMapBuiltin( string( name ) ) )
+		if( IsBuiltin( string( name ) ) || IsVectorBuiltin( string( name ) ) || IsMapBuiltin( string( name ) ) || IsBufferBuiltin( string( name ) ) || IsStringBuilderBuiltin( string( name ) ) )
 			return;
 	}
 
@@ -140,7 +143,7 @@ void Semantics::ResolveVar( char* name, int line )
 	else if( !current_scope->Resolve( name, sym_end ) )
 	{
 		// accept builtins
-		if( IsBuiltin( string( name ) ) || IsVectorBuiltin( string( name ) ) || IsMapBuiltin( string( name ) ) )
+		if( IsBuiltin( string( name ) ) || IsVectorBuiltin( string( name ) ) || IsMapBuiltin( string( name ) ) || IsBufferBuiltin( string( name ) ) || IsStringBuilderBuiltin( string( name ) ) )
 			return;
 
 		if( ignore_undefined_vars )
@@ -188,7 +191,7 @@ void Semantics::ResolveFun( char* name, int line )
 		return;
 
 	// if it is a builtin fcn, nothing to do
-	if( IsBuiltin( string( name ) ) || IsVectorBuiltin( string( name ) ) || IsMapBuiltin( string( name ) ) )
+	if( IsBuiltin( string( name ) ) || IsVectorBuiltin( string( name ) ) || IsMapBuiltin( string( name ) ) || IsBufferBuiltin( string( name ) ) || IsStringBuilderBuiltin( string( name ) ) )
 	{
 		return;
 	}
@@ -219,7 +222,8 @@ void Semantics::AddArg( char* arg, int line )
 // add number constant
 void Semantics::AddNumber( double arg )
 {
-	constants.insert( Object( arg ) );
+	// (integral constants use the integer representation)
+	constants.insert( NumberObject( arg ) );
 }
 
 // add string constant
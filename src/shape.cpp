@@ -0,0 +1,136 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// shape.cpp
+// shape ('hidden class') objects, describing the field layout of instances
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#include "shape.h"
+#include "util.h"
+
+
+using namespace std;
+
+
+namespace deva
+{
+
+
+// static member initialization
+Shape* Shape::root = NULL;
+
+// create the shape reached from 'parent' by adding field 'key'
+Shape::Shape( const Shape & parent, const Object & key ) :
+	fields( parent.fields ),
+	slot_map( parent.slot_map )
+{
+	// the shape's copy of the name
+	Object name( key );
+	name.s = dupstr( key.s );
+	slot_map.insert( make_pair( name, fields.size() ) );
+	fields.push_back( name );
+}
+
+Shape::~Shape()
+{
+	for( map<Object, Shape*, MapKeyLess>::iterator i = transitions.begin(); i != transitions.end(); ++i )
+		delete i->second;
+	// only the last field name belongs to this shape, the rest are owned by
+	// its ancestors
+	if( fields.size() > 0 )
+		freestr( fields.back().s );
+}
+
+Shape* Shape::Root()
+{
+	if( !root )
+		root = new Shape();
+	return root;
+}
+
+void Shape::FreeShapes()
+{
+	delete root;
+	root = NULL;
+}
+
+Shape* Shape::AddField( const Object & key )
+{
+	if( key.type != obj_string && key.type != obj_symbol_name )
+		return NULL;
+	if( fields.size() >= max_shape_fields )
+		return NULL;
+
+	map<Object, Shape*, MapKeyLess>::iterator i = transitions.find( key );
+	if( i != transitions.end() )
+		return i->second;
+
+	Shape* s = new Shape( *this, key );
+	// key the transition with the new shape's copy of the name
+	transitions.insert( make_pair( s->fields.back(), s ) );
+	return s;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MapBase shape handling
+/////////////////////////////////////////////////////////////////////////////
+
+// build a shape for this map from its current contents
+void MapBase::InitShape()
+{
+	MakeDictionary();
+	Shape* s = Shape::Root();
+	for( iterator i = begin(); i != end(); ++i )
+	{
+		s = s->AddField( i->first );
+		if( !s )
+		{
+			MakeDictionary();
+			return;
+		}
+		slots.push_back( &(i->second) );
+	}
+	shape = s;
+}
+
+// move to the shape for a newly inserted field, whose value is 'val'
+void MapBase::AddToShape( const Object & key, Object* val )
+{
+	if( !shape )
+		return;
+	Shape* s = shape->AddField( key );
+	if( !s )
+	{
+		MakeDictionary();
+		return;
+	}
+	shape = s;
+	slots.push_back( val );
+}
+
+
+} // namespace deva
@@ -31,6 +31,7 @@
 #include "string_builtins.h"
 #include "builtins_helpers.h"
 #include "util.h"
+#include "number.h"
 #include <algorithm>
 #include <locale>
 #include <sstream>
@@ -230,9 +231,9 @@ void do_string_length( Frame *frame )
 	Object* self = helper.GetLocalN( 0 );
 	helper.ExpectType( self, obj_string );
 
-	size_t len = strlen( self->s );
+	size_t len = strlength( self->s );
 	
-	helper.ReturnVal( Object( (double)len ) );
+	helper.ReturnVal( Object( (int64_t)len ) );
 }
 
 void do_string_copy( Frame *frame )
@@ -245,7 +246,7 @@ void do_string_copy( Frame *frame )
 
 	// copy the string
 	// (strings are immutable. create a copy and add it to the calling frame)
-	char* s = copystr( self->s );
+	char* s = dupstr( self->s );
 	frame->GetParent()->AddString( s );
 	
 	helper.ReturnVal( Object( s ) );
@@ -266,7 +267,7 @@ void do_string_insert( Frame *frame )
 	// insert the string
 	// (strings are immutable. create a copy and add it to the calling frame)
 	string s( self->s );
-	s.insert( (size_t)pos->d, po->s );
+	s.insert( (size_t)NumToInt( *pos ), po->s );
 	const char* ret = frame->GetParent()->AddString( s );
 	
 	helper.ReturnVal( Object( ret ) );
@@ -282,17 +283,17 @@ void do_string_remove( Frame *frame )
 	Object* startobj = helper.GetLocalN( 1 );
 	helper.ExpectPositiveIntegralNumber( startobj );
 
-	int start = (int)startobj->d;
+	int start = (int)NumToInt( *startobj );
 	// end arg defaults to -1 (same as end-of-string)
 	int end = -1;
 	if( frame->NumArgsPassed() == 3 )
 	{
 		Object* endobj = helper.GetLocalN( 2 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 
-	size_t sz = strlen( self->s );
+	size_t sz = strlength( self->s );
 	if( end == -1 )
 		end = (int)sz;
 
@@ -330,7 +331,7 @@ void do_string_find( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 2 );
 		helper.ExpectPositiveIntegralNumber( startobj );
-		start = (int)startobj->d;
+		start = (int)NumToInt( *startobj );
 	}
 
 	// substring length arg defaults to -1 (same as end-of-string)
@@ -339,11 +340,11 @@ void do_string_find( Frame *frame )
 	{
 		Object* lenobj = helper.GetLocalN( 3 );
 		helper.ExpectIntegralNumber( lenobj );
-		len = (int)lenobj->d;
+		len = (int)NumToInt( *lenobj );
 	}
 
-	size_t sz = strlen( self->s );
-	size_t sz_val = strlen( val->s );
+	size_t sz = strlength( self->s );
+	size_t sz_val = strlength( val->s );
 	// if a sub-string length wasn't passed, use the entire search string
 	if( len == -1 )
 		len = (int)sz_val;
@@ -367,7 +368,7 @@ void do_string_find( Frame *frame )
 			helper.ReturnVal( Object( obj_null ) );
 		else
 		{
-			helper.ReturnVal( Object( (double)fpos ) );
+			helper.ReturnVal( Object( (int64_t)fpos ) );
 		}
 	}
 }
@@ -390,7 +391,7 @@ void do_string_rfind( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 2 );
 		helper.ExpectIntegralNumber( startobj );
-		start = (long)startobj->d;
+		start = (long)NumToInt( *startobj );
 	}
 
 	// substring length arg defaults to -1 (same as end-of-string)
@@ -399,11 +400,11 @@ void do_string_rfind( Frame *frame )
 	{
 		Object* lenobj = helper.GetLocalN( 3 );
 		helper.ExpectIntegralNumber( lenobj );
-		len = (int)lenobj->d;
+		len = (int)NumToInt( *lenobj );
 	}
 
-	size_t sz = strlen( self->s );
-	size_t sz_val = strlen( val->s );
+	size_t sz = strlength( self->s );
+	size_t sz_val = strlength( val->s );
 	// convert a start val of '-1' into end-of-string
 	if( start == -1 )
 		start = (long)string::npos;
@@ -430,7 +431,7 @@ void do_string_rfind( Frame *frame )
 			helper.ReturnVal( Object( obj_null ) );
 		else
 		{
-			helper.ReturnVal( Object( (double)fpos ) );
+			helper.ReturnVal( Object( (int64_t)fpos ) );
 		}
 	}
 }
@@ -449,7 +450,7 @@ void do_string_reverse( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 1 );
 		helper.ExpectPositiveIntegralNumber( startobj );
-		start = (int)startobj->d;
+		start = (int)NumToInt( *startobj );
 	}
 
 	// end arg defaults to -1 (same as end-of-string)
@@ -458,10 +459,10 @@ void do_string_reverse( Frame *frame )
 	{
 		Object* endobj = helper.GetLocalN( 2 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 
-	size_t sz = strlen( self->s );
+	size_t sz = strlength( self->s );
 	if( end == -1 )
 		end = (int)sz;
 
@@ -495,7 +496,7 @@ void do_string_sort( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 1 );
 		helper.ExpectPositiveIntegralNumber( startobj );
-		start = (int)startobj->d;
+		start = (int)NumToInt( *startobj );
 	}
 
 	// end arg defaults to -1 (same as end-of-string)
@@ -504,10 +505,10 @@ void do_string_sort( Frame *frame )
 	{
 		Object* endobj = helper.GetLocalN( 2 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 
-	size_t sz = strlen( self->s );
+	size_t sz = strlength( self->s );
 	if( end == -1 )
 		end = (int)sz;
 
@@ -541,7 +542,7 @@ void do_string_slice( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 1 );
 		helper.ExpectPositiveIntegralNumber( startobj );
-		start = (int)startobj->d;
+		start = (int)NumToInt( *startobj );
 	}
 
 	// end arg defaults to -1 (same as end-of-string)
@@ -550,7 +551,7 @@ void do_string_slice( Frame *frame )
 	{
 		Object* endobj = helper.GetLocalN( 2 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 
 	// step arg defaults to 1
@@ -559,10 +560,10 @@ void do_string_slice( Frame *frame )
 	{
 		Object* stepobj = helper.GetLocalN( 3 );
 		helper.ExpectPositiveIntegralNumber( stepobj );
-		step = (int)stepobj->d;
+		step = (int)NumToInt( *stepobj );
 	}
 
-	size_t sz = strlen( self->s );
+	size_t sz = strlength( self->s );
 	if( end == -1 )
 		end = (int)sz;
 
@@ -570,31 +571,28 @@ void do_string_slice( Frame *frame )
 		throw RuntimeException( "Invalid 'start' argument in string built-in method 'slice'." );
 	if( (size_t)end > sz || end < 0 )
 		throw RuntimeException( "Invalid 'end' argument in string built-in method 'slice'." );
-	if( (size_t)step > sz )
+	if( step < 1 || (size_t)step > sz )
 		throw RuntimeException( "Invalid 'step' argument in string built-in method 'slice'." );
 	if( end < start )
 		throw RuntimeException( "Invalid arguments in string built-in method 'slice': start is greater than end." );
 
 	// slice the string
 	// (strings are immutable. create a copy and add it to the calling frame)
-	string s( self->s );
+	// (copying only the sliced characters, not the whole string)
 	if( step == 1 )
 	{
-		string r = s.substr( start, end - start );
+		string r( self->s + start, end - start );
 		const char* ret = frame->GetParent()->AddString( r );
 		helper.ReturnVal( Object( ret ) );
 	}
-	// otherwise the string class doesn't help us, have to do it manually
+	// otherwise walk it grabbing every 'nth' character
 	else
 	{
-		// first get the substring from start to end positions
-		string r = s.substr( start, end - start );
-		// TODO: call 'reserve' on the string to reduce allocations?
-		// then walk it grabbing every 'nth' character
 		string slice;
-		for( size_t i = 0; i < r.length(); i += step )
+		slice.reserve( (end - start + step - 1) / step );
+		for( int i = start; i < end; i += step )
 		{
-			slice += r[i];
+			slice += self->s[i];
 		}
 		const char* ret = frame->GetParent()->AddString( slice );
 		helper.ReturnVal( Object( ret ) );
@@ -809,7 +807,7 @@ void do_string_upper( Frame *frame )
 	// uppercase the string
 	// (strings are immutable. create a copy and add it to the calling frame)
 	string s;
-	s.reserve( strlen( self->s ) );
+	s.reserve( strlength( self->s ) );
 	locale loc;
 	int i = 0;
 	while( self->s[i] )
@@ -833,7 +831,7 @@ void do_string_lower( Frame *frame )
 	// lowercase the string
 	// (strings are immutable. create a copy and add it to the calling frame)
 	string s;
-	s.reserve( strlen( self->s ) );
+	s.reserve( strlength( self->s ) );
 	locale loc;
 	int i = 0;
 	while( self->s[i] )
@@ -0,0 +1,199 @@
+// Copyright (c) 2026 Joshua C. Shepard
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// stringbuilder_builtins.cpp
+// builtin string builder methods for the deva language
+// created by jcs, october 18, 2026
+
+// TODO:
+// * 
+
+#include "stringbuilder_builtins.h"
+#include "builtins_helpers.h"
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+
+namespace deva
+{
+
+
+const string stringbuilder_builtin_names[] = 
+{
+	string( "append" ),
+	string( "appendline" ),
+	string( "length" ),
+	string( "str" ),
+};
+NativeFunctionPtr stringbuilder_builtin_fcns[] = 
+{
+	do_stringbuilder_append,
+	do_stringbuilder_appendline,
+	do_stringbuilder_length,
+	do_stringbuilder_str,
+};
+Object stringbuilder_builtin_fcn_objs[] = 
+{
+	Object( do_stringbuilder_append ),
+	Object( do_stringbuilder_appendline ),
+	Object( do_stringbuilder_length ),
+	Object( do_stringbuilder_str ),
+};
+const int num_of_stringbuilder_builtins = sizeof( stringbuilder_builtin_names ) / sizeof( stringbuilder_builtin_names[0] );
+
+
+bool IsStringBuilderBuiltin( const string & name )
+{
+	const string* i = find( stringbuilder_builtin_names, stringbuilder_builtin_names + num_of_stringbuilder_builtins, name );
+	if( i != stringbuilder_builtin_names + num_of_stringbuilder_builtins ) return true;
+	else return false;
+}
+
+NativeFunction GetStringBuilderBuiltin( const string & name )
+{
+	const string* i = find( stringbuilder_builtin_names, stringbuilder_builtin_names + num_of_stringbuilder_builtins, name );
+	if( i == stringbuilder_builtin_names + num_of_stringbuilder_builtins )
+	{
+		NativeFunction nf;
+		nf.p = NULL;
+		return nf;
+	}
+	// compute the index of the function in the look-up table(s)
+	long l = (long)i;
+	l -= (long)&stringbuilder_builtin_names;
+	int idx = l / sizeof( string );
+	if( idx > num_of_stringbuilder_builtins )
+	{
+		NativeFunction nf;
+		nf.p = NULL;
+		return nf;
+	}
+	else
+	{
+		// return the function
+		NativeFunction nf;
+		nf.p = stringbuilder_builtin_fcns[idx];
+		nf.is_method = true;
+		return nf;
+	}
+}
+
+Object* GetStringBuilderBuiltinObjectRef( const string & name )
+{
+	const string* i = find( stringbuilder_builtin_names, stringbuilder_builtin_names + num_of_stringbuilder_builtins, name );
+	if( i == stringbuilder_builtin_names + num_of_stringbuilder_builtins )
+	{
+		return NULL;
+	}
+	// compute the index of the function in the look-up table(s)
+	long l = (long)i;
+	l -= (long)&stringbuilder_builtin_names;
+	int idx = l / sizeof( string );
+	if( idx > num_of_stringbuilder_builtins )
+	{
+		return NULL;
+	}
+	else
+	{
+		// return the function object
+		return &stringbuilder_builtin_fcn_objs[idx];
+	}
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// string builder builtins
+/////////////////////////////////////////////////////////////////////////////
+
+// append the string form of an object to a string builder
+static void AppendObject( StringBuilder* sb, Object* o )
+{
+	// (strings are appended directly, anything else as it would print)
+	if( o->type == obj_string )
+		sb->Append( o->s, strlength( o->s ) );
+	else
+	{
+		ostringstream s;
+		s << *o;
+		sb->Append( s.str() );
+	}
+}
+
+void do_stringbuilder_append( Frame *frame )
+{
+	BuiltinHelper helper( "stringbuilder", "append", frame );
+
+	helper.CheckNumberOfArguments( 2 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_stringbuilder );
+	Object* o = helper.GetLocalN( 1 );
+
+	AppendObject( self->sb, o );
+
+	helper.ReturnVal( Object( obj_null ) );
+}
+
+void do_stringbuilder_appendline( Frame *frame )
+{
+	BuiltinHelper helper( "stringbuilder", "appendline", frame );
+
+	helper.CheckNumberOfArguments( 1, 2 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_stringbuilder );
+
+	if( frame->NumArgsPassed() == 2 )
+		AppendObject( self->sb, helper.GetLocalN( 1 ) );
+	self->sb->Append( "\n", 1 );
+
+	helper.ReturnVal( Object( obj_null ) );
+}
+
+void do_stringbuilder_length( Frame *frame )
+{
+	BuiltinHelper helper( "stringbuilder", "length", frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_stringbuilder );
+
+	helper.ReturnVal( Object( (int64_t)self->sb->size() ) );
+}
+
+void do_stringbuilder_str( Frame *frame )
+{
+	BuiltinHelper helper( "stringbuilder", "str", frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_stringbuilder );
+
+	// the string so far (the builder can keep growing)
+	const char* str = frame->GetParent()->AddString( self->sb->str() );
+
+	helper.ReturnVal( Object( str ) );
+}
+
+
+} // end namespace deva
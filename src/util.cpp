@@ -29,8 +29,16 @@
 #include "util.h"
 #include <cstring>
 #include <stdexcept>
+#include <sstream>
 #include <boost/filesystem.hpp>
 
+#ifdef MS_WINDOWS
+	#include <process.h>
+	#define getpid _getpid
+#else
+	#include <unistd.h>
+#endif
+
 using namespace boost;
 
 
@@ -120,6 +128,26 @@ void split_env_var_paths( const string & var, vector<string> & paths )
 	split( var, env_var_path_seps, paths );
 }
 
+string temp_file_name( const string & path )
+{
+	ostringstream s;
+	s << path << ".tmp." << getpid();
+	return s.str();
+}
+
+bool rename_file( const string & from, const string & to )
+{
+	system::error_code ec;
+	filesystem::rename( filesystem::path( from ), filesystem::path( to ), ec );
+	return !ec;
+}
+
+void remove_file( const string & path )
+{
+	system::error_code ec;
+	filesystem::remove( filesystem::path( path ), ec );
+}
+
 
 // symbol name and string utility functions
 /////////////////////////////////////////////////////////////////////////////
@@ -159,28 +187,69 @@ void split( const string & in, const char* const splitchars, vector<string> & re
 	}
 }
 
+// allocate a string of 'len' bytes, with its length header
+char* allocstr( size_t len )
+{
+	char* p = new char[sizeof( size_t ) + len + 1];
+	*((size_t*)p) = len;
+	char* ret = p + sizeof( size_t );
+	ret[len] = '\0';
+	return ret;
+}
+
+void freestr( const char* s )
+{
+	if( s )
+		delete [] ((const char*)s - sizeof( size_t ));
+}
+
+// compare two strings, including any embedded nulls
+int cmpstr( const char* s1, const char* s2 )
+{
+	size_t len1 = strlength( s1 );
+	size_t len2 = strlength( s2 );
+	int ret = memcmp( s1, s2, len1 < len2 ? len1 : len2 );
+	if( ret != 0 )
+		return ret;
+	if( len1 == len2 )
+		return 0;
+	return len1 < len2 ? -1 : 1;
+}
+
 // allocate and return a copy of a string
 char* copystr( const char* in )
 {
-	char* ret = new char[strlen( in ) + 1];
-	strcpy( ret, in );
+	size_t len = strlen( in );
+	char* ret = allocstr( len );
+	memcpy( ret, in, len );
 	return ret;
 }
 
 // allocate and return a copy of a string
-char* copystr( string in )
+char* copystr( const string & in )
+{
+	char* ret = allocstr( in.length() );
+	memcpy( ret, in.data(), in.length() );
+	return ret;
+}
+
+// allocate and return a copy of a string allocated by allocstr()
+char* dupstr( const char* in )
 {
-	char* ret = new char[in.length() + 1];
-	strcpy( ret, in.c_str() );
+	size_t len = strlength( in );
+	char* ret = allocstr( len );
+	memcpy( ret, in, len );
 	return ret;
 }
 
 // allocate a concatenation of two strings
 char* catstr( const char* s1, const char* s2 )
 {
-	char* ret = new char[strlen( s1 ) + strlen( s2 ) + 1];
-	strcpy( ret, s1 );
-	strcat( ret, s2 );
+	size_t len1 = strlength( s1 );
+	size_t len2 = strlength( s2 );
+	char* ret = allocstr( len1 + len2 );
+	memcpy( ret, s1, len1 );
+	memcpy( ret + len1, s2, len2 );
 	return ret;
 }
 
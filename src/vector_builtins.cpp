@@ -30,6 +30,8 @@
 
 #include "vector_builtins.h"
 #include "builtins_helpers.h"
+#include "number.h"
+#include "numeric.h"
 #include <algorithm>
 #include <sstream>
 
@@ -56,6 +58,8 @@ const string vector_builtin_names[] =
 	string( "count" ),
 	string( "reverse" ),
 	string( "sort" ),
+	string( "sort_by" ),
+	string( "stable_sort" ),
 	string( "map" ),
 	string( "filter" ),
 	string( "reduce" ),
@@ -63,6 +67,19 @@ const string vector_builtin_names[] =
 	string( "all" ),
 	string( "slice" ),
 	string( "join" ),
+	string( "reserve" ),
+	string( "capacity" ),
+	string( "sum" ),
+	string( "mean" ),
+	string( "dot" ),
+	string( "argmin" ),
+	string( "argmax" ),
+	string( "scale" ),
+	string( "add" ),
+	string( "sub" ),
+	string( "mul" ),
+	string( "cumsum" ),
+	string( "clip" ),
 	string( "rewind" ),
 	string( "next" ),
 };
@@ -83,6 +100,8 @@ NativeFunctionPtr vector_builtin_fcns[] =
 	do_vector_count,
 	do_vector_reverse,
 	do_vector_sort,
+	do_vector_sort_by,
+	do_vector_stable_sort,
 	do_vector_map,
 	do_vector_filter,
 	do_vector_reduce,
@@ -90,6 +109,19 @@ NativeFunctionPtr vector_builtin_fcns[] =
 	do_vector_all,
 	do_vector_slice,
 	do_vector_join,
+	do_vector_reserve,
+	do_vector_capacity,
+	do_vector_sum,
+	do_vector_mean,
+	do_vector_dot,
+	do_vector_argmin,
+	do_vector_argmax,
+	do_vector_scale,
+	do_vector_add,
+	do_vector_sub,
+	do_vector_mul,
+	do_vector_cumsum,
+	do_vector_clip,
 	do_vector_rewind,
 	do_vector_next,
 };
@@ -109,6 +141,8 @@ Object vector_builtin_fcn_objs[] =
 	Object( do_vector_count ),
 	Object( do_vector_reverse ),
 	Object( do_vector_sort ),
+	Object( do_vector_sort_by ),
+	Object( do_vector_stable_sort ),
 	Object( do_vector_map ),
 	Object( do_vector_filter ),
 	Object( do_vector_reduce ),
@@ -116,6 +150,19 @@ Object vector_builtin_fcn_objs[] =
 	Object( do_vector_all ),
 	Object( do_vector_slice ),
 	Object( do_vector_join ),
+	Object( do_vector_reserve ),
+	Object( do_vector_capacity ),
+	Object( do_vector_sum ),
+	Object( do_vector_mean ),
+	Object( do_vector_dot ),
+	Object( do_vector_argmin ),
+	Object( do_vector_argmax ),
+	Object( do_vector_scale ),
+	Object( do_vector_add ),
+	Object( do_vector_sub ),
+	Object( do_vector_mul ),
+	Object( do_vector_cumsum ),
+	Object( do_vector_clip ),
 	Object( do_vector_rewind ),
 	Object( do_vector_next ),
 };
@@ -211,7 +258,7 @@ void do_vector_length( Frame *frame )
 
 	int len = (int)po->v->size();
 
-	helper.ReturnVal( Object( (double)len ) );
+	helper.ReturnVal( Object( (int64_t)len ) );
 }
 
 
@@ -243,11 +290,13 @@ void do_vector_concat( Frame *frame )
 	if( self->v->capacity() < self->v->size() + in->v->size() )
 		self->v->reserve( self->v->size() + in->v->size() );
 	// append each element
-	for( Vector::iterator i = in->v->begin(); i != in->v->end(); ++i )
+	size_t num = in->v->size();
+	for( size_t i = 0; i < num; ++i )
 	{
-		self->v->push_back( *i );
+		Object o = in->v->Get( i );
+		self->v->push_back( o );
 		// inc ref each item being added
-		IncRef( *i );
+		IncRef( o );
 	}
 
 	helper.ReturnVal( Object( obj_null ) );
@@ -276,6 +325,14 @@ void do_vector_min( Frame *frame )
 	if( self->v->size() == 0 )
 		throw RuntimeException( "Vector builtin method 'min' called on an empty vector." );
 
+	// packed vectors can be scanned directly
+	if( self->v->IsPacked() )
+	{
+		const vector<double> & nums = self->v->Numbers();
+		helper.ReturnVal( NumberObject( *min_element( nums.begin(), nums.end() ) ) );
+		return;
+	}
+
 	// find the min element
 	MinComparator::type = self->v->operator[]( 0 ).type;
 	Vector::iterator it = min_element( self->v->begin(), self->v->end(), MinComparator() );
@@ -294,6 +351,14 @@ void do_vector_max( Frame *frame )
 	if( self->v->size() == 0 )
 		throw RuntimeException( "Vector builtin method 'max' called on an empty vector." );
 
+	// packed vectors can be scanned directly
+	if( self->v->IsPacked() )
+	{
+		const vector<double> & nums = self->v->Numbers();
+		helper.ReturnVal( NumberObject( *max_element( nums.begin(), nums.end() ) ) );
+		return;
+	}
+
 	// find the max element
 	MinComparator::type = self->v->operator[]( 0 ).type;
 	Vector::iterator it = max_element( self->v->begin(), self->v->end(), MinComparator() );
@@ -312,7 +377,7 @@ void do_vector_pop( Frame *frame )
 	if( self->v->size() == 0 )
 		throw RuntimeException( "Vector builtin method 'pop' called on an empty vector." );
 
-	Object o = self->v->back();
+	Object o = self->v->Get( self->v->size() - 1 );
 	self->v->pop_back();
 
 	helper.ReturnVal( o );
@@ -329,7 +394,7 @@ void do_vector_insert( Frame *frame )
 	helper.ExpectIntegralNumber( pos );
 	Object* val = helper.GetLocalN( 2 );
 
-	size_t i = (size_t)pos->d;
+	size_t i = (size_t)NumToInt( *pos );
 	if( i > self->v->size() )
 		throw RuntimeException( "Position argument greater than vector size in vector built-in method 'insert'." );
 
@@ -350,13 +415,13 @@ void do_vector_remove( Frame *frame )
 
 	helper.ExpectPositiveIntegralNumber( startobj );
 
-	int start = (int)startobj->d;
+	int start = (int)NumToInt( *startobj );
 	int end = -1;
 	if( frame->NumArgsPassed() == 3 )
 	{
 		Object* endobj = helper.GetLocalN( 2 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 
 	size_t sz = self->v->size();
@@ -397,13 +462,13 @@ void do_vector_find( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 2 );
 		helper.ExpectPositiveIntegralNumber( startobj );
-		start = (int)startobj->d;
+		start = (int)NumToInt( *startobj );
 	}
 	if( num_args > 3 )
 	{
 		Object* endobj = helper.GetLocalN( 3 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 
 	size_t sz = self->v->size();
@@ -424,9 +489,9 @@ void do_vector_find( Frame *frame )
 	bool found = false;
 	for( int i = start; i < end; ++i )
 	{
-		if( self->v->operator[]( i ) == *value )
+		if( self->v->Get( i ) == *value )
 		{
-			ret = Object( (double)i );
+			ret = Object( (int64_t)i );
 			found = true;
 			break;
 		}
@@ -455,13 +520,13 @@ void do_vector_rfind( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 2 );
 		helper.ExpectPositiveIntegralNumber( startobj );
-		start = (int)startobj->d;
+		start = (int)NumToInt( *startobj );
 	}
 	if( num_args > 3 )
 	{
 		Object* endobj = helper.GetLocalN( 3 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 
 	size_t sz = self->v->size();
@@ -482,9 +547,9 @@ void do_vector_rfind( Frame *frame )
 	bool found = false;
 	for( int i = end-1; i >= start; --i )
 	{
-		if( self->v->operator[]( i ) == *value )
+		if( self->v->Get( i ) == *value )
 		{
-			ret = Object( (double)i );
+			ret = Object( (int64_t)i );
 			found = true;
 			break;
 		}
@@ -513,13 +578,13 @@ void do_vector_count( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 2 );
 		helper.ExpectPositiveIntegralNumber( startobj );
-		start = (int)startobj->d;
+		start = (int)NumToInt( *startobj );
 	}
 	if( num_args > 3 )
 	{
 		Object* endobj = helper.GetLocalN( 3 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 
 	size_t sz = self->v->size();
@@ -535,9 +600,14 @@ void do_vector_count( Frame *frame )
 		throw RuntimeException( "Invalid arguments in vector built-in method 'count': start is greater than end." );
 
 	// count the value
-	int num = (int)count( self->v->begin() + start, self->v->begin() + end, *value );
+	int num = 0;
+	for( int i = start; i < end; ++i )
+	{
+		if( self->v->Get( i ) == *value )
+			num++;
+	}
 
-	helper.ReturnVal( Object( (double)num ) );
+	helper.ReturnVal( Object( (int64_t)num ) );
 }
 
 void do_vector_reverse( Frame *frame )
@@ -555,13 +625,13 @@ void do_vector_reverse( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 1 );
 		helper.ExpectPositiveIntegralNumber( startobj );
-		start = (int)startobj->d;
+		start = (int)NumToInt( *startobj );
 	}
 	if( num_args > 2 )
 	{
 		Object* endobj = helper.GetLocalN( 2 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 
 	size_t sz = self->v->size();
@@ -576,7 +646,10 @@ void do_vector_reverse( Frame *frame )
 	if( end < start )
 		throw RuntimeException( "Invalid arguments in vector built-in method 'reverse': start is greater than end." );
 
-	reverse( self->v->begin() + start, self->v->begin() + end );
+	if( self->v->IsPacked() )
+		reverse( self->v->MutableNumbers().begin() + start, self->v->MutableNumbers().begin() + end );
+	else
+		reverse( self->v->begin() + start, self->v->begin() + end );
 
 	helper.ReturnVal( Object( obj_null ) );
 }
@@ -624,9 +697,212 @@ public:
 	}
 };
 
-void do_vector_sort( Frame *frame )
+// below this many numbers a comparison sort beats the radix sort's passes
+static const size_t radix_sort_threshold = 256;
+
+// map a double to an unsigned key whose order is the numbers' order: flip
+// every bit of negative numbers, and just the sign bit of positive ones
+static inline qword NumberToSortKey( double d )
+{
+	qword k;
+	memcpy( &k, &d, sizeof( qword ) );
+	const qword sign = 0x8000000000000000ULL;
+	return (k & sign) ? ~k : (k | sign);
+}
+
+static inline double SortKeyToNumber( qword k )
+{
+	const qword sign = 0x8000000000000000ULL;
+	k = (k & sign) ? (k & ~sign) : ~k;
+	double d;
+	memcpy( &d, &k, sizeof( qword ) );
+	return d;
+}
+
+// sort unsigned keys with an LSD radix sort (8 bits per pass, skipping passes
+// where every key has the same digit). stable
+static void RadixSortKeys( vector<qword> & keys )
 {
-	BuiltinHelper helper( "vector", "sort", frame );
+	size_t n = keys.size();
+	vector<qword> tmp( n );
+	for( int shift = 0; shift < 64; shift += 8 )
+	{
+		size_t counts[257] = { 0 };
+		for( size_t i = 0; i < n; ++i )
+			counts[((keys[i] >> shift) & 0xff) + 1]++;
+		if( counts[((keys[0] >> shift) & 0xff) + 1] == n )
+			continue;
+		for( int d = 0; d < 256; ++d )
+			counts[d + 1] += counts[d];
+		for( size_t i = 0; i < n; ++i )
+			tmp[counts[(keys[i] >> shift) & 0xff]++] = keys[i];
+		keys.swap( tmp );
+	}
+}
+
+// sort numbers by radix sorting their bit patterns
+static void RadixSortNumbers( double* nums, size_t n )
+{
+	if( n < radix_sort_threshold )
+	{
+		stable_sort( nums, nums + n );
+		return;
+	}
+	vector<qword> keys( n );
+	for( size_t i = 0; i < n; ++i )
+		keys[i] = NumberToSortKey( nums[i] );
+	RadixSortKeys( keys );
+	for( size_t i = 0; i < n; ++i )
+		nums[i] = SortKeyToNumber( keys[i] );
+}
+
+// sort integers by radix sorting them with the sign bit flipped (which puts
+// the negative ones first)
+static void RadixSortInts( int64_t* nums, size_t n )
+{
+	if( n < radix_sort_threshold )
+	{
+		stable_sort( nums, nums + n );
+		return;
+	}
+	const qword sign = 0x8000000000000000ULL;
+	vector<qword> keys( n );
+	for( size_t i = 0; i < n; ++i )
+		keys[i] = (qword)nums[i] ^ sign;
+	RadixSortKeys( keys );
+	for( size_t i = 0; i < n; ++i )
+		nums[i] = (int64_t)(keys[i] ^ sign);
+}
+
+// the character of a string at 'depth', offset by one so that the end of
+// the string (0) sorts before any character, including an embedded null
+static inline int CharAt( const char* s, size_t depth )
+{
+	return depth < strlength( s ) ? (unsigned char)s[depth] + 1 : 0;
+}
+
+// compare two strings which are known to be equal before 'depth'
+static inline bool StringLessFrom( const char* a, const char* b, size_t depth )
+{
+	size_t len_a = strlength( a ) - depth;
+	size_t len_b = strlength( b ) - depth;
+	int ret = memcmp( a + depth, b + depth, len_a < len_b ? len_a : len_b );
+	return ret < 0 || (ret == 0 && len_a < len_b);
+}
+
+// sort strings with a multikey quicksort (three-way partitioning on one
+// character at a time), so each character is looked at only a few times
+// instead of once per comparison
+static void MultikeyQuicksort( const char** strs, size_t n, size_t depth )
+{
+	while( n > 1 )
+	{
+		// small partitions: insertion sort
+		if( n < 16 )
+		{
+			for( size_t i = 1; i < n; ++i )
+			{
+				const char* s = strs[i];
+				size_t j = i;
+				for( ; j > 0 && StringLessFrom( s, strs[j - 1], depth ); --j )
+					strs[j] = strs[j - 1];
+				strs[j] = s;
+			}
+			return;
+		}
+		// partition around the middle string's character into [less, equal,
+		// greater]
+		swap( strs[0], strs[n / 2] );
+		int pivot = CharAt( strs[0], depth );
+		size_t lt = 0, gt = n - 1, i = 1;
+		while( i <= gt )
+		{
+			int c = CharAt( strs[i], depth );
+			if( c < pivot )
+				swap( strs[lt++], strs[i++] );
+			else if( c > pivot )
+				swap( strs[i], strs[gt--] );
+			else
+				++i;
+		}
+		MultikeyQuicksort( strs, lt, depth );
+		// (strings which have ended are all equal)
+		if( pivot != 0 )
+			MultikeyQuicksort( strs + lt, gt - lt + 1, depth + 1 );
+		strs += gt + 1;
+		n -= gt + 1;
+	}
+}
+
+// sort the range [start, end) of a vector holding only numbers or only
+// strings with the specialized sorts above. returns false (without touching
+// the vector) if the range holds anything else
+static bool SortHomogeneous( Vector* v, size_t start, size_t end )
+{
+	// packed vectors sort their numbers in place
+	if( v->IsPacked() )
+	{
+		if( end > start )
+			RadixSortNumbers( &v->MutableNumbers()[start], end - start );
+		return true;
+	}
+	ObjectType type = v->Get( start ).type;
+	if( type != obj_number && type != obj_string )
+		return false;
+	for( size_t i = start + 1; i < end; ++i )
+	{
+		if( v->Get( i ).type != type )
+			return false;
+	}
+	if( type == obj_number )
+	{
+		// all integers: sort them as integers, and keep them integers
+		bool all_ints = true;
+		for( size_t i = start; i < end && all_ints; ++i )
+			all_ints = v->Get( i ).IsInt();
+		if( all_ints )
+		{
+			vector<int64_t> ints;
+			ints.reserve( end - start );
+			for( size_t i = start; i < end; ++i )
+				ints.push_back( (int64_t)v->Get( i ).i );
+			RadixSortInts( &ints[0], ints.size() );
+			for( size_t i = start; i < end; ++i )
+				v->Set( i, Object( ints[i - start] ) );
+			return true;
+		}
+		// otherwise sort them as doubles, if every integer is one exactly
+		// (integral values go back as integers, as from a packed vector)
+		vector<double> nums;
+		nums.reserve( end - start );
+		for( size_t i = start; i < end; ++i )
+		{
+			const Object & o = v->Get( i );
+			if( o.IsInt() && ((int64_t)o.i > max_packed_int || (int64_t)o.i < -max_packed_int) )
+				return false;
+			nums.push_back( o.Num() );
+		}
+		RadixSortNumbers( &nums[0], nums.size() );
+		for( size_t i = start; i < end; ++i )
+			v->Set( i, NumberObject( nums[i - start] ) );
+	}
+	else
+	{
+		vector<const char*> strs;
+		strs.reserve( end - start );
+		for( size_t i = start; i < end; ++i )
+			strs.push_back( v->Get( i ).s );
+		MultikeyQuicksort( &strs[0], strs.size(), 0 );
+		for( size_t i = start; i < end; ++i )
+			v->Set( i, Object( strs[i - start] ) );
+	}
+	return true;
+}
+
+// sort and stable_sort
+static void SortVector( Frame *frame, const char* name, bool stable )
+{
+	BuiltinHelper helper( "vector", name, frame );
 
 	helper.CheckNumberOfArguments( 1, 5 );
 	int num_args = frame->NumArgsPassed();
@@ -641,13 +917,13 @@ void do_vector_sort( Frame *frame )
 	{
 		Object* startobj = helper.GetLocalN( 1 );
 		helper.ExpectPositiveIntegralNumber( startobj );
-		start = (int)startobj->d;
+		start = (int)NumToInt( *startobj );
 	}
 	if( num_args > 2 )
 	{
 		Object* endobj = helper.GetLocalN( 2 );
 		helper.ExpectIntegralNumber( endobj );
-		end = (int)endobj->d;
+		end = (int)NumToInt( *endobj );
 	}
 	if( num_args > 3 )
 	{
@@ -671,15 +947,25 @@ void do_vector_sort( Frame *frame )
 		end = (int)sz;
 
 	if( (size_t)start >= sz || start < 0 )
-		throw RuntimeException( "Invalid 'start' argument in vector built-in method 'sort'." );
+		throw RuntimeException( boost::format( "Invalid 'start' argument in vector built-in method '%1%'." ) % name );
 	if( (size_t)end > sz || end < 0 )
-		throw RuntimeException( "Invalid 'end' argument in vector built-in method 'sort'." );
+		throw RuntimeException( boost::format( "Invalid 'end' argument in vector built-in method '%1%'." ) % name );
 	if( end < start )
-		throw RuntimeException( "Invalid arguments in vector built-in method 'sort': start is greater than end." );
+		throw RuntimeException( boost::format( "Invalid arguments in vector built-in method '%1%': start is greater than end." ) % name );
 
 	// if we didn't get a 'less-than' predicate function, do a 'normal' sort
+	// (vectors of only numbers or only strings get a specialized sort, which
+	// is stable, anything else a comparison sort)
 	if( !o )
-		sort( self->v->begin() + start, self->v->begin() + end );
+	{
+		if( !SortHomogeneous( self->v, start, end ) )
+		{
+			if( stable )
+				stable_sort( self->v->begin() + start, self->v->begin() + end );
+			else
+				sort( self->v->begin() + start, self->v->begin() + end );
+		}
+	}
 	else
 	{
 		bool is_method = false;
@@ -692,7 +978,7 @@ void do_vector_sort( Frame *frame )
 
 		// a non-method can't have an object passed as argument #4
 		if( !is_method && num_args == 5 )
-			throw RuntimeException( "Too many arguments passed to vector built-in method 'sort' for a predicate argument which is not a method." );
+			throw RuntimeException( boost::format( "Too many arguments passed to vector built-in method '%1%' for a predicate argument which is not a method." ) % name );
 
 		// method predicate
 		if( is_method )
@@ -700,7 +986,10 @@ void do_vector_sort( Frame *frame )
 			// create our sort predicate object
 			sort_predicate pred( o, method_self );
 			// do the sort
-			sort( self->v->begin() + start, self->v->begin() + end, pred );
+			if( stable )
+				stable_sort( self->v->begin() + start, self->v->begin() + end, pred );
+			else
+				sort( self->v->begin() + start, self->v->begin() + end, pred );
 		}
 		// non-method predicate
 		else
@@ -708,30 +997,51 @@ void do_vector_sort( Frame *frame )
 			// create our sort predicate object
 			sort_predicate pred( o );
 			// do the sort
-			sort( self->v->begin() + start, self->v->begin() + end, pred );
+			if( stable )
+				stable_sort( self->v->begin() + start, self->v->begin() + end, pred );
+			else
+				sort( self->v->begin() + start, self->v->begin() + end, pred );
 		}
 	}
 
 	helper.ReturnVal( Object( obj_null ) );
 }
 
+void do_vector_sort( Frame *frame )
+{
+	SortVector( frame, "sort", false );
+}
 
-void do_vector_map( Frame *frame )
+// sort, keeping items which compare equal in their original order
+void do_vector_stable_sort( Frame *frame )
 {
-	BuiltinHelper helper( "vector", "map", frame );
+	SortVector( frame, "stable_sort", true );
+}
+
+// helper class for sorting (key, index) pairs on their keys alone
+class sort_by_key
+{
+public:
+	bool operator() ( const pair<Object, size_t> & i, const pair<Object, size_t> & j ) const
+	{
+		return i.first < j.first;
+	}
+};
+
+// sort by the values returned by a key function, which is called exactly once
+// for each item (rather than once per comparison, as with a 'sort' predicate).
+// the sort is stable: items with equal keys keep their order
+void do_vector_sort_by( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "sort_by", frame );
 
 	helper.CheckNumberOfArguments( 2, 3 );
 	Object* self = helper.GetLocalN( 0 );
 	helper.ExpectType( self, obj_vector );
 
 	Object* o = helper.GetLocalN( 1 );
-
 	helper.ExpectTypes( o, obj_function, obj_native_function );
 
-	// return vector
-	Vector* ret = CreateVector();
-	ret->reserve( self->v->size() );
-
 	bool is_method = false;
 
 	int num_args = frame->NumArgsPassed();
@@ -745,44 +1055,190 @@ void do_vector_map( Frame *frame )
 
 	// a non-method can't have an object passed as argument #2
 	if( !is_method && num_args == 3 )
-		throw RuntimeException( "Too many arguments passed to vector built-in method 'map' for a first argument which is not a method." );
+		throw RuntimeException( "Too many arguments passed to vector built-in method 'sort_by' for a first argument which is not a method." );
 
-	Object* method_self;
+	Object* method_self = NULL;
 	if( num_args == 3 )
 	{
 		method_self = helper.GetLocalN( 2 ); 
 		helper.ExpectTypes( method_self, obj_string, obj_vector, obj_map, obj_class, obj_instance );
 	}
 
-	// walk each item in the vector
-	for( Vector::iterator i = self->v->begin(); i != self->v->end(); ++i )
+	// decorate: call the key function once for each item
+	size_t sz = self->v->size();
+	vector<pair<Object, size_t> > keys;
+	keys.reserve( sz );
+	for( size_t i = 0; i < sz; ++i )
 	{
 		// push the item
-		ex->PushStack( *i );
+		Object item = self->v->Get( i );
+		IncRef( item );
+		ex->PushStack( item );
 		// push 'self', for methods
 		if( has_self )
 		{
-			// push the object ("self") first
 			IncRef( *method_self );
 			ex->PushStack( *method_self );
 		}
-		// call the function given (*must* be a single arg fcn to be used with map
-		// builtin)
+		// call the function given (*must* be a single arg fcn to be used with
+		// sort_by builtin)
 		if( o->type == obj_function )
 			ex->ExecuteFunctionToReturn( o->f, 1, has_self ? true : false );
 		else if( o->type == obj_native_function )
 			ex->ExecuteFunction( o->nf, 1, has_self ? true : false );
+		keys.push_back( make_pair( ex->PopStack(), i ) );
+	}
+
+	// sort natively on the keys (stable_sort is a merge sort)
+	stable_sort( keys.begin(), keys.end(), sort_by_key() );
+
+	// undecorate: put the items in their sorted order (a permutation, so no
+	// ref counts change)
+	vector<Object> items;
+	items.reserve( sz );
+	for( size_t i = 0; i < sz; ++i )
+		items.push_back( self->v->Get( keys[i].second ) );
+	for( size_t i = 0; i < sz; ++i )
+	{
+		self->v->Set( i, items[i] );
+		DecRef( keys[i].first );
+	}
+
+	helper.ReturnVal( Object( obj_null ) );
+}
+
+// calls the function passed to map, filter, reduce, any or all for each item.
+// native functions are called directly, through a single frame for all the
+// items (see Executor::BeginNativeCalls), instead of a new frame per item
+class ItemCaller
+{
+	Object* o;
+	// 'self' for methods (or NULL)
+	Object* method_self;
+	// the frame for native functions
+	Frame* native_frame;
+
+	// set 'self', for methods, returning the index of the first arg
+	size_t SetSelf()
+	{
+		if( !method_self )
+			return 0;
+		IncRef( *method_self );
+		native_frame->SetLocal( 0, *method_self );
+		return 1;
+	}
+	Object Execute( int num_args )
+	{
+		// push 'self', for methods
+		if( method_self )
+		{
+			// push the object ("self") first
+			IncRef( *method_self );
+			ex->PushStack( *method_self );
+		}
+		ex->ExecuteFunctionToReturn( o->f, num_args, method_self ? true : false );
+		return ex->PopStack();
+	}
+
+public:
+	ItemCaller( Object* ob, Object* ms, int num_args ) : o( ob ), method_self( ms ), native_frame( NULL )
+	{
+		if( o->type == obj_native_function )
+			native_frame = ex->BeginNativeCalls( o->nf, ms ? num_args + 1 : num_args );
+	}
+	// call with one or two args, which must have been inc ref'd (the call
+	// takes over the reference). returns the return value
+	Object Call( Object arg )
+	{
+		if( native_frame )
+		{
+			native_frame->SetLocal( SetSelf(), arg );
+			return ex->CallNative( native_frame );
+		}
+		ex->PushStack( arg );
+		return Execute( 1 );
+	}
+	Object Call( Object arg0, Object arg1 )
+	{
+		if( native_frame )
+		{
+			size_t i = SetSelf();
+			native_frame->SetLocal( i, arg0 );
+			native_frame->SetLocal( i + 1, arg1 );
+			return ex->CallNative( native_frame );
+		}
+		ex->PushStack( arg0 );
+		ex->PushStack( arg1 );
+		return Execute( 2 );
+	}
+	// done calling, free the native frame
+	void End()
+	{
+		if( native_frame )
+			ex->EndNativeCalls();
+		native_frame = NULL;
+	}
+};
+
+void do_vector_map( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "map", frame );
+
+	helper.CheckNumberOfArguments( 2, 3 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+
+	Object* o = helper.GetLocalN( 1 );
+
+	helper.ExpectTypes( o, obj_function, obj_native_function );
+
+	// return vector
+	Vector* ret = CreateVector();
+	ret->reserve( self->v->size() );
+
+	bool is_method = false;
+
+	int num_args = frame->NumArgsPassed();
+
+	if( o->type == obj_function )
+		is_method = o->f->IsMethod();
+	else if( o->type == obj_native_function )
+		is_method = o->nf.is_method;
+
+	bool has_self = is_method && num_args == 3;
+
+	// a non-method can't have an object passed as argument #2
+	if( !is_method && num_args == 3 )
+		throw RuntimeException( "Too many arguments passed to vector built-in method 'map' for a first argument which is not a method." );
+
+	Object* method_self = NULL;
+	if( num_args == 3 )
+	{
+		method_self = helper.GetLocalN( 2 ); 
+		helper.ExpectTypes( method_self, obj_string, obj_vector, obj_map, obj_class, obj_instance );
+	}
+
+	// walk each item in the vector
+	// (call the function given, which *must* be a single arg fcn to be used
+	// with map builtin)
+	ItemCaller caller( o, has_self ? method_self : NULL, 1 );
+	size_t sz = self->v->size();
+	for( size_t i = 0; i < sz; ++i )
+	{
+		Object item = self->v->Get( i );
+		IncRef( item );
 		// get the result (return value) and push it onto our return collection
-		Object retval = ex->PopStack();
+		Object retval = caller.Call( item );
 		// if we got a string back, we need to allocate a copy in our parent's
 		// frame so it doesn't get deleted when we return
 		if( retval.type == obj_string )
 		{
-			const char* str = frame->GetParent()->AddString( string( retval.s ) );
+			const char* str = frame->GetParent()->AddString( string( retval.s, strlength( retval.s ) ) );
 			retval.s = const_cast<char*>(str);
 		}
 		ret->push_back( retval );
 	}
+	caller.End();
 
 	helper.ReturnVal( Object( ret ) );
 }
@@ -813,7 +1269,7 @@ void do_vector_filter( Frame *frame )
 		throw RuntimeException( "Too many arguments passed to vector built-in method 'filter' for a first argument which is not a method." );
 
 	// allow methods
-	Object* method_self;
+	Object* method_self = NULL;
 	if( num_args == 3 )
 	{
 		method_self = helper.GetLocalN( 2 ); 
@@ -825,41 +1281,32 @@ void do_vector_filter( Frame *frame )
 	ret->reserve( self->v->size() / 2 );
 
 	// walk each item in the vector
-	for( Vector::iterator i = self->v->begin(); i != self->v->end(); ++i )
+	// (call the function given, which *must* be a single arg fcn to be used
+	// with filter builtin)
+	ItemCaller caller( o, has_self ? method_self : NULL, 1 );
+	size_t sz = self->v->size();
+	for( size_t i = 0; i < sz; ++i )
 	{
-		// push the item
-		IncRef( *i );
-		ex->PushStack( *i );
-		// push 'self', for methods
-		if( has_self )
-		{
-			// push the object ("self") first
-			IncRef( *method_self );
-			ex->PushStack( *method_self );
-		}
-		// call the function given (*must* be a single arg fcn to be used with filter
-		// builtin)
-		if( o->type == obj_function )
-			ex->ExecuteFunctionToReturn( o->f, 1, has_self ? true : false );
-		else if( o->type == obj_native_function )
-			ex->ExecuteFunction( o->nf, 1, has_self ? true : false );
+		Object item = self->v->Get( i );
+		IncRef( item );
 		// get the result (return value), but only add this item to the returned 
 		// vector if the function returned a 'true' value
-		Object retval = ex->PopStack();
+		Object retval = caller.Call( item );
 		if( retval.CoerceToBool() )
 		{
 			// if we got a string, we need to allocate a copy in our parent's
 			// frame so it doesn't get deleted when we return
-			if( i->type == obj_string )
+			if( item.type == obj_string )
 			{
-				const char* str = frame->GetParent()->AddString( string( i->s ) );
-				i->s = const_cast<char*>(str);
+				const char* str = frame->GetParent()->AddString( string( item.s, strlength( item.s ) ) );
+				item.s = const_cast<char*>(str);
 			}
-			IncRef( *i );
-			ret->push_back( *i );
+			IncRef( item );
+			ret->push_back( item );
 		}
 		DecRef( retval );
 	}
+	caller.End();
 	ret->resize( ret->size() );
 
 	helper.ReturnVal( Object( ret ) );
@@ -892,7 +1339,7 @@ void do_vector_reduce( Frame *frame )
 	if( !is_method && num_args == 3 )
 		throw RuntimeException( "Too many arguments passed to vector built-in method 'reduce' for a first argument which is not a method." );
 
-	Object* method_self;
+	Object* method_self = NULL;
 	if( num_args == 3 )
 	{
 		method_self = helper.GetLocalN( 2 ); 
@@ -903,53 +1350,29 @@ void do_vector_reduce( Frame *frame )
 	if( sz < 2 )
 		throw RuntimeException( "A vector on which the built-in method 'reduce' is called must contain at least two items." );
 
+	// (the function given *must* be a double arg fcn to be used with reduce
+	// builtin)
+	ItemCaller caller( o, has_self ? method_self : NULL, 2 );
 	// first iteration uses the last two items in the vector
-	ex->PushStack( self->v->operator[]( sz-2 ) );
-	ex->PushStack( self->v->operator[]( sz-1 ) );
-	// push 'self', for methods
-	if( has_self )
-	{
-		// push the object ("self") first
-		IncRef( *method_self );
-		ex->PushStack( *method_self );
-	}
-	// call the function
-	if( o->type == obj_function )
-		ex->ExecuteFunctionToReturn( o->f, 2, has_self ? true : false );
-	else if( o->type == obj_native_function )
-		ex->ExecuteFunction( o->nf, 2, has_self ? true : false );
-	Object retval = ex->PopStack();
+	Object item0 = self->v->Get( sz-2 );
+	Object item1 = self->v->Get( sz-1 );
+	IncRef( item0 );
+	IncRef( item1 );
+	Object retval = caller.Call( item0, item1 );
 	// walk the rest of the items in the vector
-	if( self->v->size() > 2 )
+	for( int i = (int)sz-3; i >= 0; i-- )
 	{
-		for( int i = (int)sz-3; i >= 0; i-- )
-		{
-			// push the item
-			ex->PushStack( self->v->operator[]( i ) );
-			// use the retval from the previous iteration as the first arg to the fcn
-			ex->PushStack( retval );
-			// push 'self', for methods
-			if( has_self )
-			{
-				// push the object ("self") first
-				IncRef( *method_self );
-				ex->PushStack( *method_self );
-			}
-			// call the function given (*must* be a double arg fcn to be used with
-			// reduce builtin)
-			if( o->type == obj_function )
-				ex->ExecuteFunctionToReturn( o->f, 2, has_self ? true : false );
-			else if( o->type == obj_native_function )
-				ex->ExecuteFunction( o->nf, 2, has_self ? true : false );
-			// get the result (return value) and push it onto our return collection
-			retval = ex->PopStack();
-		}
+		Object item = self->v->Get( i );
+		IncRef( item );
+		// use the retval from the previous iteration as the second arg to the fcn
+		retval = caller.Call( item, retval );
 	}
+	caller.End();
 
 	// if we're returning a string, ensure memory will exist in frame returned to
 	if( retval.type == obj_string )
 	{
-		const char* str = frame->GetParent()->AddString( string( retval.s ) );
+		const char* str = frame->GetParent()->AddString( string( retval.s, strlength( retval.s ) ) );
 		retval.s = const_cast<char*>(str);
 	}
 
@@ -983,7 +1406,7 @@ void do_vector_any( Frame *frame )
 	if( !is_method && num_args == 3 )
 		throw RuntimeException( "Too many arguments passed to vector built-in method 'any' for a first argument which is not a method." );
 
-	Object* method_self;
+	Object* method_self = NULL;
 	if( num_args == 3 )
 	{
 		method_self = helper.GetLocalN( 2 ); 
@@ -993,32 +1416,26 @@ void do_vector_any( Frame *frame )
 	bool value = false;
 
 	// walk each item in the vector
-	for( Vector::iterator i = self->v->begin(); i != self->v->end(); ++i )
+	// (call the function given, which *must* be a single arg fcn to be used
+	// with 'any' builtin)
+	ItemCaller caller( o, has_self ? method_self : NULL, 1 );
+	size_t sz = self->v->size();
+	for( size_t i = 0; i < sz; ++i )
 	{
-		// push the item
-		ex->PushStack( *i );
-		// push 'self', for methods
-		if( has_self )
-		{
-			// push the object ("self") first
-			IncRef( *method_self );
-			ex->PushStack( *method_self );
-		}
-		// call the function given (*must* be a single arg fcn to be used with
-		// 'any' builtin)
-		if( o->type == obj_function )
-			ex->ExecuteFunctionToReturn( o->f, 1, has_self ? true : false );
-		else if( o->type == obj_native_function )
-			ex->ExecuteFunction( o->nf, 1, has_self ? true : false );
+		Object item = self->v->Get( i );
+		IncRef( item );
 		// get the result (return value)
-		Object retval = ex->PopStack();
+		Object retval = caller.Call( item );
+		bool done = retval.CoerceToBool();
+		DecRef( retval );
 		// if it evaluates to true, bail
-		if( retval.CoerceToBool() )
+		if( done )
 		{
 			value = true;
 			break;
 		}
 	}
+	caller.End();
 
 	helper.ReturnVal( Object( value ) );
 }
@@ -1050,7 +1467,7 @@ void do_vector_all( Frame *frame )
 	if( !is_method && num_args == 3 )
 		throw RuntimeException( "Too many arguments passed to vector built-in method 'all' for a first argument which is not a method." );
 
-	Object* method_self;
+	Object* method_self = NULL;
 	if( num_args == 3 )
 	{
 		method_self = helper.GetLocalN( 2 ); 
@@ -1060,48 +1477,31 @@ void do_vector_all( Frame *frame )
 	bool value = true;
 
 	// walk each item in the vector
-	for( Vector::iterator i = self->v->begin(); i != self->v->end(); ++i )
+	// (call the function given, which *must* be a single arg fcn to be used
+	// with 'all' builtin)
+	ItemCaller caller( o, has_self ? method_self : NULL, 1 );
+	size_t sz = self->v->size();
+	for( size_t i = 0; i < sz; ++i )
 	{
-		// push the item
-		ex->PushStack( *i );
-		// push 'self', for methods
-		if( has_self )
-		{
-			// push the object ("self") first
-			IncRef( *method_self );
-			ex->PushStack( *method_self );
-		}
-		// call the function given (*must* be a single arg fcn to be used with 'all'
-		// builtin)
-		if( o->type == obj_function )
-			ex->ExecuteFunctionToReturn( o->f, 1, has_self ? true : false );
-		else if( o->type == obj_native_function )
-			ex->ExecuteFunction( o->nf, 1, has_self ? true : false );
+		Object item = self->v->Get( i );
+		IncRef( item );
 		// get the result (return value)
-		Object retval = ex->PopStack();
+		Object retval = caller.Call( item );
+		bool done = !retval.CoerceToBool();
+		DecRef( retval );
 		// if it evaluates to false, bail
-		if( !retval.CoerceToBool() )
+		if( done )
 		{
 			value = false;
 			break;
 		}
 	}
+	caller.End();
 
 	helper.ReturnVal( Object( value ) );
 }
 
 
-// helper for slicing in steps
-static size_t s_step = 1;
-static size_t s_i = 0;
-bool if_step( Object )
-{
-	if( s_i++ % s_step == 0 )
-		return false;
-	else
-		return true;
-}
-
 void do_vector_slice( Frame *frame )
 {
 	BuiltinHelper helper( "vector", "slice", frame );
@@ -1117,17 +1517,17 @@ void do_vector_slice( Frame *frame )
 
 	Object* startobj = helper.GetLocalN( 1 );
 	helper.ExpectPositiveIntegralNumber( startobj );
-	start = (int)startobj->d;
+	start = (int)NumToInt( *startobj );
 
 	Object* endobj = helper.GetLocalN( 2 );
 	helper.ExpectIntegralNumber( endobj );
-	end = (int)endobj->d;
+	end = (int)NumToInt( *endobj );
 	
 	if( num_args > 3 )
 	{
 		Object* stepobj = helper.GetLocalN( 3 );
 		helper.ExpectIntegralNumber( stepobj );
-		step = (int)stepobj->d;
+		step = (int)NumToInt( *stepobj );
 	}
 
 	size_t sz = self->v->size();
@@ -1141,28 +1541,12 @@ void do_vector_slice( Frame *frame )
 		throw RuntimeException( "Invalid 'end' argument in vector built-in method 'slice'." );
 	if( end < start )
 		throw RuntimeException( "Invalid arguments in vector built-in method 'slice': start is greater than end." );
-	if( step < 0 )
+	if( step < 1 )
 		throw RuntimeException( "Invalid 'step' argument in vector built-in method 'slice': must be a positive integral number." );
 
 	// slice the vector
-	Object ret;
-	// if 'step' is '1' (the default)
-	if( step == 1 )
-	{
-		// create a new vector object that is a copy of the 'sub-vector' we're
-		// looking for
-		Vector* v = CreateVector( *(self->v), start, end );
-		ret = Object( v );
-	}
-	// otherwise the vector class doesn't help us, have to do it manually
-	else
-	{
-		Vector* v = CreateVector();
-		s_i = 0;
-		s_step = step;
-		remove_copy_if( self->v->begin() + start, self->v->begin() + end, back_inserter( *v ), if_step );
-		ret = Object( v );
-	}
+	// (large slices are views sharing the vector's items)
+	Object ret = Object( CreateVector( *(self->v), start, end, step ) );
 
 	helper.ReturnVal( ret );
 }
@@ -1186,21 +1570,263 @@ void do_vector_join( Frame *frame )
 
 	// build the return string
 	string ret;
-	for( Vector::iterator i = self->v->begin(); i != self->v->end(); ++i )
+	size_t num = self->v->size();
+	for( size_t i = 0; i < num; ++i )
 	{
 		ostringstream s;
-		if( i != self->v->begin() )
+		if( i != 0 )
 			s << separator;
-		s << *i;
+		s << self->v->Get( i );
 		ret += s.str();
 	}
 	// add the string to the parent frame
-	char* s = copystr( ret.c_str() );
+	char* s = copystr( ret );
 	frame->GetParent()->AddString( s );
 
 	helper.ReturnVal( Object( s ) );
 }
 
+void do_vector_reserve( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "reserve", frame );
+
+	helper.CheckNumberOfArguments( 2 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+	Object* nobj = helper.GetLocalN( 1 );
+	helper.ExpectPositiveIntegralNumber( nobj );
+
+	// (never shrinks the vector's storage)
+	self->v->reserve( (size_t)NumToInt( *nobj ) );
+
+	helper.ReturnVal( Object( obj_null ) );
+}
+
+void do_vector_capacity( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "capacity", frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+
+	helper.ReturnVal( Object( (int64_t)self->v->capacity() ) );
+}
+
+// numeric methods
+// (these work on the vector's numbers as a contiguous array of doubles, see
+// numeric.h)
+
+void do_vector_sum( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "sum", frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+
+	vector<double> tmp;
+	const double* nums = helper.GetNumbers( self, tmp );
+
+	helper.ReturnVal( NumberObject( SumNumbers( nums, self->v->size() ) ) );
+}
+
+void do_vector_mean( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "mean", frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+
+	size_t sz = self->v->size();
+	if( sz == 0 )
+		throw RuntimeException( "Vector builtin method 'mean' called on an empty vector." );
+
+	vector<double> tmp;
+	const double* nums = helper.GetNumbers( self, tmp );
+
+	helper.ReturnVal( NumberObject( SumNumbers( nums, sz ) / (double)sz ) );
+}
+
+void do_vector_dot( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "dot", frame );
+
+	helper.CheckNumberOfArguments( 2 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+	Object* other = helper.GetLocalN( 1 );
+	helper.ExpectType( other, obj_vector );
+
+	size_t sz = self->v->size();
+	if( other->v->size() != sz )
+		throw RuntimeException( "Vectors passed to vector built-in method 'dot' must be the same length." );
+
+	vector<double> tmp, tmp_other;
+	const double* nums = helper.GetNumbers( self, tmp );
+	const double* nums_other = helper.GetNumbers( other, tmp_other );
+
+	helper.ReturnVal( NumberObject( DotNumbers( nums, nums_other, sz ) ) );
+}
+
+// argmin and argmax
+static void ExtremeIndex( Frame *frame, const char* name, bool max )
+{
+	BuiltinHelper helper( "vector", name, frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+
+	size_t sz = self->v->size();
+	if( sz == 0 )
+		throw RuntimeException( boost::format( "Vector builtin method '%1%' called on an empty vector." ) % name );
+
+	vector<double> tmp;
+	const double* nums = helper.GetNumbers( self, tmp );
+
+	helper.ReturnVal( Object( (int64_t)(max ? MaxIndex( nums, sz ) : MinIndex( nums, sz )) ) );
+}
+
+// index of the smallest number
+void do_vector_argmin( Frame *frame )
+{
+	ExtremeIndex( frame, "argmin", false );
+}
+
+// index of the largest number
+void do_vector_argmax( Frame *frame )
+{
+	ExtremeIndex( frame, "argmax", true );
+}
+
+void do_vector_scale( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "scale", frame );
+
+	helper.CheckNumberOfArguments( 2 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+	Object* k = helper.GetLocalN( 1 );
+	helper.ExpectType( k, obj_number );
+
+	size_t sz = self->v->size();
+	vector<double> tmp;
+	const double* nums = helper.GetNumbers( self, tmp );
+	vector<double> ret( sz );
+	if( sz )
+		MulScalar( &ret[0], nums, k->Num(), sz );
+
+	helper.ReturnVal( Object( CreateNumberVector( ret ) ) );
+}
+
+// add, sub and mul: element-wise with another vector (of the same length) or
+// with a number
+static void ElementWise( Frame *frame, const char* name, char op )
+{
+	BuiltinHelper helper( "vector", name, frame );
+
+	helper.CheckNumberOfArguments( 2 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+	Object* rhs = helper.GetLocalN( 1 );
+	helper.ExpectTypes( rhs, obj_number, obj_vector );
+
+	size_t sz = self->v->size();
+	vector<double> tmp;
+	const double* nums = helper.GetNumbers( self, tmp );
+	vector<double> ret( sz );
+	if( rhs->type == obj_vector )
+	{
+		if( rhs->v->size() != sz )
+			throw RuntimeException( boost::format( "Vectors passed to vector built-in method '%1%' must be the same length." ) % name );
+		vector<double> tmp_rhs;
+		const double* nums_rhs = helper.GetNumbers( rhs, tmp_rhs );
+		if( sz )
+		{
+			if( op == '+' )
+				AddNumbers( &ret[0], nums, nums_rhs, sz );
+			else if( op == '-' )
+				SubNumbers( &ret[0], nums, nums_rhs, sz );
+			else
+				MulNumbers( &ret[0], nums, nums_rhs, sz );
+		}
+	}
+	else if( sz )
+	{
+		double k = rhs->Num();
+		if( op == '+' )
+			AddScalar( &ret[0], nums, k, sz );
+		else if( op == '-' )
+			AddScalar( &ret[0], nums, -k, sz );
+		else
+			MulScalar( &ret[0], nums, k, sz );
+	}
+
+	helper.ReturnVal( Object( CreateNumberVector( ret ) ) );
+}
+
+void do_vector_add( Frame *frame )
+{
+	ElementWise( frame, "add", '+' );
+}
+
+void do_vector_sub( Frame *frame )
+{
+	ElementWise( frame, "sub", '-' );
+}
+
+void do_vector_mul( Frame *frame )
+{
+	ElementWise( frame, "mul", '*' );
+}
+
+// running sum
+void do_vector_cumsum( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "cumsum", frame );
+
+	helper.CheckNumberOfArguments( 1 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+
+	size_t sz = self->v->size();
+	vector<double> tmp;
+	const double* nums = helper.GetNumbers( self, tmp );
+	vector<double> ret( sz );
+	if( sz )
+		CumSum( &ret[0], nums, sz );
+
+	helper.ReturnVal( Object( CreateNumberVector( ret ) ) );
+}
+
+// limit each number to the range [lo, hi]
+void do_vector_clip( Frame *frame )
+{
+	BuiltinHelper helper( "vector", "clip", frame );
+
+	helper.CheckNumberOfArguments( 3 );
+	Object* self = helper.GetLocalN( 0 );
+	helper.ExpectType( self, obj_vector );
+	Object* lo = helper.GetLocalN( 1 );
+	helper.ExpectType( lo, obj_number );
+	Object* hi = helper.GetLocalN( 2 );
+	helper.ExpectType( hi, obj_number );
+
+	if( lo->Num() > hi->Num() )
+		throw RuntimeException( "Invalid arguments in vector built-in method 'clip': the lower limit is greater than the upper limit." );
+
+	size_t sz = self->v->size();
+	vector<double> tmp;
+	const double* nums = helper.GetNumbers( self, tmp );
+	vector<double> ret( sz );
+	if( sz )
+		ClipNumbers( &ret[0], nums, lo->Num(), hi->Num(), sz );
+
+	helper.ReturnVal( Object( CreateNumberVector( ret ) ) );
+}
+
 // 'enumerable interface'
 void do_vector_rewind( Frame *frame )
 {
@@ -1236,7 +1862,7 @@ void do_vector_next( Frame *frame )
 	// if we have an object, return true and the object
 	if( !last )
 	{
-		Object out = po->v->operator[]( po->v->index );
+		Object out = po->v->Get( po->v->index );
 		IncRef( out );
 		ret->push_back( Object( true ) );
 		ret->push_back( out );